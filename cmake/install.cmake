@@ -71,6 +71,7 @@ if (TFM_PARTITION_INTERNAL_TRUSTED_STORAGE)
                         ${INTERFACE_INC_DIR}/psa/storage_common.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_its_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_its_txn_api.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -86,6 +87,8 @@ if (TFM_PARTITION_CRYPTO)
                         ${INTERFACE_INC_DIR}/psa/crypto_values.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_crypto_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_crypto_batch_api.h
+                        ${INTERFACE_INC_DIR}/tfm_crypto_client_api.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
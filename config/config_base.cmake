@@ -84,6 +84,8 @@ set(CONFIG_TFM_STACK_WATERMARKS         OFF         CACHE BOOL      "Whether to
 ############################ Platform ##########################################
 
 set(NUM_MAILBOX_QUEUE_SLOT              1           CACHE BOOL      "Number of mailbox queue slots")
+set(TFM_MAILBOX_RING                    OFF         CACHE BOOL      "Use lock-free request and reply rings instead of slot bitmaps in mailbox queue")
+set(TFM_MAILBOX_INLINE_PAYLOAD_SIZE     0           CACHE STRING    "Maximum size of PSA client call payload carried inline in a mailbox queue slot. 0 to disable")
 set(TFM_PLAT_SPECIFIC_MULTI_CORE_COMM   OFF         CACHE BOOL      "Whether to use a platform specific inter-core communication instead of mailbox in dual-cpu topology")
 
 set(DEBUG_AUTHENTICATION                CHIP_DEFAULT CACHE STRING   "Debug authentication setting. [CHIP_DEFAULT, NONE, NS_ONLY, FULL")
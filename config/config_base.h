@@ -48,6 +48,53 @@
 #define CRYPTO_CONC_OPER_NUM                   8
 #endif
 
+/* Allocate the operations from a dedicated pool for each operation type */
+#ifndef CRYPTO_OPER_POOL_PER_TYPE
+#define CRYPTO_OPER_POOL_PER_TYPE              0
+#endif
+
+/* The max number of concurrent operations of each type when allocated per type */
+#ifndef CRYPTO_CIPHER_OPER_NUM
+#define CRYPTO_CIPHER_OPER_NUM                 CRYPTO_CONC_OPER_NUM
+#endif
+
+#ifndef CRYPTO_MAC_OPER_NUM
+#define CRYPTO_MAC_OPER_NUM                    CRYPTO_CONC_OPER_NUM
+#endif
+
+#ifndef CRYPTO_HASH_OPER_NUM
+#define CRYPTO_HASH_OPER_NUM                   CRYPTO_CONC_OPER_NUM
+#endif
+
+#ifndef CRYPTO_KEY_DERIVATION_OPER_NUM
+#define CRYPTO_KEY_DERIVATION_OPER_NUM         CRYPTO_CONC_OPER_NUM
+#endif
+
+#ifndef CRYPTO_AEAD_OPER_NUM
+#define CRYPTO_AEAD_OPER_NUM                   CRYPTO_CONC_OPER_NUM
+#endif
+
+/* The max number of concurrent operations held by a single client, 0 for no limit */
+#ifndef CRYPTO_CONC_OPER_PER_OWNER_NUM
+#define CRYPTO_CONC_OPER_PER_OWNER_NUM         0
+#endif
+
+/* The number of persistent keys cached by Crypto, 0 to disable the cache */
+#ifndef CRYPTO_KEY_CACHE_SLOT_NUM
+#define CRYPTO_KEY_CACHE_SLOT_NUM              0
+#endif
+
+/* The max size of a persistent key stored in the Crypto key cache */
+#ifndef CRYPTO_KEY_CACHE_ENTRY_SIZE
+#define CRYPTO_KEY_CACHE_ENTRY_SIZE            128
+#endif
+
+/* The persistent keys pinned in the Crypto key cache from boot, as a comma
+ * separated list of TFM_CRYPTO_KEY_CACHE_UID(owner, key_id). Not defined by
+ * default, to be set in the project config header.
+ */
+/* #define CRYPTO_KEY_CACHE_PINNED_UIDS */
+
 /* Enable PSA Crypto random number generator module */
 #ifndef CRYPTO_RNG_MODULE_ENABLED
 #define CRYPTO_RNG_MODULE_ENABLED              1
@@ -145,6 +192,11 @@
 #define ATTEST_STACK_SIZE                      0x700
 #endif
 
+/* Size of the buffer holding the pre-encoded static claims, 0 to disable */
+#ifndef ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE
+#define ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE     0x400
+#endif
+
 /* Set the initial attestation token profile */
 #if (!ATTEST_TOKEN_PROFILE_PSA_IOT_1) && \
     (!ATTEST_TOKEN_PROFILE_PSA_2_0_0) && \
@@ -187,6 +239,36 @@
 #define ITS_NUM_ASSETS                         10
 #endif
 
+/* Keep an index of the filesystem metadata in RAM to look up files in constant time */
+#ifndef ITS_RAM_FILE_INDEX
+#define ITS_RAM_FILE_INDEX                     0
+#endif
+
+/* Append to existing files in place and commit their new size in a journal */
+#ifndef ITS_JOURNALED_WRITE
+#define ITS_JOURNALED_WRITE                    0
+#endif
+
+/* The number of journal records in the metadata block */
+#ifndef ITS_JOURNAL_NUM_RECORDS
+#define ITS_JOURNAL_NUM_RECORDS                16
+#endif
+
+/* Support transactions which commit several ITS changes atomically */
+#ifndef ITS_TRANSACTION
+#define ITS_TRANSACTION                        0
+#endif
+
+/* The maximum number of file changes staged by an ITS transaction */
+#ifndef ITS_TRANSACTION_MAX_FILES
+#define ITS_TRANSACTION_MAX_FILES              ITS_NUM_ASSETS
+#endif
+
+/* Count the bytes programmed and the blocks erased by the filesystem */
+#ifndef ITS_FLASH_FS_STATS
+#define ITS_FLASH_FS_STATS                     0
+#endif
+
 /* The stack size of the Internal Trusted Storage Secure Partition */
 #ifndef ITS_STACK_SIZE
 #define ITS_STACK_SIZE                         0x720
@@ -202,6 +284,11 @@
 #define TFM_ITS_ENC_NONCE_LENGTH               12
 #endif
 
+/* Encrypt and decrypt ITS files in chunks of ITS_BUF_SIZE bytes */
+#ifndef ITS_ENCRYPTION_STREAMING
+#define ITS_ENCRYPTION_STREAMING               0
+#endif
+
 /* PS Partition Configs */
 
 /* Create flash FS if it doesn't exist for Protected Storage partition */
@@ -234,6 +321,26 @@
 #define PS_NUM_ASSETS                          10
 #endif
 
+/* Keep an index of the object table in RAM to look up objects in constant time */
+#ifndef PS_OBJ_TABLE_INDEX
+#define PS_OBJ_TABLE_INDEX                     0
+#endif
+
+/* Authenticate the object table through a hash tree of its entries */
+#ifndef PS_OBJ_TABLE_HASH_TREE
+#define PS_OBJ_TABLE_HASH_TREE                 0
+#endif
+
+/* Encrypt and authenticate each chunk of the PS objects separately */
+#ifndef PS_CHUNKED_OBJECTS
+#define PS_CHUNKED_OBJECTS                     0
+#endif
+
+/* The size of the chunks of the PS objects */
+#ifndef PS_OBJECT_CHUNK_SIZE
+#define PS_OBJECT_CHUNK_SIZE                   256
+#endif
+
 /* The stack size of the Protected Storage Secure Partition */
 #ifndef PS_STACK_SIZE
 #define PS_STACK_SIZE                          0x700
@@ -258,6 +365,21 @@
 #define CONFIG_TFM_SCHEDULE_WHEN_NS_INTERRUPTED 0
 #endif
 
+/* Number of mailbox replies batched into one notification to the NSPE */
+#ifndef CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM
+#define CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM      1
+#endif
+
+/* Maximum time a mailbox reply notification is deferred. 0 to disable */
+#ifndef CONFIG_TFM_MAILBOX_REPLY_TIMEOUT
+#define CONFIG_TFM_MAILBOX_REPLY_TIMEOUT        0
+#endif
+
+/* Number of client memory ranges cached after being validated by psa_call() */
+#ifndef CONFIG_TFM_MEM_CHECK_CACHE_NUM
+#define CONFIG_TFM_MEM_CHECK_CACHE_NUM          0
+#endif
+
 /* Enable OTP/NV_COUNTERS emulation in RAM */
 #ifndef OTP_NV_COUNTERS_RAM_EMULATION
 #define OTP_NV_COUNTERS_RAM_EMULATION           0
@@ -23,6 +23,17 @@
 #include "psa/client.h"
 #include "tfm_mailbox_config.h"
 
+#if TFM_MAILBOX_RING && !defined(mailbox_ring_barrier)
+#include "cmsis_compiler.h"
+
+/*
+ * Memory barrier to order the accesses to a ring entry and to the ring index.
+ * It can be overridden to run the mailbox rings on a host, for example by
+ * __atomic_thread_fence(__ATOMIC_SEQ_CST).
+ */
+#define mailbox_ring_barrier()              __DMB()
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +44,7 @@ extern "C" {
 #define MAILBOX_PSA_CONNECT                 (0x3)
 #define MAILBOX_PSA_CALL                    (0x4)
 #define MAILBOX_PSA_CLOSE                   (0x5)
+#define MAILBOX_PSA_CALL_INLINE             (0x6)
 
 /* Return code of mailbox APIs */
 #define MAILBOX_SUCCESS                     (0)
@@ -71,6 +83,22 @@ struct psa_client_params_t {
         struct {
             psa_handle_t    handle;
         } psa_close_params;
+
+        /*
+         * The payload of vectors is carried in the mailbox queue slot. The
+         * input data is followed by the output buffers in the payload.
+         */
+        struct {
+            psa_handle_t    handle;
+            int32_t         type;
+            uint8_t         in_len;
+            uint8_t         out_len;
+            uint16_t        io_size[PSA_MAX_IOVEC]; /* Sizes of invecs then
+                                                     * outvecs. SPE updates the
+                                                     * outvec sizes to the
+                                                     * written lengths.
+                                                     */
+        } psa_call_inline_params;
     };
 };
 
@@ -116,12 +144,100 @@ struct mailbox_reply_t {
 struct ns_mailbox_slot_t {
     struct mailbox_msg_t   msg;
     struct mailbox_reply_t reply;
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    uint8_t                payload[TFM_MAILBOX_INLINE_PAYLOAD_SIZE];
+                                            /* Inline input data from NSPE and
+                                             * output data from SPE
+                                             */
+#endif
 };
 
 typedef uint32_t   mailbox_queue_status_t;
 
+#if TFM_MAILBOX_RING
+/*
+ * Single-producer single-consumer ring of mailbox queue slot indices.
+ * head is only written by the producer and tail is only written by the
+ * consumer. Both are free-running counters. The ring never overflows as each
+ * slot is held by at most one ring at a time.
+ */
+struct mailbox_ring_t {
+    volatile uint32_t        head;              /* Count of produced entries */
+    volatile uint32_t        tail;              /* Count of consumed entries */
+    volatile uint8_t         entries[NUM_MAILBOX_QUEUE_SLOT];
+};
+
+/**
+ * \brief Produce a slot index into a mailbox ring.
+ *
+ * \note The caller shall be the only producer of the ring.
+ *
+ * \param[in] ring              The mailbox ring.
+ * \param[in] idx               The mailbox queue slot index.
+ *
+ * \retval MAILBOX_SUCCESS      The slot index is produced.
+ * \retval MAILBOX_QUEUE_FULL   The ring is full.
+ */
+static inline int32_t mailbox_ring_push(struct mailbox_ring_t *ring,
+                                        uint8_t idx)
+{
+    uint32_t head = ring->head;
+
+    if ((head - ring->tail) >= NUM_MAILBOX_QUEUE_SLOT) {
+        return MAILBOX_QUEUE_FULL;
+    }
+
+    ring->entries[head & (NUM_MAILBOX_QUEUE_SLOT - 1)] = idx;
+
+    /* Publish the entry before the consumer can observe the new head */
+    mailbox_ring_barrier();
+    ring->head = head + 1;
+
+    return MAILBOX_SUCCESS;
+}
+
+/**
+ * \brief Consume a slot index from a mailbox ring.
+ *
+ * \note The caller shall be the only consumer of the ring.
+ *
+ * \param[in] ring              The mailbox ring.
+ * \param[out] idx              The consumed mailbox queue slot index.
+ *
+ * \retval true                 A slot index is consumed.
+ * \retval false                The ring is empty.
+ */
+static inline bool mailbox_ring_pop(struct mailbox_ring_t *ring, uint8_t *idx)
+{
+    uint32_t tail = ring->tail;
+
+    if (tail == ring->head) {
+        return false;
+    }
+
+    /* Read the entry only after the new head is observed */
+    mailbox_ring_barrier();
+    *idx = ring->entries[tail & (NUM_MAILBOX_QUEUE_SLOT - 1)];
+
+    /* Complete the entry read before the producer can reuse the entry */
+    mailbox_ring_barrier();
+    ring->tail = tail + 1;
+
+    return true;
+}
+#endif /* TFM_MAILBOX_RING */
+
 /* NSPE mailbox queue */
 struct ns_mailbox_queue_t {
+#if TFM_MAILBOX_RING
+    struct mailbox_ring_t    req_ring;          /* Slots pending for SPE
+                                                 * handling, produced by NSPE
+                                                 */
+    struct mailbox_ring_t    reply_ring;        /* Slots containing PSA client
+                                                 * call return result, produced
+                                                 * by SPE
+                                                 */
+#else
     mailbox_queue_status_t   empty_slots;       /* Bitmask of empty slots */
     mailbox_queue_status_t   pend_slots;        /* Bitmask of slots pending
                                                  * for SPE handling
@@ -130,6 +246,7 @@ struct ns_mailbox_queue_t {
                                                  * containing PSA client call
                                                  * return result
                                                  */
+#endif
 
     struct ns_mailbox_slot_t queue[NUM_MAILBOX_QUEUE_SLOT];
 
@@ -12,6 +12,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "tfm_mailbox.h"
 
@@ -23,6 +24,14 @@ extern "C" {
 #error "NUM_MAILBOX_QUEUE_SLOT should be set to 1 for NS bare metal environment"
 #endif
 
+#if TFM_MAILBOX_RING && defined(TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD)
+#error "TFM_MAILBOX_RING doesn't support TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD yet"
+#endif
+
+#if TFM_MAILBOX_RING && defined(TFM_MULTI_CORE_TEST)
+#error "TFM_MAILBOX_RING doesn't support the NSPE mailbox statistics yet"
+#endif
+
 /**
  * \brief NSPE mailbox initialization
  *
@@ -54,6 +63,82 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
                                    int32_t *reply);
 
 #ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD
+struct tfm_ns_mailbox_async_call_t;
+
+/**
+ * \brief Completion callback of an asynchronous PSA client call.
+ *
+ * \note It is invoked inside NS mailbox notification IRQ handler and
+ *       therefore shall only perform the operations allowed in IRQ handler.
+ *       It is invoked by NS mailbox thread instead if the call fails to be
+ *       submitted to SPE.
+ *
+ * \param[in] call              The completed asynchronous PSA client call.
+ */
+typedef void (*tfm_ns_mailbox_async_cb_t)(
+                                    struct tfm_ns_mailbox_async_call_t *call);
+
+/*
+ * An asynchronous PSA client call. It is allocated by the NS client and shall
+ * stay valid, together with the parameters and the vectors it refers to, until
+ * the call is completed.
+ */
+struct tfm_ns_mailbox_async_call_t {
+    uint32_t                         call_type; /* PSA client call type */
+    const struct psa_client_params_t *params;   /* Parameters used for PSA
+                                                 * client call
+                                                 */
+    int32_t                          client_id; /* Optional client ID of the
+                                                 * non-secure caller.
+                                                 */
+    tfm_ns_mailbox_async_cb_t        callback;  /* Optional completion
+                                                 * callback
+                                                 */
+    void                             *cb_data;  /* Private data of the NS
+                                                 * client for callback
+                                                 */
+
+    /* Written by NS mailbox */
+    int32_t                          reply;     /* PSA client call result */
+    uint8_t                          woken_flag; /* Indicate that the call is
+                                                  * completed
+                                                  */
+};
+
+/**
+ * \brief Submit a batch of PSA client calls to SPE via mailbox without waiting
+ *        for the results. All the calls in a batch are delivered to SPE with
+ *        a single notification, as long as enough mailbox queue slots are
+ *        available.
+ *
+ * \note The completion of each call can be either polled by
+ *       \ref tfm_ns_mailbox_async_call_is_done or delivered by its callback.
+ *       A call which fails to be submitted to SPE is completed with the
+ *       mailbox error code in its reply.
+ *
+ * \param[in,out] calls         The array of asynchronous PSA client calls.
+ * \param[in] nr_calls          The number of calls in the array.
+ *
+ * \retval MAILBOX_SUCCESS      The PSA client calls are submitted.
+ * \retval Other return code    Operation failed with an error code.
+ */
+int32_t tfm_ns_mailbox_client_call_async(
+                                    struct tfm_ns_mailbox_async_call_t *calls,
+                                    uint8_t nr_calls);
+
+/**
+ * \brief Check whether an asynchronous PSA client call is completed.
+ *
+ * \param[in] call              The asynchronous PSA client call.
+ *
+ * \retval true                 The call is completed and call->reply holds
+ *                              the PSA client call result, or the mailbox
+ *                              error code if the call failed to be submitted.
+ * \retval false                The call is still in progress.
+ */
+bool tfm_ns_mailbox_async_call_is_done(
+                                const struct tfm_ns_mailbox_async_call_t *call);
+
 /**
  * \brief Handling PSA client calls in a dedicated NS mailbox thread.
  *        This function constructs NS mailbox messages, transmits them to SPE
@@ -286,6 +371,7 @@ static inline int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 #define tfm_ns_mailbox_os_spin_unlock() do {} while (0)
 #endif /* TFM_MULTI_CORE_NS_OS */
 
+#if !TFM_MAILBOX_RING
 /* The following inline functions configure non-secure mailbox queue status */
 static inline void clear_queue_slot_empty(struct ns_mailbox_queue_t *queue_ptr,
                                           uint8_t idx)
@@ -309,6 +395,103 @@ static inline void clear_queue_slot_all_replied(
 {
     queue_ptr->replied_slots &= ~status;
 }
+#endif /* !TFM_MAILBOX_RING */
+
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * Carry a psa_call() inline in mailbox queue slot if all the vectors fit in the
+ * inline payload. The input data is copied into the payload.
+ */
+static inline void mailbox_set_inline_call(struct ns_mailbox_slot_t *slot,
+                                      const struct psa_client_params_t *params)
+{
+    const psa_invec *in_vec = params->psa_call_params.in_vec;
+    const psa_outvec *out_vec = params->psa_call_params.out_vec;
+    size_t in_len = params->psa_call_params.in_len;
+    size_t out_len = params->psa_call_params.out_len;
+    size_t payload_size = 0;
+    size_t i;
+
+    if ((slot->msg.call_type != MAILBOX_PSA_CALL) ||
+        (in_len + out_len > PSA_MAX_IOVEC)) {
+        return;
+    }
+
+    for (i = 0; i < in_len; i++) {
+        if (in_vec[i].len > TFM_MAILBOX_INLINE_PAYLOAD_SIZE - payload_size) {
+            return;
+        }
+        payload_size += in_vec[i].len;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        if (out_vec[i].len > TFM_MAILBOX_INLINE_PAYLOAD_SIZE - payload_size) {
+            return;
+        }
+        payload_size += out_vec[i].len;
+    }
+
+    slot->msg.call_type = MAILBOX_PSA_CALL_INLINE;
+    slot->msg.params.psa_call_inline_params.handle =
+                                            params->psa_call_params.handle;
+    slot->msg.params.psa_call_inline_params.type =
+                                            params->psa_call_params.type;
+    slot->msg.params.psa_call_inline_params.in_len = (uint8_t)in_len;
+    slot->msg.params.psa_call_inline_params.out_len = (uint8_t)out_len;
+
+    payload_size = 0;
+    for (i = 0; i < in_len; i++) {
+        if (in_vec[i].len) {
+            memcpy(slot->payload + payload_size, in_vec[i].base,
+                   in_vec[i].len);
+        }
+        slot->msg.params.psa_call_inline_params.io_size[i] =
+                                                    (uint16_t)in_vec[i].len;
+        payload_size += in_vec[i].len;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        slot->msg.params.psa_call_inline_params.io_size[in_len + i] =
+                                                    (uint16_t)out_vec[i].len;
+    }
+}
+
+/*
+ * Copy the output data of an inline psa_call() back to the client output
+ * vectors and update their lengths.
+ */
+static inline void mailbox_get_inline_reply(
+                                      const struct ns_mailbox_slot_t *slot,
+                                      const struct psa_client_params_t *params)
+{
+    psa_outvec *out_vec = params->psa_call_params.out_vec;
+    size_t in_len = slot->msg.params.psa_call_inline_params.in_len;
+    size_t out_len = slot->msg.params.psa_call_inline_params.out_len;
+    size_t payload_size = 0;
+    size_t i, len;
+
+    if (slot->msg.call_type != MAILBOX_PSA_CALL_INLINE) {
+        return;
+    }
+
+    for (i = 0; i < in_len; i++) {
+        payload_size += slot->msg.params.psa_call_inline_params.io_size[i];
+    }
+
+    for (i = 0; i < out_len; i++) {
+        len = slot->msg.params.psa_call_inline_params.io_size[in_len + i];
+        if (len > out_vec[i].len) {
+            len = out_vec[i].len;
+        }
+
+        if (len) {
+            memcpy(out_vec[i].base, slot->payload + payload_size, len);
+        }
+        payload_size += out_vec[i].len;
+        out_vec[i].len = len;
+    }
+}
+#endif /* TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0 */
 
 #ifdef __cplusplus
 }
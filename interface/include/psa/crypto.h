@@ -1166,6 +1166,63 @@ psa_status_t psa_hash_abort(psa_hash_operation_t *operation);
 psa_status_t psa_hash_clone(const psa_hash_operation_t *source_operation,
                             psa_hash_operation_t *target_operation);
 
+/** Halt the hash operation and extract the intermediate state of the hash
+ * computation.
+ *
+ * The state is encoded in the hash suspend state format of the PSA Crypto
+ * API 1.1. It can be passed to psa_hash_resume() any number of times, i.e.
+ * to hash several messages sharing a common prefix without processing the
+ * prefix again. Once suspended, the operation is inactive.
+ *
+ * \param[in,out] operation     Active hash operation.
+ * \param[out] hash_state       Buffer where the hash suspend state is to be
+ *                              written.
+ * \param hash_state_size       Size of the \p hash_state buffer in bytes.
+ *                              This must be at least
+ *                              #PSA_HASH_SUSPEND_OUTPUT_SIZE(\c alg).
+ * \param[out] hash_state_length On success, the number of bytes that make up
+ *                              the hash suspend state.
+ *
+ * \retval #PSA_SUCCESS \emptydescription
+ * \retval #PSA_ERROR_BUFFER_TOO_SMALL
+ *         The size of the \p hash_state buffer is too small.
+ * \retval #PSA_ERROR_NOT_SUPPORTED
+ *         The hash algorithm being computed does not support suspend and
+ *         resume.
+ * \retval #PSA_ERROR_COMMUNICATION_FAILURE \emptydescription
+ * \retval #PSA_ERROR_CORRUPTION_DETECTED \emptydescription
+ * \retval #PSA_ERROR_BAD_STATE
+ *         The operation state is not valid (it must be active).
+ */
+psa_status_t psa_hash_suspend(psa_hash_operation_t *operation,
+                              uint8_t *hash_state,
+                              size_t hash_state_size,
+                              size_t *hash_state_length);
+
+/** Set up a multi-part hash operation using the hash suspend state from a
+ * previously suspended hash operation.
+ *
+ * \param[in,out] operation     The operation object to set up. It must have
+ *                              been initialized but not set up yet.
+ * \param[in] hash_state        A buffer containing the suspended hash state
+ *                              which is to be resumed.
+ * \param hash_state_length     Length of \p hash_state in bytes.
+ *
+ * \retval #PSA_SUCCESS \emptydescription
+ * \retval #PSA_ERROR_INVALID_ARGUMENT
+ *         \p hash_state does not correspond to a valid hash suspend state.
+ * \retval #PSA_ERROR_NOT_SUPPORTED
+ *         The provided hash suspend state is for an algorithm that is not
+ *         supported.
+ * \retval #PSA_ERROR_COMMUNICATION_FAILURE \emptydescription
+ * \retval #PSA_ERROR_CORRUPTION_DETECTED \emptydescription
+ * \retval #PSA_ERROR_BAD_STATE
+ *         The operation state is not valid (it must be inactive).
+ */
+psa_status_t psa_hash_resume(psa_hash_operation_t *operation,
+                             const uint8_t *hash_state,
+                             size_t hash_state_length);
+
 /**@}*/
 
 /** \defgroup MAC Message authentication codes
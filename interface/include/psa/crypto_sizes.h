@@ -121,6 +121,55 @@
 #define PSA_HMAC_MAX_HASH_BLOCK_SIZE 128
 #endif
 
+/** The size of the \c algorithm field of a hash suspend state, in bytes. */
+#define PSA_HASH_SUSPEND_ALGORITHM_FIELD_LENGTH ((size_t)4)
+
+/** The size of the \c input-length field of a hash suspend state for the
+ * specified hash algorithm, in bytes, or 0 if the algorithm is not supported.
+ */
+#define PSA_HASH_SUSPEND_INPUT_LENGTH_FIELD_LENGTH(alg)             \
+    ((alg) == PSA_ALG_MD5 ? 8 :                                     \
+     (alg) == PSA_ALG_RIPEMD160 ? 8 :                               \
+     (alg) == PSA_ALG_SHA_1 ? 8 :                                   \
+     (alg) == PSA_ALG_SHA_224 ? 8 :                                 \
+     (alg) == PSA_ALG_SHA_256 ? 8 :                                 \
+     (alg) == PSA_ALG_SHA_384 ? 16 :                                \
+     (alg) == PSA_ALG_SHA_512 ? 16 :                                \
+     (alg) == PSA_ALG_SHA_512_224 ? 16 :                            \
+     (alg) == PSA_ALG_SHA_512_256 ? 16 :                            \
+     0)
+
+/** The size of the \c hash-state field of a hash suspend state for the
+ * specified hash algorithm, in bytes, or 0 if the algorithm is not supported.
+ */
+#define PSA_HASH_SUSPEND_HASH_STATE_FIELD_LENGTH(alg)               \
+    ((alg) == PSA_ALG_MD5 ? 16 :                                    \
+     (alg) == PSA_ALG_RIPEMD160 ? 20 :                              \
+     (alg) == PSA_ALG_SHA_1 ? 20 :                                  \
+     (alg) == PSA_ALG_SHA_224 ? 32 :                                \
+     (alg) == PSA_ALG_SHA_256 ? 32 :                                \
+     (alg) == PSA_ALG_SHA_384 ? 64 :                                \
+     (alg) == PSA_ALG_SHA_512 ? 64 :                                \
+     (alg) == PSA_ALG_SHA_512_224 ? 64 :                            \
+     (alg) == PSA_ALG_SHA_512_256 ? 64 :                            \
+     0)
+
+/** A sufficient output buffer size for psa_hash_suspend(), in bytes, or 0 if
+ * the hash algorithm does not support suspend.
+ */
+#define PSA_HASH_SUSPEND_OUTPUT_SIZE(alg)                           \
+    (PSA_HASH_SUSPEND_HASH_STATE_FIELD_LENGTH(alg) == 0 ? 0 :       \
+     PSA_HASH_SUSPEND_ALGORITHM_FIELD_LENGTH +                      \
+     PSA_HASH_SUSPEND_INPUT_LENGTH_FIELD_LENGTH(alg) +              \
+     PSA_HASH_SUSPEND_HASH_STATE_FIELD_LENGTH(alg) +                \
+     PSA_HASH_BLOCK_LENGTH(alg) - 1)
+
+/** A sufficient output buffer size for psa_hash_suspend() for any of the
+ * supported hash algorithms, in bytes.
+ */
+#define PSA_HASH_SUSPEND_OUTPUT_MAX_SIZE                            \
+    (PSA_HASH_SUSPEND_ALGORITHM_FIELD_LENGTH + 16 + 64 + 128 - 1)
+
 /** \def PSA_MAC_MAX_SIZE
  *
  * Maximum size of a MAC.
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_CRYPTO_BATCH_API_H__
+#define __TFM_CRYPTO_BATCH_API_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tfm_crypto_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Updates several multi-part operations in a single call to the Crypto
+ *        service.
+ *
+ * \details Each update is processed as the corresponding psa_hash_update(),
+ *          psa_mac_update(), psa_cipher_update(), psa_aead_update_ad() or
+ *          psa_aead_update() call, in the order of \p updates. The inputs of
+ *          the updates are packed in order in \p input. Each update is given
+ *          the next output_size bytes of \p output, whatever the length of the
+ *          output it actually produces. An update failing does not prevent the
+ *          following ones from being processed.
+ *
+ * \param[in]  updates       Updates to process
+ * \param[in]  nr_updates    Number of updates in \p updates
+ * \param[in]  input         Inputs of the updates
+ * \param[in]  input_length  Size of \p input in bytes
+ * \param[out] output        Outputs of the updates
+ * \param[in]  output_size   Size of \p output in bytes
+ * \param[out] results       Results of the updates, \p nr_updates entries
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The batch has been processed, the status
+ *                                     of each update is in \p results
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The batch is empty or its buffers are
+ *                                     too small
+ */
+psa_status_t tfm_crypto_update_batch(
+                                const struct tfm_crypto_batch_update *updates,
+                                size_t nr_updates,
+                                const uint8_t *input,
+                                size_t input_length,
+                                uint8_t *output,
+                                size_t output_size,
+                                struct tfm_crypto_batch_result *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_CRYPTO_BATCH_API_H__ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_CRYPTO_CLIENT_API_H__
+#define __TFM_CRYPTO_CLIENT_API_H__
+
+#include <stdint.h>
+#include "tfm_crypto_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Aborts and releases all the multi-part operations which a client
+ *        has left in the Crypto service.
+ *
+ * \details A client terminating without aborting its multi-part operations
+ *          keeps holding their contexts in the Crypto service. The Non-secure
+ *          OS calls this function when it releases the context of a client,
+ *          i.e. along with tfm_nsce_release_ctx(), with the Non-secure client
+ *          ID of the terminated client. A secure partition can only release
+ *          its own operations.
+ *
+ * \param[in] client_id  ID of the client whose operations are released
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operations of the client, if any,
+ *                                     have been aborted and released
+ * \retval PSA_ERROR_NOT_PERMITTED     The caller is not allowed to release the
+ *                                     operations of \p client_id
+ */
+psa_status_t tfm_crypto_release_client_operations(int32_t client_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_CRYPTO_CLIENT_API_H__ */
@@ -60,10 +60,39 @@ struct tfm_crypto_pack_iovec {
     uint16_t step;           /*!< Key derivation step */
 };
 
+/**
+ * \brief Describes one update of a multi-part operation in a batch of updates
+ *        processed by a single call to the Crypto service. The inputs of the
+ *        updates are packed in order in a single input buffer, and the
+ *        outputs in a single output buffer, each update owning output_size
+ *        bytes of it.
+ */
+struct tfm_crypto_batch_update {
+    uint16_t function_id;    /*!< ID of the update function, one of
+                              *   TFM_CRYPTO_HASH_UPDATE_SID,
+                              *   TFM_CRYPTO_MAC_UPDATE_SID,
+                              *   TFM_CRYPTO_CIPHER_UPDATE_SID,
+                              *   TFM_CRYPTO_AEAD_UPDATE_AD_SID or
+                              *   TFM_CRYPTO_AEAD_UPDATE_SID
+                              */
+    uint16_t reserved;       /*!< Must be 0 */
+    uint32_t op_handle;      /*!< Handle of the multipart operation */
+    uint32_t input_length;   /*!< Length of the input of the update */
+    uint32_t output_size;    /*!< Size of the output of the update */
+};
+
+/**
+ * \brief Result of one update of a batch of updates
+ */
+struct tfm_crypto_batch_result {
+    psa_status_t status;     /*!< Status of the update */
+    uint32_t output_length;  /*!< Length of the output of the update */
+};
+
 /**
  * \brief Type associated to the group of a function encoding. There can be
- *        nine groups (Random, Key management, Hash, MAC, Cipher, AEAD,
- *        Asym sign, Asym encrypt, Key derivation).
+ *        eleven groups (Random, Key management, Hash, MAC, Cipher, AEAD,
+ *        Asym sign, Asym encrypt, Key derivation, Batch, Client).
  */
 enum tfm_crypto_group_id {
     TFM_CRYPTO_GROUP_ID_RANDOM = 0x0,
@@ -75,6 +104,8 @@ enum tfm_crypto_group_id {
     TFM_CRYPTO_GROUP_ID_ASYM_SIGN,
     TFM_CRYPTO_GROUP_ID_ASYM_ENCRYPT,
     TFM_CRYPTO_GROUP_ID_KEY_DERIVATION,
+    TFM_CRYPTO_GROUP_ID_BATCH,
+    TFM_CRYPTO_GROUP_ID_CLIENT,
 };
 
 /* Set of X macros describing each of the available PSA Crypto APIs */
@@ -99,7 +130,9 @@ enum tfm_crypto_group_id {
     X(TFM_CRYPTO_HASH_CLONE)                       \
     X(TFM_CRYPTO_HASH_FINISH)                      \
     X(TFM_CRYPTO_HASH_VERIFY)                      \
-    X(TFM_CRYPTO_HASH_ABORT)
+    X(TFM_CRYPTO_HASH_ABORT)                       \
+    X(TFM_CRYPTO_HASH_SUSPEND)                     \
+    X(TFM_CRYPTO_HASH_RESUME)
 
 #define MAC_FUNCS                                  \
     X(TFM_CRYPTO_MAC_COMPUTE)                      \
@@ -161,6 +194,12 @@ enum tfm_crypto_group_id {
 #define RANDOM_FUNCS                               \
     X(TFM_CRYPTO_GENERATE_RANDOM)
 
+#define BATCH_FUNCS                                \
+    X(TFM_CRYPTO_BATCH_UPDATE)
+
+#define CLIENT_FUNCS                               \
+    X(TFM_CRYPTO_RELEASE_CLIENT_OPERATIONS)
+
 /**
  * \brief Define function IDs in each group. The function ID will be encoded into
  *        tfm_crypto_func_sid below. Each group is defined as a dedicated enum
@@ -193,6 +232,12 @@ enum tfm_crypto_key_derivation_func_id {
 enum tfm_crypto_random_func_id {
     RANDOM_FUNCS
 };
+enum tfm_crypto_batch_func_id {
+    BATCH_FUNCS
+};
+enum tfm_crypto_client_func_id {
+    CLIENT_FUNCS
+};
 #undef X
 
 /**
@@ -268,6 +313,16 @@ enum tfm_crypto_func_sid {
                                            (TFM_CRYPTO_GROUP_ID_RANDOM & 0xFF)),
     RANDOM_FUNCS
 
+#undef X
+#define X(func_id)      func_id ## _SID = (uint16_t)((FUNC_ID(func_id)) | \
+                                            (TFM_CRYPTO_GROUP_ID_BATCH & 0xFF)),
+    BATCH_FUNCS
+
+#undef X
+#define X(func_id)      func_id ## _SID = (uint16_t)((FUNC_ID(func_id)) | \
+                                           (TFM_CRYPTO_GROUP_ID_CLIENT & 0xFF)),
+    CLIENT_FUNCS
+
 };
 #undef X
 
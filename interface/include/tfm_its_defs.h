@@ -20,6 +20,9 @@ extern "C" {
 #define TFM_ITS_GET                1002
 #define TFM_ITS_GET_INFO           1003
 #define TFM_ITS_REMOVE             1004
+#define TFM_ITS_TXN_BEGIN          1005
+#define TFM_ITS_TXN_COMMIT         1006
+#define TFM_ITS_TXN_ABORT          1007
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_ITS_TXN_API_H__
+#define __TFM_ITS_TXN_API_H__
+
+#include "psa/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Starts an Internal Trusted Storage transaction for the caller.
+ *
+ * \details Until the transaction is committed, the psa_its_set() and
+ *          psa_its_remove() calls of the caller are staged, and they are then
+ *          all applied by a single update of the storage, so that either all
+ *          or none of them are persisted in the case of a power failure.
+ *          psa_its_get() and psa_its_get_info() return the data stored before
+ *          the transaction. An asset can be set at most once in a transaction,
+ *          and an asset set in the transaction cannot be removed in the same
+ *          transaction. A psa_its_set() or psa_its_remove() call of another
+ *          client aborts the transaction, which then fails to commit.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE      A transaction is already in progress
+ * \retval PSA_ERROR_NOT_SUPPORTED  The service does not support transactions
+ */
+psa_status_t tfm_its_transaction_begin(void);
+
+/**
+ * \brief Commits the Internal Trusted Storage transaction of the caller.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The caller has no transaction in
+ *                                    progress, or the transaction has been
+ *                                    aborted
+ * \retval PSA_ERROR_STORAGE_FAILURE  The physical storage has failed (Fatal
+ *                                    error)
+ */
+psa_status_t tfm_its_transaction_commit(void);
+
+/**
+ * \brief Aborts the Internal Trusted Storage transaction of the caller and
+ *        discards the staged changes.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The caller has no transaction in progress
+ * \retval PSA_ERROR_STORAGE_FAILURE  The physical storage has failed (Fatal
+ *                                    error)
+ */
+psa_status_t tfm_its_transaction_abort(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_ITS_TXN_API_H__ */
@@ -15,14 +15,33 @@
 /* The pointer to NSPE mailbox queue */
 static struct ns_mailbox_queue_t *mailbox_queue_ptr = NULL;
 
+#if TFM_MAILBOX_RING
+/*
+ * Indices of the empty slots. Only NSPE accesses them and therefore they are
+ * protected by NSPE local spin lock.
+ */
+static uint8_t empty_slot_stack[NUM_MAILBOX_QUEUE_SLOT];
+static uint8_t nr_empty_slots;
+#endif
+
 static int32_t mailbox_wait_reply(uint8_t idx);
 
+#if TFM_MAILBOX_RING
+static inline void set_queue_slot_empty(uint8_t idx)
+{
+    if ((idx < NUM_MAILBOX_QUEUE_SLOT) &&
+        (nr_empty_slots < NUM_MAILBOX_QUEUE_SLOT)) {
+        empty_slot_stack[nr_empty_slots++] = idx;
+    }
+}
+#else /* TFM_MAILBOX_RING */
 static inline void set_queue_slot_empty(uint8_t idx)
 {
     if (idx < NUM_MAILBOX_QUEUE_SLOT) {
         mailbox_queue_ptr->empty_slots |= (1UL << idx);
     }
 }
+#endif /* TFM_MAILBOX_RING */
 
 static inline void set_queue_slot_woken(uint8_t idx)
 {
@@ -47,7 +66,7 @@ static inline void clear_queue_slot_woken(uint8_t idx)
     }
 }
 
-#ifndef TFM_MULTI_CORE_NS_OS
+#if !defined(TFM_MULTI_CORE_NS_OS) && !TFM_MAILBOX_RING
 static inline void clear_queue_slot_replied(uint8_t idx)
 {
     if (idx < NUM_MAILBOX_QUEUE_SLOT) {
@@ -63,8 +82,24 @@ static inline bool is_queue_slot_replied(uint8_t idx)
 
     return false;
 }
-#endif /* !defined TFM_MULTI_CORE_NS_OS */
+#endif /* !defined TFM_MULTI_CORE_NS_OS && !TFM_MAILBOX_RING */
 
+#if TFM_MAILBOX_RING
+static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
+{
+    uint8_t idx = NUM_MAILBOX_QUEUE_SLOT;
+
+    (void)queue;
+
+    tfm_ns_mailbox_os_spin_lock();
+    if (nr_empty_slots) {
+        idx = empty_slot_stack[--nr_empty_slots];
+    }
+    tfm_ns_mailbox_os_spin_unlock();
+
+    return idx;
+}
+#else /* TFM_MAILBOX_RING */
 static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
 {
     uint8_t idx;
@@ -91,6 +126,7 @@ static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
 
     return idx;
 }
+#endif /* TFM_MAILBOX_RING */
 
 static void set_msg_owner(uint8_t idx, const void *owner)
 {
@@ -124,6 +160,10 @@ static int32_t mailbox_tx_client_req(uint32_t call_type,
     memcpy(&msg_ptr->params, params, sizeof(msg_ptr->params));
     msg_ptr->client_id = client_id;
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    mailbox_set_inline_call(&mailbox_queue_ptr->queue[idx], params);
+#endif
+
     /*
      * Fetch the current task handle. The task will be woken up according the
      * handle value set in the owner field.
@@ -131,9 +171,19 @@ static int32_t mailbox_tx_client_req(uint32_t call_type,
     task_handle = tfm_ns_mailbox_os_get_task_handle();
     set_msg_owner(idx, task_handle);
 
+#if TFM_MAILBOX_RING
+    /*
+     * NSPE tasks share the request ring as a single producer. SPE only
+     * consumes it, so no lock between cores is required.
+     */
+    tfm_ns_mailbox_os_spin_lock();
+    (void)mailbox_ring_push(&mailbox_queue_ptr->req_ring, idx);
+    tfm_ns_mailbox_os_spin_unlock();
+#else
     tfm_ns_mailbox_hal_enter_critical();
     set_queue_slot_pend(mailbox_queue_ptr, idx);
     tfm_ns_mailbox_hal_exit_critical();
+#endif
 
     tfm_ns_mailbox_hal_notify_peer();
 
@@ -190,6 +240,10 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
 
     mailbox_wait_reply(slot_idx);
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    mailbox_get_inline_reply(&mailbox_queue_ptr->queue[slot_idx], params);
+#endif
+
     /* It requires SVCall if NS mailbox is put in privileged mode. */
     ret = mailbox_rx_client_reply(slot_idx, &reply_buf);
     if (ret == MAILBOX_SUCCESS) {
@@ -205,6 +259,40 @@ exit:
 }
 
 #ifdef TFM_MULTI_CORE_NS_OS
+#if TFM_MAILBOX_RING
+int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
+{
+    uint8_t idx;
+    bool is_replied = false;
+
+    if (!mailbox_queue_ptr) {
+        return MAILBOX_INIT_ERROR;
+    }
+
+    /* The IRQ handler is the only consumer of the reply ring */
+    while (mailbox_ring_pop(&mailbox_queue_ptr->reply_ring, &idx)) {
+        if (idx >= NUM_MAILBOX_QUEUE_SLOT) {
+            continue;
+        }
+
+        is_replied = true;
+
+        /* Set woken-up flag */
+        tfm_ns_mailbox_hal_enter_critical_isr();
+        set_queue_slot_woken(idx);
+        tfm_ns_mailbox_hal_exit_critical_isr();
+
+        tfm_ns_mailbox_os_wake_task_isr(
+                                     mailbox_queue_ptr->queue[idx].reply.owner);
+    }
+
+    if (!is_replied) {
+        return MAILBOX_NO_PEND_EVENT;
+    }
+
+    return MAILBOX_SUCCESS;
+}
+#else /* TFM_MAILBOX_RING */
 int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 {
     uint8_t idx;
@@ -248,6 +336,7 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 
     return MAILBOX_SUCCESS;
 }
+#endif /* TFM_MAILBOX_RING */
 
 static inline bool mailbox_wait_reply_signal(uint8_t idx)
 {
@@ -264,6 +353,24 @@ static inline bool mailbox_wait_reply_signal(uint8_t idx)
 
     return is_set;
 }
+#elif TFM_MAILBOX_RING
+static inline bool mailbox_wait_reply_signal(uint8_t idx)
+{
+    uint8_t replied_idx;
+    bool is_set = false;
+
+    /* The caller is the only consumer of the reply ring in bare metal */
+    while (mailbox_ring_pop(&mailbox_queue_ptr->reply_ring, &replied_idx)) {
+        set_queue_slot_woken(replied_idx);
+    }
+
+    if (is_queue_slot_woken(idx)) {
+        clear_queue_slot_woken(idx);
+        is_set = true;
+    }
+
+    return is_set;
+}
 #else /* TFM_MULTI_CORE_NS_OS */
 static inline bool mailbox_wait_reply_signal(uint8_t idx)
 {
@@ -324,11 +431,19 @@ int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
 
     memset(queue, 0, sizeof(*queue));
 
+#if TFM_MAILBOX_RING
+    /* Initialize empty slot stack */
+    for (nr_empty_slots = 0; nr_empty_slots < NUM_MAILBOX_QUEUE_SLOT;
+         nr_empty_slots++) {
+        empty_slot_stack[nr_empty_slots] = nr_empty_slots;
+    }
+#else
     /* Initialize empty bitmask */
     queue->empty_slots =
             (mailbox_queue_status_t)((1UL << (NUM_MAILBOX_QUEUE_SLOT - 1)) - 1);
     queue->empty_slots +=
             (mailbox_queue_status_t)(1UL << (NUM_MAILBOX_QUEUE_SLOT - 1));
+#endif
 
     mailbox_queue_ptr = queue;
 
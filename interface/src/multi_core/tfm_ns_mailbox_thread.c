@@ -39,6 +39,13 @@ struct ns_mailbox_req_t {
                                                    * up, after the reply is
                                                    * received.
                                                    */
+    struct tfm_ns_mailbox_async_call_t *async_calls; /* Batch of asynchronous
+                                                      * calls, or NULL for a
+                                                      * blocking call.
+                                                      */
+    uint8_t                          nr_async_calls; /* Number of calls in
+                                                      * async_calls.
+                                                      */
 };
 
 /* Message queue handle */
@@ -50,6 +57,22 @@ static const void *ns_mailbox_thread_handle = NULL;
 /* The pointer to NSPE mailbox queue */
 static struct ns_mailbox_queue_t *mailbox_queue_ptr = NULL;
 
+/*
+ * The asynchronous call in each mailbox queue slot, or NULL if the slot holds a
+ * blocking call. Only accessed by NS mailbox thread and NS mailbox IRQ handler.
+ */
+static struct tfm_ns_mailbox_async_call_t
+                                *slot_async_calls[NUM_MAILBOX_QUEUE_SLOT];
+
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * The PSA client call parameters in each mailbox queue slot, to return the
+ * output data of an inline PSA client call.
+ */
+static const struct psa_client_params_t
+                                *slot_params[NUM_MAILBOX_QUEUE_SLOT];
+#endif
+
 static inline void set_queue_slot_all_empty(mailbox_queue_status_t completed)
 {
     mailbox_queue_ptr->empty_slots |= completed;
@@ -100,7 +123,8 @@ static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
 }
 
 static int32_t mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
-                                          uint8_t *slot_idx)
+                                     struct tfm_ns_mailbox_async_call_t *async,
+                                     bool notify, uint8_t *slot_idx)
 {
     struct mailbox_msg_t *msg_ptr;
     struct mailbox_reply_t *reply_ptr;
@@ -121,12 +145,20 @@ static int32_t mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
     memcpy(&msg_ptr->params, req->params_ptr, sizeof(msg_ptr->params));
     msg_ptr->client_id = req->client_id;
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    mailbox_set_inline_call(&mailbox_queue_ptr->queue[idx], req->params_ptr);
+    slot_params[idx] = req->params_ptr;
+#endif
+
     /* Prepare the reply structure */
     reply_ptr = &mailbox_queue_ptr->queue[idx].reply;
     reply_ptr->owner = req->owner;
     reply_ptr->reply = req->reply;
     reply_ptr->woken_flag = req->woken_flag;
 
+    /* Must be set before the slot can be replied */
+    slot_async_calls[idx] = async;
+
     /*
      * Memory check can be added here to prevent a malicious application
      * from providing addresses of other applications or privileged area.
@@ -136,7 +168,9 @@ static int32_t mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
     set_queue_slot_pend(mailbox_queue_ptr, idx);
     tfm_ns_mailbox_hal_exit_critical();
 
-    tfm_ns_mailbox_hal_notify_peer();
+    if (notify) {
+        tfm_ns_mailbox_hal_notify_peer();
+    }
 
     if (slot_idx) {
         *slot_idx = idx;
@@ -149,6 +183,10 @@ static inline void ns_mailbox_set_reply_isr(uint8_t idx)
 {
     int32_t *reply_ptr = mailbox_queue_ptr->queue[idx].reply.reply;
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    mailbox_get_inline_reply(&mailbox_queue_ptr->queue[idx], slot_params[idx]);
+#endif
+
     if (reply_ptr) {
         *reply_ptr = mailbox_queue_ptr->queue[idx].reply.return_val;
     }
@@ -195,6 +233,8 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
     req.woken_flag = &woken_flag;
     req.owner = tfm_ns_mailbox_os_get_task_handle();
     req.client_id = client_id;
+    req.async_calls = NULL;
+    req.nr_async_calls = 0;
 
     ret = tfm_ns_mailbox_os_mq_send(msgq_handle, &req);
     if (ret != MAILBOX_SUCCESS) {
@@ -206,6 +246,96 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
     return ret;
 }
 
+int32_t tfm_ns_mailbox_client_call_async(
+                                    struct tfm_ns_mailbox_async_call_t *calls,
+                                    uint8_t nr_calls)
+{
+    struct ns_mailbox_req_t req;
+    uint8_t i;
+
+    if (!mailbox_queue_ptr) {
+        return MAILBOX_INIT_ERROR;
+    }
+
+    if (!calls || !nr_calls) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    for (i = 0; i < nr_calls; i++) {
+        if (!calls[i].params) {
+            return MAILBOX_INVAL_PARAMS;
+        }
+
+        calls[i].woken_flag = NOT_WOKEN;
+    }
+
+    /* The whole batch is forwarded to NS mailbox thread in a single request */
+    memset(&req, 0, sizeof(req));
+    req.async_calls = calls;
+    req.nr_async_calls = nr_calls;
+
+    return tfm_ns_mailbox_os_mq_send(msgq_handle, &req);
+}
+
+bool tfm_ns_mailbox_async_call_is_done(
+                                const struct tfm_ns_mailbox_async_call_t *call)
+{
+    return call && (*(volatile const uint8_t *)&call->woken_flag == WOKEN_UP);
+}
+
+static void mailbox_tx_async_calls(const struct ns_mailbox_req_t *batch)
+{
+    struct tfm_ns_mailbox_async_call_t *call;
+    struct ns_mailbox_req_t req;
+    mailbox_queue_status_t empty_slots;
+    bool notify, is_unnotified = false;
+    int32_t ret;
+    uint8_t i;
+
+    for (i = 0; i < batch->nr_async_calls; i++) {
+        call = &batch->async_calls[i];
+
+        /* No task is woken up. The reply is delivered via the call itself. */
+        req.call_type = call->call_type;
+        req.params_ptr = call->params;
+        req.client_id = call->client_id;
+        req.owner = NULL;
+        req.reply = &call->reply;
+        req.woken_flag = &call->woken_flag;
+
+        tfm_ns_mailbox_os_spin_lock();
+        empty_slots = mailbox_queue_ptr->empty_slots;
+        tfm_ns_mailbox_os_spin_unlock();
+
+        /*
+         * Notify SPE once after the last call in the batch. Also notify SPE
+         * if this call takes the last empty slot, otherwise the NS mailbox
+         * thread may wait for an empty slot which SPE is never notified to
+         * release.
+         */
+        notify = (i == (batch->nr_async_calls - 1)) ||
+                 !(empty_slots & (empty_slots - 1));
+
+        ret = mailbox_tx_client_call_msg(&req, call, notify, NULL);
+        if (ret != MAILBOX_SUCCESS) {
+            /* The call is never replied. Complete it with the error. */
+            call->reply = ret;
+            call->woken_flag = WOKEN_UP;
+            if (call->callback) {
+                call->callback(call);
+            }
+            continue;
+        }
+
+        is_unnotified = !notify;
+    }
+
+    /* The failed last call was meant to notify the calls submitted before */
+    if (is_unnotified) {
+        tfm_ns_mailbox_hal_notify_peer();
+    }
+}
+
 void tfm_ns_mailbox_thread_runner(void *args)
 {
     struct ns_mailbox_req_t req;
@@ -221,6 +351,11 @@ void tfm_ns_mailbox_thread_runner(void *args)
             continue;
         }
 
+        if (req.async_calls) {
+            mailbox_tx_async_calls(&req);
+            continue;
+        }
+
         /*
          * Invalid client address. However, the pointer was already
          * checked previously and therefore just simply ignore this
@@ -230,7 +365,7 @@ void tfm_ns_mailbox_thread_runner(void *args)
             continue;
         }
 
-        mailbox_tx_client_call_msg(&req, NULL);
+        mailbox_tx_client_call_msg(&req, NULL, true, NULL);
     }
 }
 
@@ -280,6 +415,14 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
             tfm_ns_mailbox_os_wake_task_isr(task_handle);
         }
 
+        /* Deliver the completion of an asynchronous call */
+        if (slot_async_calls[idx]) {
+            if (slot_async_calls[idx]->callback) {
+                slot_async_calls[idx]->callback(slot_async_calls[idx]);
+            }
+            slot_async_calls[idx] = NULL;
+        }
+
         complete_slots |= (1UL << idx);
 
         replied_status &= ~(0x1UL << idx);
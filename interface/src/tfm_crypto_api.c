@@ -6,6 +6,8 @@
  */
 
 #include "tfm_crypto_defs.h"
+#include "tfm_crypto_batch_api.h"
+#include "tfm_crypto_client_api.h"
 #include "psa/crypto.h"
 #include "psa/client.h"
 #include "psa_manifest/sid.h"
@@ -518,6 +520,52 @@ TFM_CRYPTO_API(psa_status_t, psa_hash_clone)(const psa_hash_operation_t *source_
     return API_DISPATCH(in_vec, out_vec);
 }
 
+TFM_CRYPTO_API(psa_status_t, psa_hash_suspend)(psa_hash_operation_t *operation,
+                                               uint8_t *hash_state,
+                                               size_t hash_state_size,
+                                               size_t *hash_state_length)
+{
+    psa_status_t status;
+    struct tfm_crypto_pack_iovec iov = {
+        .function_id = TFM_CRYPTO_HASH_SUSPEND_SID,
+        .op_handle = operation->handle,
+    };
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+    };
+    psa_outvec out_vec[] = {
+        {.base = &(operation->handle), .len = sizeof(uint32_t)},
+        {.base = hash_state, .len = hash_state_size},
+    };
+
+    status = API_DISPATCH(in_vec, out_vec);
+
+    *hash_state_length = out_vec[1].len;
+
+    return status;
+}
+
+TFM_CRYPTO_API(psa_status_t, psa_hash_resume)(psa_hash_operation_t *operation,
+                                              const uint8_t *hash_state,
+                                              size_t hash_state_length)
+{
+    struct tfm_crypto_pack_iovec iov = {
+        .function_id = TFM_CRYPTO_HASH_RESUME_SID,
+        .op_handle = operation->handle,
+    };
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+        {.base = hash_state, .len = hash_state_length},
+    };
+    psa_outvec out_vec[] = {
+        {.base = &(operation->handle), .len = sizeof(uint32_t)},
+    };
+
+    return API_DISPATCH(in_vec, out_vec);
+}
+
 TFM_CRYPTO_API(psa_status_t, psa_hash_compute)(psa_algorithm_t alg,
                                                const uint8_t *input,
                                                size_t input_length,
@@ -1656,3 +1704,45 @@ TFM_CRYPTO_API(psa_status_t, psa_key_derivation_output_key)(
 
     return API_DISPATCH(in_vec, out_vec);
 }
+
+psa_status_t tfm_crypto_update_batch(
+                                const struct tfm_crypto_batch_update *updates,
+                                size_t nr_updates,
+                                const uint8_t *input,
+                                size_t input_length,
+                                uint8_t *output,
+                                size_t output_size,
+                                struct tfm_crypto_batch_result *results)
+{
+    struct tfm_crypto_pack_iovec iov = {
+        .function_id = TFM_CRYPTO_BATCH_UPDATE_SID,
+    };
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+        {.base = updates,
+         .len = nr_updates * sizeof(struct tfm_crypto_batch_update)},
+        {.base = input, .len = input_length},
+    };
+    psa_outvec out_vec[] = {
+        {.base = results,
+         .len = nr_updates * sizeof(struct tfm_crypto_batch_result)},
+        {.base = output, .len = output_size},
+    };
+
+    return API_DISPATCH(in_vec, out_vec);
+}
+
+psa_status_t tfm_crypto_release_client_operations(int32_t client_id)
+{
+    struct tfm_crypto_pack_iovec iov = {
+        .function_id = TFM_CRYPTO_RELEASE_CLIENT_OPERATIONS_SID,
+    };
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+        {.base = &client_id, .len = sizeof(client_id)},
+    };
+
+    return API_DISPATCH_NO_OUTVEC(in_vec);
+}
@@ -9,6 +9,7 @@
 #include "psa/internal_trusted_storage.h"
 #include "psa_manifest/sid.h"
 #include "tfm_its_defs.h"
+#include "tfm_its_txn_api.h"
 
 psa_status_t psa_its_set(psa_storage_uid_t uid,
                          size_t data_length,
@@ -91,3 +92,21 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
 
     return status;
 }
+
+psa_status_t tfm_its_transaction_begin(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_BEGIN, NULL, 0, NULL, 0);
+}
+
+psa_status_t tfm_its_transaction_commit(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_COMMIT, NULL, 0, NULL, 0);
+}
+
+psa_status_t tfm_its_transaction_abort(void)
+{
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_ABORT, NULL, 0, NULL, 0);
+}
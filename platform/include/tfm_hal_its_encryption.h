@@ -9,6 +9,7 @@
 #ifndef __TFM_HAL_ITS_ENCRYPTION_H__
 #define __TFM_HAL_ITS_ENCRYPTION_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -120,6 +121,83 @@ enum tfm_hal_status_t tfm_hal_its_aead_decrypt(
                                          uint8_t *plaintext,
                                          const size_t plaintext_size);
 
+/**
+ * \brief Set up a multi-part authenticated encryption or decryption.
+ *
+ * \details Required when ITS_ENCRYPTION_STREAMING is enabled. The same key
+ *          derivation and the same members of the ctx struct as for
+ *          tfm_hal_its_aead_encrypt() and tfm_hal_its_aead_decrypt() are
+ *          used, but the derivation label can be longer than a file ID.
+ *          The ctx struct is not accessed after this function returns.
+ *          Only one multi-part operation is in progress at a time, so its
+ *          state can be kept by the platform.
+ *
+ * \param [in]  ctx               AEAD context for ITS object
+ * \param [in]  is_encrypt        true to encrypt, false to decrypt
+ * \param [in]  plaintext_size    Total size of the plaintext in bytes
+ *
+ * \retval TFM_HAL_SUCCESS             The operation completed successfully
+ * \retval TFM_HAL_ERROR_INVALID_INPUT Invalid argument
+ * \retval TFM_HAL_ERROR_GENERIC       Failed to set up the operation
+ */
+enum tfm_hal_status_t tfm_hal_its_aead_setup(
+                                         struct tfm_hal_its_auth_crypt_ctx *ctx,
+                                         bool is_encrypt,
+                                         const size_t plaintext_size);
+
+/**
+ * \brief Encrypt or decrypt a chunk of data of a multi-part operation.
+ *
+ * \details The output is exactly as long as the input, so that it can be
+ *          written to the file at the same offset as the input. The input and
+ *          the output can be the same buffer. During a decryption, the output
+ *          is not authenticated until tfm_hal_its_aead_verify() succeeds.
+ *
+ * \param [in]  input             Pointer to the input chunk
+ * \param [in]  input_size        Size of the input chunk in bytes
+ * \param [out] output            Pointer to the output chunk
+ * \param [in]  output_size       Size of the output buffer in bytes
+ *
+ * \retval TFM_HAL_SUCCESS             The operation completed successfully
+ * \retval TFM_HAL_ERROR_INVALID_INPUT Invalid argument
+ * \retval TFM_HAL_ERROR_GENERIC       Failed to encrypt or decrypt
+ */
+enum tfm_hal_status_t tfm_hal_its_aead_update(const uint8_t *input,
+                                              const size_t input_size,
+                                              uint8_t *output,
+                                              const size_t output_size);
+
+/**
+ * \brief Finish a multi-part encryption and compute the authentication tag.
+ *
+ * \param [out] tag               Authentication tag
+ * \param [in]  tag_size          Authentication tag size in bytes
+ *
+ * \retval TFM_HAL_SUCCESS             The operation completed successfully
+ * \retval TFM_HAL_ERROR_INVALID_INPUT Invalid argument
+ * \retval TFM_HAL_ERROR_GENERIC       Failed to compute the tag
+ */
+enum tfm_hal_status_t tfm_hal_its_aead_finish(uint8_t *tag,
+                                              const size_t tag_size);
+
+/**
+ * \brief Finish a multi-part decryption and check the authentication tag.
+ *
+ * \param [in]  tag               Authentication tag
+ * \param [in]  tag_size          Authentication tag size in bytes
+ *
+ * \retval TFM_HAL_SUCCESS             The operation completed successfully
+ * \retval TFM_HAL_ERROR_INVALID_INPUT Invalid argument
+ * \retval TFM_HAL_ERROR_GENERIC       The tag does not match
+ */
+enum tfm_hal_status_t tfm_hal_its_aead_verify(const uint8_t *tag,
+                                              const size_t tag_size);
+
+/**
+ * \brief Abort the multi-part operation in progress, if any, and clear its
+ *        state.
+ */
+void tfm_hal_its_aead_abort(void);
 
 #ifdef __cplusplus
 }
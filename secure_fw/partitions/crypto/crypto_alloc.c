@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -28,9 +28,47 @@ enum {
  */
 #define TFM_CRYPTO_INVALID_HANDLE (0x0u)
 
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+#endif
+
+#if CRYPTO_OPER_POOL_PER_TYPE
+/* A dedicated pool for each operation type, indexed by type - 1 */
+#define TFM_CRYPTO_POOL_NUM     (TFM_CRYPTO_AEAD_OPERATION)
+#define TFM_CRYPTO_OPER_TOTAL_NUM (CRYPTO_CIPHER_OPER_NUM +                 \
+                                   CRYPTO_MAC_OPER_NUM +                    \
+                                   CRYPTO_HASH_OPER_NUM +                   \
+                                   CRYPTO_KEY_DERIVATION_OPER_NUM +         \
+                                   CRYPTO_AEAD_OPER_NUM)
+
+/* Entry indices and the free-list end marker are stored in uint8_t */
+#if (CRYPTO_CIPHER_OPER_NUM > 254) || (CRYPTO_MAC_OPER_NUM > 254) ||      \
+    (CRYPTO_HASH_OPER_NUM > 254) || (CRYPTO_KEY_DERIVATION_OPER_NUM > 254) || \
+    (CRYPTO_AEAD_OPER_NUM > 254)
+#error "Too many concurrent operations in a Crypto operation pool"
+#endif
+#else
+/* A single pool shared by all the operation types */
+#define TFM_CRYPTO_POOL_NUM     1
+#define TFM_CRYPTO_OPER_TOTAL_NUM CRYPTO_CONC_OPER_NUM
+
+/* Entry indices and the free-list end marker are stored in uint8_t */
+#if (CRYPTO_CONC_OPER_NUM > 254)
+#error "Too many concurrent operations in a Crypto operation pool"
+#endif
+#endif
+
 /**
- * \brief A type describing the context stored in Secure memory by the TF-M Crypto
- *        service to support multipart calls on secure side
+ * \brief A handle encodes the pool index above the entry index + 1 in the pool
+ */
+#define TFM_CRYPTO_HANDLE_POOL_SHIFT        8
+#define TFM_CRYPTO_HANDLE_ENTRY_MASK        0xFFu
+#define TFM_CRYPTO_HANDLE(pool, idx)        \
+            (((uint32_t)(pool) << TFM_CRYPTO_HANDLE_POOL_SHIFT) | ((idx) + 1))
+
+/**
+ * \brief A type describing the status of a context stored in Secure memory by
+ *        the TF-M Crypto service to support multipart calls on secure side
  */
 struct tfm_crypto_operation_s {
     uint32_t in_use;                /*!< Indicates if the operation is in use */
@@ -38,30 +76,217 @@ struct tfm_crypto_operation_s {
                                      *   the context
                                      */
     enum tfm_crypto_operation_type type; /*!< Type of the operation */
-    union {
-        psa_cipher_operation_t cipher;    /*!< Cipher operation context */
-        psa_mac_operation_t mac;          /*!< MAC operation context */
-        psa_hash_operation_t hash;        /*!< Hash operation context */
-        psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
-        psa_aead_operation_t aead;        /*!< AEAD operation context */
-    } operation;
+    uint8_t next_free;              /*!< Index of the next free entry in the
+                                     *   pool when not in use
+                                     */
+};
+
+/**
+ * \brief A pool of contexts of the same size, with a free-list of its entries
+ */
+struct tfm_crypto_pool_s {
+    struct tfm_crypto_operation_s *entries; /*!< Status of the entries */
+    uint8_t *contexts;                      /*!< Backend contexts */
+    size_t context_size;                    /*!< Size of a backend context */
+    uint8_t nr_entries;                     /*!< Number of entries */
+    uint8_t free_head;                      /*!< First free entry, or
+                                             *   nr_entries if none
+                                             */
+};
+
+#define TFM_CRYPTO_POOL_DEFINE(name, ctx_type, num)                         \
+    static struct tfm_crypto_operation_s name##_entries[num];               \
+    static ctx_type name##_contexts[num]
+
+#define TFM_CRYPTO_POOL_INIT(name)                                          \
+    {                                                                       \
+        .entries = name##_entries,                                          \
+        .contexts = (uint8_t *)name##_contexts,                             \
+        .context_size = sizeof(name##_contexts[0]),                         \
+        .nr_entries = ARRAY_SIZE(name##_entries),                           \
+    }
+
+#if CRYPTO_OPER_POOL_PER_TYPE
+TFM_CRYPTO_POOL_DEFINE(cipher, psa_cipher_operation_t, CRYPTO_CIPHER_OPER_NUM);
+TFM_CRYPTO_POOL_DEFINE(mac, psa_mac_operation_t, CRYPTO_MAC_OPER_NUM);
+TFM_CRYPTO_POOL_DEFINE(hash, psa_hash_operation_t, CRYPTO_HASH_OPER_NUM);
+TFM_CRYPTO_POOL_DEFINE(key_deriv, psa_key_derivation_operation_t,
+                       CRYPTO_KEY_DERIVATION_OPER_NUM);
+TFM_CRYPTO_POOL_DEFINE(aead, psa_aead_operation_t, CRYPTO_AEAD_OPER_NUM);
+
+static struct tfm_crypto_pool_s pools[TFM_CRYPTO_POOL_NUM] = {
+    TFM_CRYPTO_POOL_INIT(cipher),
+    TFM_CRYPTO_POOL_INIT(mac),
+    TFM_CRYPTO_POOL_INIT(hash),
+    TFM_CRYPTO_POOL_INIT(key_deriv),
+    TFM_CRYPTO_POOL_INIT(aead),
+};
+#else
+/**
+ * \brief Each shared context is sized to the largest operation type
+ */
+union tfm_crypto_operation_u {
+    psa_cipher_operation_t cipher;    /*!< Cipher operation context */
+    psa_mac_operation_t mac;          /*!< MAC operation context */
+    psa_hash_operation_t hash;        /*!< Hash operation context */
+    psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
+    psa_aead_operation_t aead;        /*!< AEAD operation context */
+};
+
+TFM_CRYPTO_POOL_DEFINE(operations, union tfm_crypto_operation_u,
+                       CRYPTO_CONC_OPER_NUM);
+
+static struct tfm_crypto_pool_s pools[TFM_CRYPTO_POOL_NUM] = {
+    TFM_CRYPTO_POOL_INIT(operations),
 };
+#endif /* CRYPTO_OPER_POOL_PER_TYPE */
+
+#if CRYPTO_CONC_OPER_PER_OWNER_NUM > 0
+/**
+ * \brief Number of contexts held by each owner holding at least one
+ */
+static struct tfm_crypto_owner_usage_s {
+    int32_t owner;
+    uint8_t nr_opers;
+} owner_usage[TFM_CRYPTO_OPER_TOTAL_NUM];
+
+static struct tfm_crypto_owner_usage_s *get_owner_usage(int32_t owner)
+{
+    struct tfm_crypto_owner_usage_s *unused = NULL;
+    uint32_t i;
+
+    for (i = 0; i < TFM_CRYPTO_OPER_TOTAL_NUM; i++) {
+        if (owner_usage[i].nr_opers == 0) {
+            if (unused == NULL) {
+                unused = &owner_usage[i];
+            }
+        } else if (owner_usage[i].owner == owner) {
+            return &owner_usage[i];
+        }
+    }
+
+    /* There is always an unused record when the owner holds no context */
+    unused->owner = owner;
+
+    return unused;
+}
+#endif /* CRYPTO_CONC_OPER_PER_OWNER_NUM > 0 */
+
+static struct tfm_crypto_pool_s *get_pool(enum tfm_crypto_operation_type type)
+{
+    if ((type <= TFM_CRYPTO_OPERATION_NONE) ||
+        (type > TFM_CRYPTO_AEAD_OPERATION)) {
+        return NULL;
+    }
+
+#if CRYPTO_OPER_POOL_PER_TYPE
+    return &pools[type - 1];
+#else
+    return &pools[0];
+#endif
+}
+
+/*
+ * \brief Function used to find the entry of a handle
+ *
+ * \param[in]  handle Handle of the context
+ * \param[out] pool   Pool of the context
+ *
+ * \return Index of the entry in the pool, or UINT32_MAX if the handle is
+ *         invalid
+ */
+static uint32_t handle_to_entry(uint32_t handle, struct tfm_crypto_pool_s **pool)
+{
+    uint32_t pool_idx = handle >> TFM_CRYPTO_HANDLE_POOL_SHIFT;
+    uint32_t idx = handle & TFM_CRYPTO_HANDLE_ENTRY_MASK;
+
+    if ((pool_idx >= TFM_CRYPTO_POOL_NUM) || (idx == 0) ||
+        (idx > pools[pool_idx].nr_entries)) {
+        return UINT32_MAX;
+    }
+
+    *pool = &pools[pool_idx];
 
-static struct tfm_crypto_operation_s operations[CRYPTO_CONC_OPER_NUM] = {{0}};
+    return idx - 1;
+}
+
+static void *entry_context(const struct tfm_crypto_pool_s *pool, uint32_t idx)
+{
+    return (void *)&pool->contexts[idx * pool->context_size];
+}
 
 /*
- * \brief Function used to clear the memory associated to a backend context
+ * \brief Function used to release an entry and clear the memory associated to
+ *        its backend context
  *
- * \param[in] index Numerical index in the database of the backend contexts
+ * \param[in] pool Pool of the entry
+ * \param[in] idx  Index of the entry in the pool
  *
  * \return None
  *
  */
-static void memset_operation_context(uint32_t index)
+static void release_entry(struct tfm_crypto_pool_s *pool, uint32_t idx)
 {
+#if CRYPTO_CONC_OPER_PER_OWNER_NUM > 0
+    get_owner_usage(pool->entries[idx].owner)->nr_opers--;
+#endif
+
     /* Clear the contents of the backend context */
-    (void)memset((uint8_t *)&(operations[index].operation), 0,
-                 sizeof(operations[index].operation));
+    (void)memset(entry_context(pool, idx), 0, pool->context_size);
+
+    pool->entries[idx].in_use = TFM_CRYPTO_NOT_IN_USE;
+    pool->entries[idx].type = TFM_CRYPTO_OPERATION_NONE;
+    pool->entries[idx].owner = 0;
+
+    pool->entries[idx].next_free = pool->free_head;
+    pool->free_head = (uint8_t)idx;
+}
+
+/*
+ * \brief Function used to abort the operation of an entry in its backend,
+ *        before the entry is released without the client aborting it
+ *
+ * \param[in] pool Pool of the entry
+ * \param[in] idx  Index of the entry in the pool
+ *
+ * \return None
+ *
+ */
+static void abort_entry(const struct tfm_crypto_pool_s *pool, uint32_t idx)
+{
+    void *ctx = entry_context(pool, idx);
+
+    switch (pool->entries[idx].type) {
+#if CRYPTO_HASH_MODULE_ENABLED
+    case TFM_CRYPTO_HASH_OPERATION:
+        (void)psa_hash_abort((psa_hash_operation_t *)ctx);
+        break;
+#endif
+#if CRYPTO_MAC_MODULE_ENABLED
+    case TFM_CRYPTO_MAC_OPERATION:
+        (void)psa_mac_abort((psa_mac_operation_t *)ctx);
+        break;
+#endif
+#if CRYPTO_CIPHER_MODULE_ENABLED
+    case TFM_CRYPTO_CIPHER_OPERATION:
+        (void)psa_cipher_abort((psa_cipher_operation_t *)ctx);
+        break;
+#endif
+#if CRYPTO_AEAD_MODULE_ENABLED
+    case TFM_CRYPTO_AEAD_OPERATION:
+        (void)psa_aead_abort((psa_aead_operation_t *)ctx);
+        break;
+#endif
+#if CRYPTO_KEY_DERIVATION_MODULE_ENABLED
+    case TFM_CRYPTO_KEY_DERIVATION_OPERATION:
+        (void)psa_key_derivation_abort(
+                                    (psa_key_derivation_operation_t *)ctx);
+        break;
+#endif
+    default:
+        /* No context of a disabled module can have been allocated */
+        break;
+    }
 }
 
 /*!
@@ -73,8 +298,26 @@ static void memset_operation_context(uint32_t index)
 /*!@{*/
 psa_status_t tfm_crypto_init_alloc(void)
 {
-    /* Clear the contents of the local contexts */
-    (void)memset(operations, 0, sizeof(operations));
+    uint32_t i, j;
+
+    for (i = 0; i < TFM_CRYPTO_POOL_NUM; i++) {
+        /* Clear the contents of the local contexts */
+        (void)memset(pools[i].entries, 0,
+                     pools[i].nr_entries * sizeof(pools[i].entries[0]));
+        (void)memset(pools[i].contexts, 0,
+                     pools[i].nr_entries * pools[i].context_size);
+
+        /* Chain all the entries into the free-list */
+        for (j = 0; j < pools[i].nr_entries; j++) {
+            pools[i].entries[j].next_free = (uint8_t)(j + 1);
+        }
+        pools[i].free_head = 0;
+    }
+
+#if CRYPTO_CONC_OPER_PER_OWNER_NUM > 0
+    (void)memset(owner_usage, 0, sizeof(owner_usage));
+#endif
+
     return PSA_SUCCESS;
 }
 
@@ -82,9 +325,13 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
                                         uint32_t *handle,
                                         void **ctx)
 {
-    uint32_t i = 0;
+    struct tfm_crypto_pool_s *pool;
+    uint32_t idx;
     int32_t partition_id = 0;
     psa_status_t status;
+#if CRYPTO_CONC_OPER_PER_OWNER_NUM > 0
+    struct tfm_crypto_owner_usage_s *usage;
+#endif
 
     /* Handle must be initialised before calling a setup function */
     if (*handle != TFM_CRYPTO_INVALID_HANDLE) {
@@ -97,36 +344,54 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
     }
     *ctx = NULL;
 
+    pool = get_pool(type);
+    if (pool == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
     status = tfm_crypto_get_caller_id(&partition_id);
     if (status != PSA_SUCCESS) {
         return status;
     }
 
-    for (i = 0; i < CRYPTO_CONC_OPER_NUM; i++) {
-        if (operations[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            operations[i].in_use = TFM_CRYPTO_IN_USE;
-            operations[i].owner = partition_id;
-            operations[i].type = type;
-            *handle = i + 1;
-            *ctx = (void *) &(operations[i].operation);
-            return PSA_SUCCESS;
-        }
+    idx = pool->free_head;
+    if (idx >= pool->nr_entries) {
+        return PSA_ERROR_NOT_PERMITTED;
     }
 
-    return PSA_ERROR_NOT_PERMITTED;
+#if CRYPTO_CONC_OPER_PER_OWNER_NUM > 0
+    /* Prevent a single owner from exhausting the contexts */
+    usage = get_owner_usage(partition_id);
+    if (usage->nr_opers >= CRYPTO_CONC_OPER_PER_OWNER_NUM) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+    usage->nr_opers++;
+#endif
+
+    pool->free_head = pool->entries[idx].next_free;
+
+    pool->entries[idx].in_use = TFM_CRYPTO_IN_USE;
+    pool->entries[idx].owner = partition_id;
+    pool->entries[idx].type = type;
+    *handle = TFM_CRYPTO_HANDLE(pool - pools, idx);
+    *ctx = entry_context(pool, idx);
+
+    return PSA_SUCCESS;
 }
 
 psa_status_t tfm_crypto_operation_release(uint32_t *handle)
 {
     uint32_t h_val = *handle;
+    struct tfm_crypto_pool_s *pool = NULL;
+    uint32_t idx;
     int32_t partition_id = 0;
     psa_status_t status;
 
     /* Handle shall be cleaned up always at first */
     *handle = TFM_CRYPTO_INVALID_HANDLE;
 
-    if ((h_val == TFM_CRYPTO_INVALID_HANDLE) ||
-        (h_val > CRYPTO_CONC_OPER_NUM)) {
+    idx = handle_to_entry(h_val, &pool);
+    if (idx == UINT32_MAX) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
@@ -135,13 +400,10 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
         return status;
     }
 
-    if ((operations[h_val - 1].in_use == TFM_CRYPTO_IN_USE) &&
-        (operations[h_val - 1].owner == partition_id)) {
+    if ((pool->entries[idx].in_use == TFM_CRYPTO_IN_USE) &&
+        (pool->entries[idx].owner == partition_id)) {
 
-        memset_operation_context(h_val - 1);
-        operations[h_val - 1].in_use = TFM_CRYPTO_NOT_IN_USE;
-        operations[h_val - 1].type = TFM_CRYPTO_OPERATION_NONE;
-        operations[h_val - 1].owner = 0;
+        release_entry(pool, idx);
 
         return PSA_SUCCESS;
     }
@@ -149,15 +411,32 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
     return PSA_ERROR_INVALID_ARGUMENT;
 }
 
+void tfm_crypto_operation_release_all(int32_t owner)
+{
+    uint32_t i, j;
+
+    for (i = 0; i < TFM_CRYPTO_POOL_NUM; i++) {
+        for (j = 0; j < pools[i].nr_entries; j++) {
+            if ((pools[i].entries[j].in_use == TFM_CRYPTO_IN_USE) &&
+                (pools[i].entries[j].owner == owner)) {
+                abort_entry(&pools[i], j);
+                release_entry(&pools[i], j);
+            }
+        }
+    }
+}
+
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx)
 {
+    struct tfm_crypto_pool_s *pool = NULL;
+    uint32_t idx;
     int32_t partition_id = 0;
     psa_status_t status;
 
-    if ((handle == TFM_CRYPTO_INVALID_HANDLE) ||
-        (handle > CRYPTO_CONC_OPER_NUM)) {
+    idx = handle_to_entry(handle, &pool);
+    if (idx == UINT32_MAX) {
         return PSA_ERROR_BAD_STATE;
     }
 
@@ -170,10 +449,10 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
         return status;
     }
 
-    if ((operations[handle - 1].in_use == TFM_CRYPTO_IN_USE) &&
-        (operations[handle - 1].type == type) &&
-        (operations[handle - 1].owner == partition_id)) {
-        *ctx = (void *) &(operations[handle - 1].operation);
+    if ((pool->entries[idx].in_use == TFM_CRYPTO_IN_USE) &&
+        (pool->entries[idx].type == type) &&
+        (pool->entries[idx].owner == partition_id)) {
+        *ctx = entry_context(pool, idx);
         return PSA_SUCCESS;
     }
 
@@ -5,10 +5,15 @@
  *
  */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "config_tfm.h"
+
+/* The hash suspend state is exported from the Mbed TLS operation contexts */
+#define MBEDTLS_ALLOW_PRIVATE_ACCESS
 #include "tfm_mbedcrypto_include.h"
 
 #include "tfm_crypto_api.h"
@@ -21,6 +26,314 @@
 
 /*!@{*/
 #if CRYPTO_HASH_MODULE_ENABLED
+/* Driver ID of the Mbed TLS software implementation of the hash operations */
+#define TFM_CRYPTO_HASH_BUILTIN_DRIVER_ID    1
+
+#if (defined(MBEDTLS_PSA_BUILTIN_ALG_SHA_1) && !defined(MBEDTLS_SHA1_ALT))
+#define TFM_CRYPTO_HASH_SUSPEND_SHA_1
+#endif
+#if ((defined(MBEDTLS_PSA_BUILTIN_ALG_SHA_224) ||     \
+      defined(MBEDTLS_PSA_BUILTIN_ALG_SHA_256)) &&    \
+     !defined(MBEDTLS_SHA256_ALT))
+#define TFM_CRYPTO_HASH_SUSPEND_SHA_256
+#endif
+#if ((defined(MBEDTLS_PSA_BUILTIN_ALG_SHA_384) ||     \
+      defined(MBEDTLS_PSA_BUILTIN_ALG_SHA_512)) &&    \
+     !defined(MBEDTLS_SHA512_ALT))
+#define TFM_CRYPTO_HASH_SUSPEND_SHA_512
+#endif
+
+/* Size of the algorithm field of the hash suspend state */
+#define TFM_CRYPTO_HASH_SUSPEND_ALG_LEN      4
+
+/**
+ * \brief Get the layout of the hash suspend state of an algorithm
+ *
+ * \param[in]  alg       Hash algorithm
+ * \param[out] len_field Size of the input length field
+ * \param[out] state_len Size of the intermediate hash state field
+ * \param[out] block_len Size of the hash block
+ *
+ * \return false if the algorithm cannot be suspended, true otherwise
+ */
+static bool hash_suspend_layout(psa_algorithm_t alg, size_t *len_field,
+                                size_t *state_len, size_t *block_len)
+{
+    switch (alg) {
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_1
+    case PSA_ALG_SHA_1:
+        *len_field = 8;
+        *state_len = 20;
+        *block_len = 64;
+        return true;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_256
+    case PSA_ALG_SHA_224:
+    case PSA_ALG_SHA_256:
+        *len_field = 8;
+        *state_len = 32;
+        *block_len = 64;
+        return true;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_512
+    case PSA_ALG_SHA_384:
+    case PSA_ALG_SHA_512:
+        *len_field = 16;
+        *state_len = 64;
+        *block_len = 128;
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static void put_be(uint8_t *p, uint64_t val, size_t len)
+{
+    while (len > 0) {
+        len--;
+        p[len] = (uint8_t)val;
+        val >>= 8;
+    }
+}
+
+static uint64_t get_be(const uint8_t *p, size_t len)
+{
+    uint64_t val = 0;
+
+    while (len > 0) {
+        val = (val << 8) | *p++;
+        len--;
+    }
+
+    return val;
+}
+
+/**
+ * \brief Export the state of a hash operation in the hash suspend state format
+ *        of the PSA Crypto API 1.1, i.e. the algorithm, the length of the
+ *        input processed, the intermediate hash state and the unprocessed
+ *        input, all the integers being encoded in big-endian.
+ *
+ * \note Only the operations run by the Mbed TLS software implementation of
+ *       SHA-1, SHA-224, SHA-256, SHA-384 and SHA-512 can be suspended.
+ */
+static psa_status_t tfm_crypto_hash_suspend(psa_hash_operation_t *operation,
+                                            uint8_t *hash_state,
+                                            size_t hash_state_size,
+                                            size_t *hash_state_length)
+{
+    const mbedtls_psa_hash_operation_t *ctx;
+    psa_algorithm_t alg;
+    size_t len_field, state_field, block_len, partial_len;
+    uint64_t total = 0, total_high = 0;
+    const unsigned char *buffer = NULL;
+    uint8_t *p;
+    uint32_t i;
+
+    if (operation->MBEDTLS_PRIVATE(id) != TFM_CRYPTO_HASH_BUILTIN_DRIVER_ID) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    ctx = &operation->MBEDTLS_PRIVATE(ctx).mbedtls_ctx;
+    alg = ctx->MBEDTLS_PRIVATE(alg);
+    if (!hash_suspend_layout(alg, &len_field, &state_field, &block_len)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    /* Require room for the largest unprocessed input of the algorithm */
+    if (hash_state_size < TFM_CRYPTO_HASH_SUSPEND_ALG_LEN + len_field +
+                          state_field + block_len - 1) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    p = hash_state + TFM_CRYPTO_HASH_SUSPEND_ALG_LEN + len_field;
+
+    switch (alg) {
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_1
+    case PSA_ALG_SHA_1:
+    {
+        const mbedtls_sha1_context *sha1 = &ctx->MBEDTLS_PRIVATE(ctx).sha1;
+
+        total = ((uint64_t)sha1->MBEDTLS_PRIVATE(total)[1] << 32) |
+                sha1->MBEDTLS_PRIVATE(total)[0];
+        for (i = 0; i < 5; i++) {
+            put_be(&p[i * 4], sha1->MBEDTLS_PRIVATE(state)[i], 4);
+        }
+        buffer = sha1->MBEDTLS_PRIVATE(buffer);
+    }
+    break;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_256
+    case PSA_ALG_SHA_224:
+    case PSA_ALG_SHA_256:
+    {
+        const mbedtls_sha256_context *sha256 =
+                                        &ctx->MBEDTLS_PRIVATE(ctx).sha256;
+
+        total = ((uint64_t)sha256->MBEDTLS_PRIVATE(total)[1] << 32) |
+                sha256->MBEDTLS_PRIVATE(total)[0];
+        for (i = 0; i < 8; i++) {
+            put_be(&p[i * 4], sha256->MBEDTLS_PRIVATE(state)[i], 4);
+        }
+        buffer = sha256->MBEDTLS_PRIVATE(buffer);
+    }
+    break;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_512
+    case PSA_ALG_SHA_384:
+    case PSA_ALG_SHA_512:
+    {
+        const mbedtls_sha512_context *sha512 =
+                                        &ctx->MBEDTLS_PRIVATE(ctx).sha512;
+
+        total = sha512->MBEDTLS_PRIVATE(total)[0];
+        total_high = sha512->MBEDTLS_PRIVATE(total)[1];
+        for (i = 0; i < 8; i++) {
+            put_be(&p[i * 8], sha512->MBEDTLS_PRIVATE(state)[i], 8);
+        }
+        buffer = sha512->MBEDTLS_PRIVATE(buffer);
+    }
+    break;
+#endif
+    default:
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    put_be(hash_state, alg, TFM_CRYPTO_HASH_SUSPEND_ALG_LEN);
+    if (len_field > sizeof(uint64_t)) {
+        put_be(&hash_state[TFM_CRYPTO_HASH_SUSPEND_ALG_LEN],
+               total_high, len_field - sizeof(uint64_t));
+    }
+    put_be(p - sizeof(uint64_t), total, sizeof(uint64_t));
+
+    /* The input which does not fill a block is not processed yet */
+    partial_len = total % block_len;
+    p += state_field;
+    (void)memcpy(p, buffer, partial_len);
+    p += partial_len;
+
+    *hash_state_length = p - hash_state;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Set up a hash operation from a state exported by
+ *        \ref tfm_crypto_hash_suspend
+ */
+static psa_status_t tfm_crypto_hash_resume(psa_hash_operation_t *operation,
+                                           const uint8_t *hash_state,
+                                           size_t hash_state_length)
+{
+    mbedtls_psa_hash_operation_t *ctx;
+    psa_algorithm_t alg;
+    size_t len_field, state_field, block_len, header_len, partial_len;
+    uint64_t total, total_high = 0;
+    const uint8_t *p;
+    psa_status_t status;
+    uint32_t i;
+
+    if (hash_state_length < TFM_CRYPTO_HASH_SUSPEND_ALG_LEN) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    alg = (psa_algorithm_t)get_be(hash_state,
+                                  TFM_CRYPTO_HASH_SUSPEND_ALG_LEN);
+    if (!PSA_ALG_IS_HASH(alg)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!hash_suspend_layout(alg, &len_field, &state_field, &block_len)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    header_len = TFM_CRYPTO_HASH_SUSPEND_ALG_LEN + len_field + state_field;
+    if (hash_state_length < header_len) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    p = &hash_state[TFM_CRYPTO_HASH_SUSPEND_ALG_LEN];
+    if (len_field > sizeof(uint64_t)) {
+        total_high = get_be(p, len_field - sizeof(uint64_t));
+    }
+    p += len_field;
+    total = get_be(p - sizeof(uint64_t), sizeof(uint64_t));
+
+    partial_len = hash_state_length - header_len;
+    if (partial_len != total % block_len) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    status = psa_hash_setup(operation, alg);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (operation->MBEDTLS_PRIVATE(id) != TFM_CRYPTO_HASH_BUILTIN_DRIVER_ID) {
+        (void)psa_hash_abort(operation);
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    ctx = &operation->MBEDTLS_PRIVATE(ctx).mbedtls_ctx;
+
+    switch (alg) {
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_1
+    case PSA_ALG_SHA_1:
+    {
+        mbedtls_sha1_context *sha1 = &ctx->MBEDTLS_PRIVATE(ctx).sha1;
+
+        sha1->MBEDTLS_PRIVATE(total)[0] = (uint32_t)total;
+        sha1->MBEDTLS_PRIVATE(total)[1] = (uint32_t)(total >> 32);
+        for (i = 0; i < 5; i++) {
+            sha1->MBEDTLS_PRIVATE(state)[i] = (uint32_t)get_be(&p[i * 4], 4);
+        }
+        (void)memcpy(sha1->MBEDTLS_PRIVATE(buffer), &p[state_field],
+                     partial_len);
+    }
+    break;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_256
+    case PSA_ALG_SHA_224:
+    case PSA_ALG_SHA_256:
+    {
+        mbedtls_sha256_context *sha256 = &ctx->MBEDTLS_PRIVATE(ctx).sha256;
+
+        sha256->MBEDTLS_PRIVATE(total)[0] = (uint32_t)total;
+        sha256->MBEDTLS_PRIVATE(total)[1] = (uint32_t)(total >> 32);
+        for (i = 0; i < 8; i++) {
+            sha256->MBEDTLS_PRIVATE(state)[i] =
+                                            (uint32_t)get_be(&p[i * 4], 4);
+        }
+        (void)memcpy(sha256->MBEDTLS_PRIVATE(buffer), &p[state_field],
+                     partial_len);
+    }
+    break;
+#endif
+#ifdef TFM_CRYPTO_HASH_SUSPEND_SHA_512
+    case PSA_ALG_SHA_384:
+    case PSA_ALG_SHA_512:
+    {
+        mbedtls_sha512_context *sha512 = &ctx->MBEDTLS_PRIVATE(ctx).sha512;
+
+        sha512->MBEDTLS_PRIVATE(total)[0] = total;
+        sha512->MBEDTLS_PRIVATE(total)[1] = total_high;
+        for (i = 0; i < 8; i++) {
+            sha512->MBEDTLS_PRIVATE(state)[i] = get_be(&p[i * 8], 8);
+        }
+        (void)memcpy(sha512->MBEDTLS_PRIVATE(buffer), &p[state_field],
+                     partial_len);
+    }
+    break;
+#endif
+    default:
+        (void)psa_hash_abort(operation);
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
                                        psa_outvec out_vec[])
 {
@@ -62,7 +375,8 @@ psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
 #endif
     }
 
-    if (sid == TFM_CRYPTO_HASH_SETUP_SID) {
+    if ((sid == TFM_CRYPTO_HASH_SETUP_SID) ||
+        (sid == TFM_CRYPTO_HASH_RESUME_SID)) {
         p_handle = out_vec[0].base;
         *p_handle = iov->op_handle;
         status = tfm_crypto_operation_alloc(TFM_CRYPTO_HASH_OPERATION,
@@ -74,9 +388,10 @@ psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
                                              (void **)&operation);
         if ((sid == TFM_CRYPTO_HASH_FINISH_SID) ||
             (sid == TFM_CRYPTO_HASH_VERIFY_SID) ||
+            (sid == TFM_CRYPTO_HASH_SUSPEND_SID) ||
             (sid == TFM_CRYPTO_HASH_ABORT_SID)) {
             /*
-             * finish()/abort() interface put handle in out_vec[0].
+             * finish()/suspend()/abort() interface put handle in out_vec[0].
              * Therefore, out_vec[0] shall be specially set to original handle
              * value. Otherwise, the garbage data in message out_vec[0] may
              * override the original handle value in client, after lookup fails.
@@ -165,6 +480,34 @@ psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
         }
     }
     break;
+    case TFM_CRYPTO_HASH_SUSPEND_SID:
+    {
+        uint8_t *hash_state = out_vec[1].base;
+        size_t hash_state_size = out_vec[1].len;
+
+        status = tfm_crypto_hash_suspend(operation, hash_state,
+                                         hash_state_size, &out_vec[1].len);
+        if (status == PSA_SUCCESS) {
+            /* The suspended operation becomes inactive */
+            (void)psa_hash_abort(operation);
+            goto release_operation_and_return;
+        } else {
+            out_vec[1].len = 0;
+        }
+    }
+    break;
+    case TFM_CRYPTO_HASH_RESUME_SID:
+    {
+        const uint8_t *hash_state = in_vec[1].base;
+        size_t hash_state_length = in_vec[1].len;
+
+        status = tfm_crypto_hash_resume(operation, hash_state,
+                                        hash_state_length);
+        if (status != PSA_SUCCESS) {
+            goto release_operation_and_return;
+        }
+    }
+    break;
     default:
         return PSA_ERROR_NOT_SUPPORTED;
     }
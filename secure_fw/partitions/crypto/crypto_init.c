@@ -18,6 +18,7 @@
 #include "tfm_plat_crypto_keys.h"
 
 #include "crypto_library.h"
+#include "crypto_key_cache.h"
 
 #if CRYPTO_NV_SEED
 #include "tfm_plat_crypto_nv_seed.h"
@@ -315,6 +316,8 @@ psa_status_t tfm_crypto_init(void)
         return status;
     }
 
+    tfm_crypto_key_cache_init();
+
     return PSA_SUCCESS;
 }
 
@@ -331,6 +334,140 @@ psa_status_t tfm_crypto_sfn(const psa_msg_t *msg)
     return PSA_ERROR_GENERIC_ERROR;
 }
 
+/**
+ * \brief Process a batch of updates of multi-part operations, dispatching each
+ *        of them as if it had been requested by a call of its own
+ *
+ * \param[in]  in_vec  in_vec[1] holds the updates, in_vec[2] their inputs
+ * \param[out] out_vec out_vec[0] holds the results, out_vec[1] the outputs
+ *
+ * \return PSA_SUCCESS if the batch could be parsed, the status of each update
+ *         being returned in its result
+ */
+static psa_status_t tfm_crypto_batch_interface(psa_invec in_vec[],
+                                               psa_outvec out_vec[])
+{
+    const struct tfm_crypto_batch_update *updates = in_vec[1].base;
+    struct tfm_crypto_batch_result *results = out_vec[0].base;
+    const uint8_t *input = in_vec[2].base;
+    uint8_t *output = out_vec[1].base;
+    size_t nr_updates = in_vec[1].len / sizeof(*updates);
+    size_t input_length = 0, output_size = 0, output_length = 0, i;
+    struct tfm_crypto_batch_update update;
+    struct tfm_crypto_pack_iovec iov;
+    psa_invec update_in_vec[2];
+    psa_outvec update_out_vec[1];
+    bool is_valid = true;
+
+    if ((nr_updates == 0) ||
+        (in_vec[1].len != nr_updates * sizeof(*updates)) ||
+        (out_vec[0].len < nr_updates * sizeof(*results))) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (i = 0; i < nr_updates; i++) {
+        /* The updates can be mapped from the client memory, use a copy */
+        update = updates[i];
+
+        switch (update.function_id) {
+        case TFM_CRYPTO_HASH_UPDATE_SID:
+        case TFM_CRYPTO_MAC_UPDATE_SID:
+        case TFM_CRYPTO_CIPHER_UPDATE_SID:
+        case TFM_CRYPTO_AEAD_UPDATE_AD_SID:
+        case TFM_CRYPTO_AEAD_UPDATE_SID:
+            break;
+        default:
+            is_valid = false;
+            break;
+        }
+
+        /*
+         * Once an update is malformed, the data of the following ones cannot
+         * be located, so none of them is processed.
+         */
+        if (!is_valid ||
+            (update.input_length > in_vec[2].len - input_length) ||
+            (update.output_size > out_vec[1].len - output_size)) {
+            is_valid = false;
+            results[i].status = PSA_ERROR_INVALID_ARGUMENT;
+            results[i].output_length = 0;
+            continue;
+        }
+
+        (void)memset(&iov, 0, sizeof(iov));
+        iov.function_id = update.function_id;
+        iov.op_handle = update.op_handle;
+
+        update_in_vec[0].base = &iov;
+        update_in_vec[0].len = sizeof(iov);
+        update_in_vec[1].base = &input[input_length];
+        update_in_vec[1].len = update.input_length;
+        update_out_vec[0].base = &output[output_size];
+        update_out_vec[0].len = update.output_size;
+
+        results[i].status = tfm_crypto_api_dispatcher(update_in_vec, 2,
+                                                      update_out_vec, 1);
+        if ((results[i].status == PSA_SUCCESS) &&
+            ((update.function_id == TFM_CRYPTO_CIPHER_UPDATE_SID) ||
+             (update.function_id == TFM_CRYPTO_AEAD_UPDATE_SID))) {
+            results[i].output_length = update_out_vec[0].len;
+            if (update_out_vec[0].len > 0) {
+                output_length = output_size + update_out_vec[0].len;
+            }
+        } else {
+            results[i].output_length = 0;
+        }
+
+        input_length += update.input_length;
+        output_size += update.output_size;
+    }
+
+    out_vec[0].len = nr_updates * sizeof(*results);
+    out_vec[1].len = output_length;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Abort and release the multi-part operations left by a client which
+ *        has terminated
+ *
+ * \param[in] in_vec in_vec[1] holds the ID of the client
+ *
+ * \return PSA_SUCCESS if the operations of the client have been released,
+ *         PSA_ERROR_NOT_PERMITTED if the caller cannot release them
+ */
+static psa_status_t tfm_crypto_client_interface(psa_invec in_vec[])
+{
+    const struct tfm_crypto_pack_iovec *iov = in_vec[0].base;
+    int32_t client_id, caller_id = 0;
+    psa_status_t status;
+
+    if ((iov->function_id != TFM_CRYPTO_RELEASE_CLIENT_OPERATIONS_SID) ||
+        (in_vec[1].len != sizeof(client_id))) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+    (void)memcpy(&client_id, in_vec[1].base, sizeof(client_id));
+
+    status = tfm_crypto_get_caller_id(&caller_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /*
+     * A secure partition can only release its own operations. The Non-secure
+     * OS assigns the Non-secure client IDs, so it can release the operations
+     * of any Non-secure client, but none of a secure partition.
+     */
+    if ((client_id != caller_id) && !((caller_id < 0) && (client_id < 0))) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    tfm_crypto_operation_release_all(client_id);
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t tfm_crypto_api_dispatcher(psa_invec in_vec[],
                                        size_t in_len,
                                        psa_outvec out_vec[],
@@ -350,7 +487,9 @@ psa_status_t tfm_crypto_api_dispatcher(psa_invec in_vec[],
     group_id = TFM_CRYPTO_GET_GROUP_ID(iov->function_id);
 
     is_key_required = !((group_id == TFM_CRYPTO_GROUP_ID_HASH) ||
-                        (group_id == TFM_CRYPTO_GROUP_ID_RANDOM));
+                        (group_id == TFM_CRYPTO_GROUP_ID_RANDOM) ||
+                        (group_id == TFM_CRYPTO_GROUP_ID_BATCH) ||
+                        (group_id == TFM_CRYPTO_GROUP_ID_CLIENT));
 
     if (is_key_required) {
         status = tfm_crypto_get_caller_id(&caller_id);
@@ -388,6 +527,10 @@ psa_status_t tfm_crypto_api_dispatcher(psa_invec in_vec[],
                                                    &encoded_key);
     case TFM_CRYPTO_GROUP_ID_RANDOM:
         return tfm_crypto_random_interface(in_vec, out_vec);
+    case TFM_CRYPTO_GROUP_ID_BATCH:
+        return tfm_crypto_batch_interface(in_vec, out_vec);
+    case TFM_CRYPTO_GROUP_ID_CLIENT:
+        return tfm_crypto_client_interface(in_vec);
     default:
         LOG_ERRFMT("[ERR][Crypto] Unsupported request!\r\n");
         return PSA_ERROR_NOT_SUPPORTED;
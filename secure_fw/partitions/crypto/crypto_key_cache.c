@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "crypto_key_cache.h"
+#include "tfm_sp_log.h"
+/*
+ * The PSA Crypto headers must not be included here: crypto_spe.h redirects
+ * the ITS functions to this file, which calls the actual ITS client.
+ */
+#include "psa/internal_trusted_storage.h"
+
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+/**
+ * \brief An entry of the cache, holding a whole ITS object
+ */
+struct key_cache_entry_t {
+    psa_storage_uid_t uid;              /*!< UID of the ITS object */
+    uint32_t last_use;                  /*!< Value of the use counter when the
+                                         *   entry was last used
+                                         */
+    uint32_t size;                      /*!< Size of the object */
+    psa_storage_create_flags_t flags;   /*!< Creation flags of the object */
+    bool in_use;                        /*!< The entry holds an object */
+    bool pinned;                        /*!< The entry cannot be evicted */
+    uint8_t data[CRYPTO_KEY_CACHE_ENTRY_SIZE]; /*!< Data of the object */
+};
+
+static struct key_cache_entry_t key_cache[CRYPTO_KEY_CACHE_SLOT_NUM];
+static uint32_t use_counter;
+static struct tfm_crypto_key_cache_stats_t cache_stats;
+
+#ifdef CRYPTO_KEY_CACHE_PINNED_UIDS
+/* The keys pinned in the cache from boot */
+static const psa_storage_uid_t pinned_uids[] = {CRYPTO_KEY_CACHE_PINNED_UIDS};
+#endif
+
+static bool key_cache_is_pinned_uid(psa_storage_uid_t uid)
+{
+#ifdef CRYPTO_KEY_CACHE_PINNED_UIDS
+    uint32_t i;
+
+    for (i = 0; i < sizeof(pinned_uids) / sizeof(pinned_uids[0]); i++) {
+        if (pinned_uids[i] == uid) {
+            return true;
+        }
+    }
+#else
+    (void)uid;
+#endif
+
+    return false;
+}
+
+static struct key_cache_entry_t *key_cache_find(psa_storage_uid_t uid)
+{
+    uint32_t i;
+
+    for (i = 0; i < CRYPTO_KEY_CACHE_SLOT_NUM; i++) {
+        if (key_cache[i].in_use && (key_cache[i].uid == uid)) {
+            key_cache[i].last_use = ++use_counter;
+            return &key_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void key_cache_invalidate(struct key_cache_entry_t *entry)
+{
+    /* Do not leave the key material behind */
+    (void)memset(entry, 0, sizeof(*entry));
+}
+
+/*
+ * \brief Gets an entry to cache an object, evicting the least recently used
+ *        one if none is free
+ *
+ * \return The entry, or NULL if all the entries are pinned
+ */
+static struct key_cache_entry_t *key_cache_alloc(void)
+{
+    struct key_cache_entry_t *victim = NULL;
+    uint32_t i;
+
+    for (i = 0; i < CRYPTO_KEY_CACHE_SLOT_NUM; i++) {
+        if (!key_cache[i].in_use) {
+            return &key_cache[i];
+        }
+        if (!key_cache[i].pinned &&
+            ((victim == NULL) ||
+             ((use_counter - key_cache[i].last_use) >
+              (use_counter - victim->last_use)))) {
+            victim = &key_cache[i];
+        }
+    }
+
+    if (victim != NULL) {
+        key_cache_invalidate(victim);
+        cache_stats.evictions++;
+
+        /* Evictions are the sign of a cache too small for the keys in use */
+        LOG_DBGFMT("[DBG][Crypto] Key cache: %u hits, %u misses, "
+                   "%u evictions, %u uncacheable\r\n", cache_stats.hits,
+                   cache_stats.misses, cache_stats.evictions,
+                   cache_stats.uncacheable);
+    }
+
+    return victim;
+}
+
+static void key_cache_fill(struct key_cache_entry_t *entry,
+                           psa_storage_uid_t uid, size_t size,
+                           psa_storage_create_flags_t flags)
+{
+    entry->uid = uid;
+    entry->size = (uint32_t)size;
+    entry->flags = flags;
+    entry->in_use = true;
+    entry->last_use = ++use_counter;
+}
+
+/*
+ * \brief Reads a whole object from ITS into the cache
+ *
+ * \param[in]  uid     UID of the object
+ * \param[out] p_entry Entry holding the object
+ * \param[out] p_info  Metadata of the object, also valid when the object
+ *                     cannot be cached, i.e. PSA_ERROR_INSUFFICIENT_MEMORY
+ */
+static psa_status_t key_cache_load(psa_storage_uid_t uid,
+                                   struct key_cache_entry_t **p_entry,
+                                   struct psa_storage_info_t *p_info)
+{
+    struct key_cache_entry_t *entry;
+    size_t data_length;
+    psa_status_t status;
+
+    status = psa_its_get_info(uid, p_info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (p_info->size > CRYPTO_KEY_CACHE_ENTRY_SIZE) {
+        cache_stats.uncacheable++;
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    entry = key_cache_alloc();
+    if (entry == NULL) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    status = psa_its_get(uid, 0, p_info->size, entry->data, &data_length);
+    if ((status != PSA_SUCCESS) || (data_length != p_info->size)) {
+        key_cache_invalidate(entry);
+        return (status != PSA_SUCCESS) ? status : PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    key_cache_fill(entry, uid, p_info->size, p_info->flags);
+    *p_entry = entry;
+
+    return PSA_SUCCESS;
+}
+#endif /* CRYPTO_KEY_CACHE_SLOT_NUM > 0 */
+
+void tfm_crypto_key_cache_init(void)
+{
+#if (CRYPTO_KEY_CACHE_SLOT_NUM > 0) && defined(CRYPTO_KEY_CACHE_PINNED_UIDS)
+    psa_status_t status;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(pinned_uids) / sizeof(pinned_uids[0]); i++) {
+        /* A key which is not provisioned yet is pinned when it is stored */
+        status = tfm_crypto_key_cache_pin(pinned_uids[i]);
+        if ((status != PSA_SUCCESS) && (status != PSA_ERROR_DOES_NOT_EXIST)) {
+            LOG_ERRFMT("[ERR][Crypto] Cannot pin key %u in the key cache: "
+                       "%d\r\n", i, status);
+        }
+    }
+#endif
+}
+
+psa_status_t tfm_crypto_key_cache_its_set(psa_storage_uid_t uid,
+                                          size_t data_length,
+                                          const void *p_data,
+                                          psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+    struct psa_storage_info_t info;
+    bool pinned = false;
+
+    /* Drop the cached copy first in case the write fails halfway */
+    if (entry != NULL) {
+        pinned = entry->pinned;
+        key_cache_invalidate(entry);
+    }
+#endif
+
+    status = psa_its_set(uid, data_length, p_data, create_flags);
+
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    if ((status == PSA_SUCCESS) &&
+        (data_length <= CRYPTO_KEY_CACHE_ENTRY_SIZE)) {
+        /* A new key is likely to be used soon */
+        entry = key_cache_alloc();
+        if (entry != NULL) {
+            (void)memcpy(entry->data, p_data, data_length);
+            key_cache_fill(entry, uid, data_length, create_flags);
+            /* A configured key is pinned once it has been provisioned */
+            entry->pinned = pinned || key_cache_is_pinned_uid(uid);
+        }
+    } else if (pinned && (key_cache_load(uid, &entry, &info) == PSA_SUCCESS)) {
+        entry->pinned = true;
+    }
+#endif
+
+    return status;
+}
+
+psa_status_t tfm_crypto_key_cache_its_get(psa_storage_uid_t uid,
+                                          size_t data_offset,
+                                          size_t data_size,
+                                          void *p_data,
+                                          size_t *p_data_length)
+{
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    struct key_cache_entry_t *entry;
+
+    if (p_data_length == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /*
+     * The keys are loaded in the cache when Mbed Crypto reads their size,
+     * which it does before reading them. A key which is not cached then
+     * cannot be cached, read it directly.
+     */
+    entry = key_cache_find(uid);
+    if (entry == NULL) {
+        cache_stats.misses++;
+        return psa_its_get(uid, data_offset, data_size, p_data,
+                           p_data_length);
+    }
+
+    cache_stats.hits++;
+
+    if (data_offset > entry->size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    *p_data_length = entry->size - data_offset;
+    if (*p_data_length > data_size) {
+        *p_data_length = data_size;
+    }
+    (void)memcpy(p_data, &entry->data[data_offset], *p_data_length);
+
+    return PSA_SUCCESS;
+#else
+    return psa_its_get(uid, data_offset, data_size, p_data, p_data_length);
+#endif
+}
+
+psa_status_t tfm_crypto_key_cache_its_get_info(psa_storage_uid_t uid,
+                                               struct psa_storage_info_t *p_info)
+{
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    struct key_cache_entry_t *entry;
+    psa_status_t status;
+
+    if (p_info == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /*
+     * Mbed Crypto reads the size of a key before reading the key, so loading
+     * the key here serves the read of the key from the cache.
+     */
+    entry = key_cache_find(uid);
+    if (entry == NULL) {
+        cache_stats.misses++;
+        status = key_cache_load(uid, &entry, p_info);
+        if (status == PSA_ERROR_INSUFFICIENT_MEMORY) {
+            /* The key cannot be cached, but its metadata has been read */
+            return PSA_SUCCESS;
+        }
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    } else {
+        cache_stats.hits++;
+    }
+
+    p_info->capacity = entry->size;
+    p_info->size = entry->size;
+    p_info->flags = entry->flags;
+
+    return PSA_SUCCESS;
+#else
+    return psa_its_get_info(uid, p_info);
+#endif
+}
+
+psa_status_t tfm_crypto_key_cache_its_remove(psa_storage_uid_t uid)
+{
+    psa_status_t status;
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+#endif
+
+    status = psa_its_remove(uid);
+
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    if ((entry != NULL) &&
+        ((status == PSA_SUCCESS) || (status == PSA_ERROR_DOES_NOT_EXIST))) {
+        key_cache_invalidate(entry);
+    }
+#endif
+
+    return status;
+}
+
+psa_status_t tfm_crypto_key_cache_pin(psa_storage_uid_t uid)
+{
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+    struct psa_storage_info_t info;
+    psa_status_t status;
+
+    if (entry == NULL) {
+        status = key_cache_load(uid, &entry, &info);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+
+    entry->pinned = true;
+
+    return PSA_SUCCESS;
+#else
+    (void)uid;
+
+    return PSA_ERROR_INSUFFICIENT_MEMORY;
+#endif
+}
+
+psa_status_t tfm_crypto_key_cache_unpin(psa_storage_uid_t uid)
+{
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    uint32_t i;
+
+    for (i = 0; i < CRYPTO_KEY_CACHE_SLOT_NUM; i++) {
+        if (key_cache[i].in_use && key_cache[i].pinned &&
+            (key_cache[i].uid == uid)) {
+            key_cache[i].pinned = false;
+            return PSA_SUCCESS;
+        }
+    }
+#else
+    (void)uid;
+#endif
+
+    return PSA_ERROR_DOES_NOT_EXIST;
+}
+
+void tfm_crypto_key_cache_get_stats(struct tfm_crypto_key_cache_stats_t *stats)
+{
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+    *stats = cache_stats;
+#else
+    (void)memset(stats, 0, sizeof(*stats));
+#endif
+}
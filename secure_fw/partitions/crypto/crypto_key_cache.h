@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __CRYPTO_KEY_CACHE_H__
+#define __CRYPTO_KEY_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psa/error.h"
+#include "psa/storage_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief The UID of the ITS object holding a persistent key, as chosen by
+ *        Mbed Crypto when the key IDs encode their owner
+ */
+#define TFM_CRYPTO_KEY_CACHE_UID(owner, key_id) \
+            (((psa_storage_uid_t)(uint32_t)(owner) << 32) | (uint32_t)(key_id))
+
+/**
+ * \brief Usage statistics of the persistent key cache
+ */
+struct tfm_crypto_key_cache_stats_t {
+    uint32_t hits;          /*!< Lookups of keys found in the cache */
+    uint32_t misses;        /*!< Lookups of keys loaded from ITS */
+    uint32_t evictions;     /*!< Keys evicted to cache other keys */
+    uint32_t uncacheable;   /*!< Lookups of keys larger than an entry */
+};
+
+/**
+ * \brief Pins the keys of CRYPTO_KEY_CACHE_PINNED_UIDS in the cache. Called
+ *        by the Crypto partition at initialisation, once ITS is available.
+ */
+void tfm_crypto_key_cache_init(void);
+
+/**
+ * \brief Replacements of the ITS client functions for the persistent key
+ *        storage of Mbed Crypto, serving the reads from the cache and
+ *        writing through it.
+ *
+ * \note The prototypes follow the ones of psa/internal_trusted_storage.h.
+ */
+psa_status_t tfm_crypto_key_cache_its_set(psa_storage_uid_t uid,
+                                          size_t data_length,
+                                          const void *p_data,
+                                          psa_storage_create_flags_t create_flags);
+psa_status_t tfm_crypto_key_cache_its_get(psa_storage_uid_t uid,
+                                          size_t data_offset,
+                                          size_t data_size,
+                                          void *p_data,
+                                          size_t *p_data_length);
+psa_status_t tfm_crypto_key_cache_its_get_info(psa_storage_uid_t uid,
+                                               struct psa_storage_info_t *p_info);
+psa_status_t tfm_crypto_key_cache_its_remove(psa_storage_uid_t uid);
+
+/**
+ * \brief Loads a persistent key in the cache and keeps it there until it is
+ *        unpinned, i.e. for the keys used by every signing operation.
+ *
+ * \note This is internal to the Crypto partition. The integration selects
+ *       the keys pinned from boot with CRYPTO_KEY_CACHE_PINNED_UIDS.
+ *
+ * \param[in] uid  UID of the ITS object of the key, see
+ *                 \ref TFM_CRYPTO_KEY_CACHE_UID
+ *
+ * \retval PSA_SUCCESS                  The key is pinned in the cache
+ * \retval PSA_ERROR_INSUFFICIENT_MEMORY The key is larger than a cache entry,
+ *                                      or all the entries are pinned
+ * \retval Other                        The key cannot be read from ITS
+ */
+psa_status_t tfm_crypto_key_cache_pin(psa_storage_uid_t uid);
+
+/**
+ * \brief Allows a pinned key to be evicted from the cache again
+ *
+ * \param[in] uid  UID of the ITS object of the key
+ *
+ * \retval PSA_SUCCESS             The key is not pinned anymore
+ * \retval PSA_ERROR_DOES_NOT_EXIST The key is not pinned
+ */
+psa_status_t tfm_crypto_key_cache_unpin(psa_storage_uid_t uid);
+
+/**
+ * \brief Gets the usage statistics of the cache, to tune its size
+ *
+ * \note This is internal to the Crypto partition. The statistics are also
+ *       printed at each eviction when the partition log level is debug.
+ *
+ * \param[out] stats  Statistics of the cache since boot
+ */
+void tfm_crypto_key_cache_get_stats(struct tfm_crypto_key_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_KEY_CACHE_H__ */
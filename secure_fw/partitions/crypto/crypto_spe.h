@@ -20,6 +20,8 @@
 #ifndef CRYPTO_SPE_H
 #define CRYPTO_SPE_H
 
+#include "config_tfm.h"
+
 #define PSA_FUNCTION_NAME(x) mbedcrypto__ ## x
 
 #define psa_crypto_init \
@@ -161,4 +163,16 @@
 #define psa_generate_key \
         PSA_FUNCTION_NAME(psa_generate_key)
 
+#if CRYPTO_KEY_CACHE_SLOT_NUM > 0
+/* Access the persistent keys of Mbed Crypto through the key cache */
+#define psa_its_set \
+        tfm_crypto_key_cache_its_set
+#define psa_its_get \
+        tfm_crypto_key_cache_its_get
+#define psa_its_get_info \
+        tfm_crypto_key_cache_its_get_info
+#define psa_its_remove \
+        tfm_crypto_key_cache_its_remove
+#endif /* CRYPTO_KEY_CACHE_SLOT_NUM > 0 */
+
 #endif /* CRYPTO_SPE_H */
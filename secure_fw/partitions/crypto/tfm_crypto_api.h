@@ -78,6 +78,13 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
  * \return Return values as described in \ref psa_status_t
  */
 psa_status_t tfm_crypto_operation_release(uint32_t *handle);
+/**
+ * \brief Abort and release all the operation contexts held by an owner, i.e.
+ *        when the client owning them has terminated
+ *
+ * \param[in] owner ID of the owner of the contexts to release
+ */
+void tfm_crypto_operation_release_all(int32_t owner);
 /**
  * \brief Look up an operation context in the backend for the corresponding
  *        frontend operation
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -38,12 +38,65 @@ typedef struct fwu_image_info_data_s {
     uint8_t data[MAX_IMAGE_INFO_LENGTH];
 } fwu_image_info_data_t;
 
+/* The staging area is erased sector by sector, the first time each sector is
+ * written in a FWU process.
+ */
+#define FWU_SECTOR_SIZE         FLASH_AREA_IMAGE_SECTOR_SIZE
+#define FWU_MAX_SECTOR_NUM      MCUBOOT_MAX_IMG_SECTORS
+
+/* Size of the encrypted image keys in the MCUboot image trailer. */
+#if defined(MCUBOOT_ENC_IMAGES)
+#if MCUBOOT_SWAP_SAVE_ENCTLV
+#define FWU_TRAILER_ENC_KEYS_SIZE   (BOOT_ENC_TLV_ALIGN_SIZE * 2)
+#else
+#define FWU_TRAILER_ENC_KEYS_SIZE   (BOOT_ENC_KEY_ALIGN_SIZE * 2)
+#endif
+#else
+#define FWU_TRAILER_ENC_KEYS_SIZE   0
+#endif
+
+/* Upper bound of the size of the MCUboot image trailer at the end of the
+ * staging area, as given by boot_trailer_sz() for the largest write size:
+ * the swap status entries of each sector, the encrypted image keys, the swap
+ * size, swap info, copy done and image ok fields, and the magic.
+ * It is erased when the FWU process starts, so that a stale trailer is never
+ * taken for the trailer of the new image.
+ */
+#define FWU_TRAILER_MAX_SIZE    (BOOT_STATUS_MAX_ENTRIES *                  \
+                                 BOOT_STATUS_STATE_COUNT * BOOT_MAX_ALIGN + \
+                                 FWU_TRAILER_ENC_KEYS_SIZE +                \
+                                 BOOT_MAX_ALIGN * 4 +                       \
+                                 BOOT_MAGIC_ALIGN_SIZE)
+
+/* Size of the digest of the staged image, which is a SHA-256 hash. */
+#define FWU_IMAGE_DIGEST_SIZE   PSA_HASH_LENGTH(PSA_ALG_SHA_256)
+
 typedef struct tfm_fwu_mcuboot_ctx_s {
     /* The flash area corresponding to component. */
     const struct flash_area *fap;
 
     /* The size of the downloaded data in the FWU process. */
     size_t loaded_size;
+
+    /* Whether the staging area is erased on demand. If the sectors of the
+     * staging area do not fit in erased_map, it is erased when the FWU
+     * process starts.
+     */
+    bool erase_on_demand;
+
+    /* The sectors of the staging area erased in the FWU process. */
+    uint8_t erased_map[(FWU_MAX_SECTOR_NUM + 7) / 8];
+
+    /* The running hash of the downloaded data. It is only valid while the
+     * data is written in order from the beginning of the image, otherwise the
+     * digest is calculated by reading back the staging area.
+     */
+    psa_hash_operation_t hash_op;
+    bool hash_valid;
+
+    /* The expected digest of the image, if passed as a detached manifest. */
+    bool has_expected_digest;
+    uint8_t expected_digest[FWU_IMAGE_DIGEST_SIZE];
 } tfm_fwu_mcuboot_ctx_t;
 
 static tfm_fwu_mcuboot_ctx_t mcuboot_ctx[FWU_COMPONENT_NUMBER];
@@ -102,14 +155,83 @@ psa_status_t fwu_bootloader_init(void)
     return PSA_SUCCESS;
 }
 
+static void fwu_hash_abort(psa_fwu_component_t component)
+{
+    if (mcuboot_ctx[component].hash_valid) {
+        (void)psa_hash_abort(&mcuboot_ctx[component].hash_op);
+        mcuboot_ctx[component].hash_valid = false;
+    }
+}
+
+/* Erase the sectors of the staging area covering [off, off + len) which have
+ * not been erased yet in the FWU process.
+ */
+static psa_status_t fwu_erase_sectors(psa_fwu_component_t component,
+                                      uint32_t off,
+                                      uint32_t len)
+{
+    tfm_fwu_mcuboot_ctx_t *ctx = &mcuboot_ctx[component];
+    uint32_t sector;
+    uint32_t last_sector;
+
+    if (!ctx->erase_on_demand || (len == 0)) {
+        return PSA_SUCCESS;
+    }
+
+    last_sector = (off + len - 1) / FWU_SECTOR_SIZE;
+    for (sector = off / FWU_SECTOR_SIZE; sector <= last_sector; sector++) {
+        if (ctx->erased_map[sector / 8] & (1U << (sector % 8))) {
+            continue;
+        }
+
+        if (flash_area_erase(ctx->fap, sector * FWU_SECTOR_SIZE,
+                             FWU_SECTOR_SIZE) != 0) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+        ctx->erased_map[sector / 8] |= (uint8_t)(1U << (sector % 8));
+    }
+
+    return PSA_SUCCESS;
+}
+
+/* Erase the part of the staging area which has been used in the FWU process.
+ */
+static psa_status_t fwu_erase_staging_area(psa_fwu_component_t component)
+{
+    tfm_fwu_mcuboot_ctx_t *ctx = &mcuboot_ctx[component];
+    const struct flash_area *fap = ctx->fap;
+    uint32_t sector;
+
+    if (!ctx->erase_on_demand) {
+        return (flash_area_erase(fap, 0, fap->fa_size) == 0) ?
+               PSA_SUCCESS : PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    for (sector = 0; sector < fap->fa_size / FWU_SECTOR_SIZE; sector++) {
+        if ((ctx->erased_map[sector / 8] & (1U << (sector % 8))) &&
+            (flash_area_erase(fap, sector * FWU_SECTOR_SIZE,
+                              FWU_SECTOR_SIZE) != 0)) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t fwu_bootloader_staging_area_init(psa_fwu_component_t component,
                                               const void *manifest,
                                               size_t manifest_size)
 {
+    uint32_t trailer_size;
+    bool erase_failed;
     const struct flash_area *fap;
 
-    /* MCUboot uses bundled manifest. */
-    if ((manifest_size != 0) || (component >= FWU_COMPONENT_NUMBER)) {
+    /* MCUboot uses bundled manifest. The only detached manifest accepted is
+     * the expected digest of the image, which is checked before installation.
+     */
+    if ((component >= FWU_COMPONENT_NUMBER) ||
+        ((manifest_size != 0) && (manifest_size != FWU_IMAGE_DIGEST_SIZE)) ||
+        ((manifest_size != 0) && (manifest == NULL))) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
@@ -119,16 +241,54 @@ psa_status_t fwu_bootloader_staging_area_init(psa_fwu_component_t component,
         return PSA_ERROR_STORAGE_FAILURE;
     }
 
-    if (flash_area_erase(fap, 0, fap->fa_size) != 0) {
+    mcuboot_ctx[component].fap = fap;
+
+    /* Erase the sectors of the staging area when they are first written, and
+     * the trailer right now. Fall back to erasing the whole staging area if
+     * its sectors cannot be tracked.
+     */
+    memset(mcuboot_ctx[component].erased_map, 0,
+           sizeof(mcuboot_ctx[component].erased_map));
+    mcuboot_ctx[component].erase_on_demand =
+        ((fap->fa_size % FWU_SECTOR_SIZE) == 0) &&
+        ((fap->fa_size / FWU_SECTOR_SIZE) <= FWU_MAX_SECTOR_NUM);
+
+    if (mcuboot_ctx[component].erase_on_demand) {
+        trailer_size = (fap->fa_size < FWU_TRAILER_MAX_SIZE) ?
+                       fap->fa_size : FWU_TRAILER_MAX_SIZE;
+        erase_failed = (fwu_erase_sectors(component,
+                                          fap->fa_size - trailer_size,
+                                          trailer_size) != PSA_SUCCESS);
+    } else {
+        erase_failed = (flash_area_erase(fap, 0, fap->fa_size) != 0);
+    }
+
+    /* Do not leave the component with a staging area which is not erased. */
+    if (erase_failed) {
         LOG_ERRFMT("TFM FWU: erasing flash failed.\r\n");
+        flash_area_close(fap);
+        mcuboot_ctx[component].fap = NULL;
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    mcuboot_ctx[component].fap = fap;
-
     /* Reset the loaded_size. */
     mcuboot_ctx[component].loaded_size = 0;
 
+    mcuboot_ctx[component].has_expected_digest = (manifest_size != 0);
+    if (manifest_size != 0) {
+        memcpy(mcuboot_ctx[component].expected_digest, manifest,
+               FWU_IMAGE_DIGEST_SIZE);
+    }
+
+    /* Start hashing the image as it is downloaded. If no hash operation is
+     * available the digest is calculated from the staging area when queried.
+     */
+    fwu_hash_abort(component);
+    mcuboot_ctx[component].hash_op = psa_hash_operation_init();
+    mcuboot_ctx[component].hash_valid =
+        (psa_hash_setup(&mcuboot_ctx[component].hash_op,
+                        PSA_ALG_SHA_256) == PSA_SUCCESS);
+
     return PSA_SUCCESS;
 }
 
@@ -150,16 +310,66 @@ psa_status_t fwu_bootloader_load_image(psa_fwu_component_t component,
         return PSA_ERROR_BAD_STATE;
     }
 
+    if ((block_offset > fap->fa_size) ||
+        (block_size > fap->fa_size - block_offset)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (fwu_erase_sectors(component, block_offset,
+                          block_size) != PSA_SUCCESS) {
+        LOG_ERRFMT("TFM FWU: erasing flash failed.\r\n");
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
     if (flash_area_write(fap, block_offset, block, block_size) != 0) {
         LOG_ERRFMT("TFM FWU: write flash failed.\r\n");
         return PSA_ERROR_STORAGE_FAILURE;
     }
 
+    /* Extend the running hash if the block follows the data written so far.
+     * Out of order writes fall back to hashing the staging area.
+     */
+    if (mcuboot_ctx[component].hash_valid) {
+        if ((block_offset != mcuboot_ctx[component].loaded_size) ||
+            (psa_hash_update(&mcuboot_ctx[component].hash_op,
+                             block, block_size) != PSA_SUCCESS)) {
+            fwu_hash_abort(component);
+        }
+    }
+
     /* The overflow check has been done in flash_area_write. */
     mcuboot_ctx[component].loaded_size += block_size;
     return PSA_SUCCESS;
 }
 
+static psa_status_t util_img_hash(const struct flash_area *fap,
+                                 size_t data_size,
+                                 uint8_t *hash_result,
+                                 size_t buf_size,
+                                 size_t *hash_size);
+
+/* Get the digest of the data downloaded into the staging area. */
+static psa_status_t get_staged_image_digest(psa_fwu_component_t component,
+                                            uint8_t *hash,
+                                            size_t hash_buf_size,
+                                            size_t *hash_size)
+{
+    psa_hash_operation_t hash_op = psa_hash_operation_init();
+    psa_status_t status;
+
+    /* Finish a copy of the running hash, so that the download can go on. */
+    if (mcuboot_ctx[component].hash_valid) {
+        status = psa_hash_clone(&mcuboot_ctx[component].hash_op, &hash_op);
+        if (status == PSA_SUCCESS) {
+            return psa_hash_finish(&hash_op, hash, hash_buf_size, hash_size);
+        }
+    }
+
+    return util_img_hash(mcuboot_ctx[component].fap,
+                         mcuboot_ctx[component].loaded_size,
+                         hash, hash_buf_size, hash_size);
+}
+
 #if (MCUBOOT_IMAGE_NUMBER > 1)
 /**
  * \brief Compare image version numbers not including the build number.
@@ -213,10 +423,38 @@ psa_status_t fwu_bootloader_install_image(const psa_fwu_component_t *candidates,
     bool check_pass = true;
 #endif
 
+    uint8_t hash[FWU_IMAGE_DIGEST_SIZE];
+    size_t hash_size;
+    psa_status_t status;
+
     if (candidates == NULL) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+    /* Reject an image which does not match the expected digest passed in
+     * psa_fwu_start(), without waiting for the bootloader to validate it.
+     */
+    for (cand_index = 0; cand_index < number; cand_index++) {
+        if ((candidates[cand_index] >= FWU_COMPONENT_NUMBER) ||
+            (mcuboot_ctx[candidates[cand_index]].fap == NULL)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        if (!mcuboot_ctx[candidates[cand_index]].has_expected_digest) {
+            continue;
+        }
+
+        status = get_staged_image_digest(candidates[cand_index], hash,
+                                         sizeof(hash), &hash_size);
+        if (status != PSA_SUCCESS) {
+            return PSA_ERROR_STORAGE_FAILURE;
+        }
+        if ((hash_size != FWU_IMAGE_DIGEST_SIZE) ||
+            (memcmp(hash, mcuboot_ctx[candidates[cand_index]].expected_digest,
+                    FWU_IMAGE_DIGEST_SIZE) != 0)) {
+            return PSA_ERROR_INVALID_SIGNATURE;
+        }
+    }
+
 #if (MCUBOOT_IMAGE_NUMBER > 1)
     for (cand_index = 0; cand_index < number; cand_index++) {
         component = candidates[cand_index];
@@ -491,10 +729,12 @@ psa_status_t fwu_bootloader_abort(psa_fwu_component_t component)
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    flash_area_erase(fap, 0, fap->fa_size);
+    (void)fwu_erase_staging_area(component);
     flash_area_close(fap);
+    fwu_hash_abort(component);
     mcuboot_ctx[component].fap = NULL;
     mcuboot_ctx[component].loaded_size = 0;
+    mcuboot_ctx[component].has_expected_digest = false;
     return PSA_SUCCESS;
 }
 
@@ -541,38 +781,27 @@ static psa_status_t util_img_hash(const struct flash_area *fap,
 static psa_status_t get_second_image_digest(psa_fwu_component_t component,
                                             psa_fwu_component_info_t *info)
 {
-    const struct flash_area *fap = NULL;
     uint8_t hash[TFM_FWU_MAX_DIGEST_SIZE] = {0};
     size_t hash_size = 0;
-    psa_status_t ret = PSA_SUCCESS;
-    size_t data_size;
 
     if (component >= FWU_COMPONENT_NUMBER) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
     /* Check if the image is in a FWU process. */
-    if (mcuboot_ctx[component].fap != NULL) {
-        /* Calculate hash on the downloaded data. */
-        data_size = mcuboot_ctx[component].loaded_size;
-    } else {
+    if (mcuboot_ctx[component].fap == NULL) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
-    if ((flash_area_open(FLASH_AREA_IMAGE_SECONDARY(component),
-                            &fap)) != 0) {
-        LOG_ERRFMT("TFM FWU: opening flash failed.\r\n");
+
+    if (get_staged_image_digest(component, hash,
+                                (size_t)TFM_FWU_MAX_DIGEST_SIZE,
+                                &hash_size) != PSA_SUCCESS) {
         return PSA_ERROR_STORAGE_FAILURE;
     }
 
-    if (util_img_hash(fap, data_size, hash, (size_t)TFM_FWU_MAX_DIGEST_SIZE,
-                      &hash_size) == PSA_SUCCESS) {
-        memcpy(info->impl.candidate_digest, hash, hash_size);
-    } else {
-        ret = PSA_ERROR_STORAGE_FAILURE;
-    }
+    memcpy(info->impl.candidate_digest, hash, hash_size);
 
-    flash_area_close(fap);
-    return ret;
+    return PSA_SUCCESS;
 }
 
 psa_status_t fwu_bootloader_get_image_info(psa_fwu_component_t component,
@@ -650,19 +879,18 @@ close_return:
 
 psa_status_t fwu_bootloader_clean_component(psa_fwu_component_t component)
 {
-    const struct flash_area *fap = NULL;
-
     if (component >= FWU_COMPONENT_NUMBER) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
     /* Check if the image is in a FWU process. */
     if (mcuboot_ctx[component].fap != NULL) {
-        fap = mcuboot_ctx[component].fap;
-        if (flash_area_erase(fap, 0, fap->fa_size) != 0) {
+        if (fwu_erase_staging_area(component) != PSA_SUCCESS) {
             return PSA_ERROR_STORAGE_FAILURE;
         }
+        fwu_hash_abort(component);
         mcuboot_ctx[component].fap = NULL;
+        mcuboot_ctx[component].has_expected_digest = false;
     } else {
         return PSA_ERROR_DOES_NOT_EXIST;
     }
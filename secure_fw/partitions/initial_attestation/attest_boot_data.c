@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -46,6 +46,19 @@ struct attest_boot_data {
  */
 __attribute__ ((aligned(4)))
 static struct attest_boot_data boot_data;
+
+/*!
+ * \var sw_module_index
+ *
+ * \brief Location of the first boot status entry of each SW module, built by
+ *        \ref attest_index_boot_data. An offset of 0 means that the SW module
+ *        has no entry.
+ */
+static struct {
+    uint16_t offset;    /* From the beginning of boot_data */
+    uint16_t tlv_len;
+    uint8_t  claim;
+} sw_module_index[SW_MAX];
 #endif
 
 #ifdef TFM_PARTITION_MEASURED_BOOT
@@ -143,66 +156,82 @@ attest_encode_sw_component(QCBOREncodeContext *encode_ctx,
 }
 #else
 /*!
- * \brief Static function to look up all entries in the shared data area
- *       (boot status) which belong to a specific module.
+ * \brief Static function to index the boot status: find the first entry of
+ *        each SW module in the shared data area.
  *
- * \param[in]     module  The identifier of SW module to look up based on this
- * \param[out]    claim   The type of SW module's attribute
- * \param[out]    tlv_len Length of the shared data entry
- * \param[in/out] tlv_ptr Pointer to the shared data entry. If its value NULL as
- *                        input then it will starts the look up from the
- *                        beginning of the shared data section. If not NULL then
- *                        it continue look up from the next entry. It returns
- *                        the address of next found entry which belongs to
- *                        module.
+ * The boot status is walked once when it is received from the SPM, so looking
+ * up the entry of a SW module during token creation does not need to walk it
+ * again.
  *
- * \retval    -1          Error, boot status is malformed
- * \retval     0          Entry not found
- * \retval     1          Entry found
+ * \return Returns error code as specified in \ref psa_attest_err_t
  */
-static int32_t attest_get_tlv_by_module(uint8_t    module,
-                                        uint8_t   *claim,
-                                        uint16_t  *tlv_len,
-                                        uint8_t  **tlv_ptr)
+static enum psa_attest_err_t attest_index_boot_data(void)
 {
     struct shared_data_tlv_entry tlv_entry;
-    uint8_t *tlv_end;
-    uint8_t *tlv_curr;
+    uint32_t tlv_end = boot_data.header.tlv_tot_len;
+    uint32_t offset = SHARED_DATA_HEADER_SIZE;
+    uint32_t next_tlv_offset;
+    uint16_t module;
 
-    if (boot_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
-        return -1;
-    }
+    (void)memset(sw_module_index, 0, sizeof(sw_module_index));
 
-    /* Get the boundaries of TLV section where to lookup*/
-    tlv_end = (uint8_t *)&boot_data + boot_data.header.tlv_tot_len;
-    if (*tlv_ptr == NULL) {
-        /* At first call set to the beginning of the TLV section */
-        tlv_curr = boot_data.data;
-    } else {
-        /* Any subsequent call set to the next TLV entry */
-        (void)memcpy(&tlv_entry, *tlv_ptr, SHARED_DATA_ENTRY_HEADER_SIZE);
-
-        tlv_curr  = (*tlv_ptr) + SHARED_DATA_ENTRY_HEADER_SIZE
-                    + tlv_entry.tlv_len;
+    if ((boot_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) ||
+        (tlv_end > sizeof(boot_data))) {
+        return PSA_ATTEST_ERR_INIT_FAILED;
     }
 
-    /* Iterates over the TLV section and returns the address and size of TLVs
-     * with requested module identifier
-     */
-    while (tlv_curr < tlv_end) {
+    for (; offset < tlv_end; offset += next_tlv_offset) {
+        if ((tlv_end - offset) < SHARED_DATA_ENTRY_HEADER_SIZE) {
+            return PSA_ATTEST_ERR_INIT_FAILED;
+        }
+
         /* Create local copy to avoid unaligned access */
-        (void)memcpy(&tlv_entry, tlv_curr, SHARED_DATA_ENTRY_HEADER_SIZE);
-        if (GET_IAS_MODULE(tlv_entry.tlv_type) == module) {
-            *claim   = GET_IAS_CLAIM(tlv_entry.tlv_type);
-            *tlv_ptr = tlv_curr;
-            *tlv_len = tlv_entry.tlv_len;
-            return 1;
+        (void)memcpy(&tlv_entry, (uint8_t *)&boot_data + offset,
+                     SHARED_DATA_ENTRY_HEADER_SIZE);
+
+        next_tlv_offset = SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+        if (next_tlv_offset > (tlv_end - offset)) {
+            return PSA_ATTEST_ERR_INIT_FAILED;
+        }
+
+        module = GET_IAS_MODULE(tlv_entry.tlv_type);
+        if ((module < SW_MAX) && (sw_module_index[module].offset == 0)) {
+            sw_module_index[module].offset = (uint16_t)offset;
+            sw_module_index[module].claim =
+                                  (uint8_t)GET_IAS_CLAIM(tlv_entry.tlv_type);
+            sw_module_index[module].tlv_len = tlv_entry.tlv_len;
         }
+    }
+
+    return PSA_ATTEST_ERR_SUCCESS;
+}
 
-        tlv_curr += (SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len);
+/*!
+ * \brief Static function to look up the first entry in the shared data area
+ *        (boot status) which belongs to a specific module.
+ *
+ * \param[in]  module   The identifier of SW module to look up based on this
+ * \param[out] claim    The type of SW module's attribute
+ * \param[out] tlv_len  Length of the shared data entry
+ * \param[out] tlv_ptr  Pointer to the shared data entry
+ *
+ * \retval     0          Entry not found
+ * \retval     1          Entry found
+ */
+static int32_t attest_get_tlv_by_module(uint8_t    module,
+                                        uint8_t   *claim,
+                                        uint16_t  *tlv_len,
+                                        uint8_t  **tlv_ptr)
+{
+    if ((module >= SW_MAX) || (sw_module_index[module].offset == 0)) {
+        return 0;
     }
 
-    return 0;
+    *claim   = sw_module_index[module].claim;
+    *tlv_len = sw_module_index[module].tlv_len;
+    *tlv_ptr = (uint8_t *)&boot_data + sw_module_index[module].offset;
+
+    return 1;
 }
 #endif /* TFM_PARTITION_MEASURED_BOOT */
 
@@ -299,22 +328,19 @@ attest_encode_sw_components_array(QCBOREncodeContext *encode_ctx,
 
     *cnt = 0;
 
+    if (boot_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
+        /* Boot status area is malformed. */
+        return PSA_ATTEST_ERR_CLAIM_UNAVAILABLE;
+    }
+
     /* Extract all boot records (measurements) from the boot status information
      * that was received from the secure bootloader.
      */
     for (module = 0; module < SW_MAX; ++module) {
-        /* Indicates to restart the look up from the beginning of the shared
-         * data section.
-         */
-        tlv_ptr = NULL;
-
         /* Look up the first TLV entry which belongs to the SW module */
         found = attest_get_tlv_by_module(module, &tlv_id,
                                          &tlv_len, &tlv_ptr);
-        if (found == -1) {
-            /* Boot status area is malformed. */
-            return PSA_ATTEST_ERR_CLAIM_UNAVAILABLE;
-        } else if ((found == 1) && (tlv_id == SW_BOOT_RECORD)) {
+        if ((found == 1) && (tlv_id == SW_BOOT_RECORD)) {
             (*cnt)++;
             if (*cnt == 1) {
                 /* Open array which stores SW components claims. */
@@ -350,8 +376,15 @@ enum psa_attest_err_t attest_boot_data_init(void)
      */
     return PSA_ATTEST_ERR_SUCCESS;
 #else
-    return attest_get_boot_data(TLV_MAJOR_IAS,
-                                (struct tfm_boot_data *)&boot_data,
-                                MAX_BOOT_STATUS);
+    enum psa_attest_err_t err;
+
+    err = attest_get_boot_data(TLV_MAJOR_IAS,
+                               (struct tfm_boot_data *)&boot_data,
+                               MAX_BOOT_STATUS);
+    if (err != PSA_ATTEST_ERR_SUCCESS) {
+        return err;
+    }
+
+    return attest_index_boot_data();
 #endif
 }
@@ -1,10 +1,11 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <stddef.h>
@@ -59,15 +60,6 @@ error_mapping_to_psa_status_t(enum psa_attest_err_t attest_err)
     }
 }
 
-psa_status_t attest_init(void)
-{
-    enum psa_attest_err_t res;
-
-    res = attest_boot_data_init();
-
-    return error_mapping_to_psa_status_t(res);
-}
-
 /*!
  * \brief Static function to map return values between \ref attest_token_err_t
  *        and \ref psa_attest_err_t
@@ -590,15 +582,18 @@ static enum psa_attest_err_t attest_get_t_cose_algorithm(
     return PSA_ATTEST_ERR_SUCCESS;
 }
 
+/* Claims which cannot change after boot. These are encoded once into the
+ * static claims template, see attest_build_static_claims().
+ */
 #if ATTEST_TOKEN_PROFILE_PSA_IOT_1 || ATTEST_TOKEN_PROFILE_PSA_2_0_0
     static enum psa_attest_err_t
-    (*claim_query_funcs[])(struct attest_token_encode_ctx *) = {
+    (*static_claim_funcs[])(struct attest_token_encode_ctx *) = {
         &attest_add_boot_seed_claim,
         &attest_add_instance_id_claim,
         &attest_add_implementation_id_claim,
-        &attest_add_caller_id_claim,
-        &attest_add_security_lifecycle_claim,
+#ifndef TFM_PARTITION_MEASURED_BOOT
         &attest_add_all_sw_components,
+#endif
         &attest_add_profile_definition,
 #if ATTEST_INCLUDE_OPTIONAL_CLAIMS
         &attest_add_verification_service,
@@ -608,11 +603,12 @@ static enum psa_attest_err_t attest_get_t_cose_algorithm(
 #elif ATTEST_TOKEN_PROFILE_ARM_CCA
 
     static enum psa_attest_err_t
-    (*claim_query_funcs[])(struct attest_token_encode_ctx *) = {
+    (*static_claim_funcs[])(struct attest_token_encode_ctx *) = {
         &attest_add_instance_id_claim,
         &attest_add_implementation_id_claim,
-        &attest_add_security_lifecycle_claim,
+#ifndef TFM_PARTITION_MEASURED_BOOT
         &attest_add_all_sw_components,
+#endif
         &attest_add_profile_definition,
         &attest_add_hash_algo_claim,
         &attest_add_platform_config_claim,
@@ -622,6 +618,253 @@ static enum psa_attest_err_t attest_get_t_cose_algorithm(
     };
 #endif
 
+/* Claims which are queried again for each token: the caller ID differs per
+ * request, the lifecycle state can be changed by runtime SW and the
+ * measurements held by the Measured Boot partition can be extended.
+ */
+#if ATTEST_TOKEN_PROFILE_PSA_IOT_1 || ATTEST_TOKEN_PROFILE_PSA_2_0_0
+    static enum psa_attest_err_t
+    (*dynamic_claim_funcs[])(struct attest_token_encode_ctx *) = {
+        &attest_add_caller_id_claim,
+        &attest_add_security_lifecycle_claim,
+#ifdef TFM_PARTITION_MEASURED_BOOT
+        &attest_add_all_sw_components,
+#endif
+    };
+#elif ATTEST_TOKEN_PROFILE_ARM_CCA
+
+    static enum psa_attest_err_t
+    (*dynamic_claim_funcs[])(struct attest_token_encode_ctx *) = {
+        &attest_add_security_lifecycle_claim,
+#ifdef TFM_PARTITION_MEASURED_BOOT
+        &attest_add_all_sw_components,
+#endif
+    };
+#endif
+
+#if ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE > 0
+#if ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE > UINT16_MAX
+#error "ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE must fit in 16 bits"
+#endif
+
+/* Location of one pre-encoded claim value in the template buffer */
+struct attest_static_claim_t {
+    int32_t  label;
+    uint16_t offset;
+    uint16_t len;
+};
+
+static struct {
+    bool valid;
+    struct attest_static_claim_t claims[ARRAY_LENGTH(static_claim_funcs)];
+    uint8_t buf[ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE];
+} static_claims;
+
+/*!
+ * \brief Static function to split an encoded single-entry claims map into its
+ *        integer label and the encoded claim value.
+ *
+ * \param[in]  encoded  Encoded map holding exactly one claim
+ * \param[out] label    Label of the claim
+ * \param[out] value    Encoded value of the claim, points into \p encoded
+ *
+ * \return Returns error code as specified in \ref psa_attest_err_t
+ */
+static enum psa_attest_err_t
+attest_split_encoded_claim(struct q_useful_buf_c encoded,
+                           int32_t *label,
+                           struct q_useful_buf_c *value)
+{
+    const uint8_t *ptr = encoded.ptr;
+    uint8_t major_type;
+    uint8_t add_info;
+    size_t head_len;
+    uint32_t arg = 0;
+    size_t i;
+
+    /* Map of one entry: 0xA1, then the label head */
+    if ((encoded.len < 3) || (ptr[0] != 0xA1)) {
+        return PSA_ATTEST_ERR_GENERAL;
+    }
+
+    major_type = ptr[1] >> 5;
+    add_info = ptr[1] & 0x1F;
+
+    if (add_info < 24) {
+        head_len = 1;
+        arg = add_info;
+    } else if (add_info <= 26) {
+        /* 1, 2 or 4 bytes of big-endian argument follow the initial byte */
+        head_len = 1 + (1U << (add_info - 24));
+    } else {
+        return PSA_ATTEST_ERR_GENERAL;
+    }
+
+    if ((major_type > 1) || (encoded.len <= 1 + head_len)) {
+        return PSA_ATTEST_ERR_GENERAL;
+    }
+
+    for (i = 2; i < 1 + head_len; i++) {
+        arg = (arg << 8) | ptr[i];
+    }
+
+    if (arg > INT32_MAX) {
+        return PSA_ATTEST_ERR_GENERAL;
+    }
+
+    /* Major type 0 is an unsigned integer, major type 1 is -1 - argument */
+    *label = (major_type == 0) ? (int32_t)arg : -1 - (int32_t)arg;
+    value->ptr = ptr + 1 + head_len;
+    value->len = encoded.len - 1 - head_len;
+
+    return PSA_ATTEST_ERR_SUCCESS;
+}
+
+/*!
+ * \brief Static function to encode the static claims into the template.
+ *
+ * Each static claim function is run once against its own single-entry map,
+ * and the label and encoded value are recorded. When a token is created the
+ * encoded values are spliced into the payload by
+ * \ref attest_add_static_claims instead of querying and encoding the claims
+ * again. If the template cannot be built, for example because it is too
+ * small, the claims are encoded for each token instead.
+ *
+ * \return Returns error code as specified in \ref psa_attest_err_t
+ */
+static enum psa_attest_err_t attest_build_static_claims(void)
+{
+    struct attest_token_encode_ctx template_ctx;
+    struct q_useful_buf_c encoded;
+    struct q_useful_buf_c value;
+    struct q_useful_buf remaining;
+    enum psa_attest_err_t attest_err;
+    QCBORError qcbor_err;
+    size_t used = 0;
+    int i;
+
+    static_claims.valid = false;
+
+    for (i = 0; i < ARRAY_LENGTH(static_claim_funcs); ++i) {
+        remaining.ptr = &static_claims.buf[used];
+        remaining.len = sizeof(static_claims.buf) - used;
+
+        QCBOREncode_Init(&template_ctx.cbor_enc_ctx, remaining);
+        QCBOREncode_OpenMap(&template_ctx.cbor_enc_ctx);
+
+        attest_err = static_claim_funcs[i](&template_ctx);
+        if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
+            return attest_err;
+        }
+
+        QCBOREncode_CloseMap(&template_ctx.cbor_enc_ctx);
+        qcbor_err = QCBOREncode_Finish(&template_ctx.cbor_enc_ctx, &encoded);
+        if (qcbor_err == QCBOR_ERR_BUFFER_TOO_SMALL) {
+            return PSA_ATTEST_ERR_BUFFER_OVERFLOW;
+        } else if (qcbor_err != QCBOR_SUCCESS) {
+            return PSA_ATTEST_ERR_GENERAL;
+        }
+
+        attest_err = attest_split_encoded_claim(encoded,
+                                                &static_claims.claims[i].label,
+                                                &value);
+        if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
+            return attest_err;
+        }
+
+        static_claims.claims[i].offset =
+            (uint16_t)((const uint8_t *)value.ptr - static_claims.buf);
+        static_claims.claims[i].len = (uint16_t)value.len;
+        used += encoded.len;
+    }
+
+    static_claims.valid = true;
+
+    return PSA_ATTEST_ERR_SUCCESS;
+}
+
+/*!
+ * \brief Static function to add the pre-encoded static claims to the
+ *        attestation token.
+ *
+ * \param[in]  token_ctx  Token encoding context
+ */
+static void
+attest_add_static_claims(struct attest_token_encode_ctx *token_ctx)
+{
+    struct q_useful_buf_c value;
+    int i;
+
+    for (i = 0; i < ARRAY_LENGTH(static_claim_funcs); ++i) {
+        value.ptr = &static_claims.buf[static_claims.claims[i].offset];
+        value.len = static_claims.claims[i].len;
+        attest_token_encode_add_cbor(token_ctx,
+                                     static_claims.claims[i].label,
+                                     &value);
+    }
+}
+#endif /* ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE > 0 */
+
+#ifndef TFM_PARTITION_MEASURED_BOOT
+/* Memoized token sizes, one entry per accepted challenge size. The size of a
+ * token only depends on the challenge size and on the per-token claims, so an
+ * entry is reused while the caller ID and the security lifecycle are unchanged.
+ * When the Measured Boot partition is enabled the SW components can change at
+ * runtime, hence the size is always calculated.
+ */
+#define ATTEST_TOKEN_SIZE_CACHE_NUM 3
+
+struct attest_token_size_cache_t {
+    bool valid;
+    int32_t caller_id;
+    enum tfm_security_lifecycle_t security_lifecycle;
+    size_t token_size;
+};
+
+static struct attest_token_size_cache_t
+token_size_cache[ATTEST_TOKEN_SIZE_CACHE_NUM];
+
+/*!
+ * \brief Static function to get the token size cache entry which belongs to
+ *        a challenge size.
+ *
+ * \param[in] challenge_size  Size of challenge object in bytes, already
+ *                            verified by \ref attest_verify_challenge_size.
+ *
+ * \return Returns a pointer to the cache entry
+ */
+static struct attest_token_size_cache_t *
+attest_get_token_size_cache(size_t challenge_size)
+{
+    switch (challenge_size) {
+    case PSA_INITIAL_ATTEST_CHALLENGE_SIZE_32:
+        return &token_size_cache[0];
+    case PSA_INITIAL_ATTEST_CHALLENGE_SIZE_48:
+        return &token_size_cache[1];
+    default:
+        return &token_size_cache[2];
+    }
+}
+#endif /* !TFM_PARTITION_MEASURED_BOOT */
+
+psa_status_t attest_init(void)
+{
+    enum psa_attest_err_t res;
+
+    res = attest_boot_data_init();
+
+#if ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE > 0
+    if (res == PSA_ATTEST_ERR_SUCCESS) {
+        /* Not fatal: the claims are encoded for each token if the template
+         * cannot be built.
+         */
+        (void)attest_build_static_claims();
+    }
+#endif
+
+    return error_mapping_to_psa_status_t(res);
+}
+
 /*!
  * \brief Static function to create the initial attestation token
  *
@@ -689,9 +932,23 @@ attest_create_token(struct q_useful_buf_c *challenge,
     }
 
     if (!(option_flags & TOKEN_OPT_OMIT_CLAIMS)) {
-        for (i = 0; i < ARRAY_LENGTH(claim_query_funcs); ++i) {
-            /* Calling the attest_add_XXX_claim functions */
-            attest_err = claim_query_funcs[i](&attest_token_ctx);
+#if ATTEST_STATIC_CLAIMS_TEMPLATE_SIZE > 0
+        if (static_claims.valid) {
+            attest_add_static_claims(&attest_token_ctx);
+        } else
+#endif
+        {
+            for (i = 0; i < ARRAY_LENGTH(static_claim_funcs); ++i) {
+                /* Calling the attest_add_XXX_claim functions */
+                attest_err = static_claim_funcs[i](&attest_token_ctx);
+                if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
+                    goto error;
+                }
+            }
+        }
+
+        for (i = 0; i < ARRAY_LENGTH(dynamic_claim_funcs); ++i) {
+            attest_err = dynamic_claim_funcs[i](&attest_token_ctx);
             if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
                 goto error;
             }
@@ -752,6 +1009,11 @@ initial_attest_get_token_size(const size_t challenge_size,
     struct q_useful_buf_c challenge;
     struct q_useful_buf token;
     struct q_useful_buf_c completed_token;
+#ifndef TFM_PARTITION_MEASURED_BOOT
+    struct attest_token_size_cache_t *cache;
+    enum tfm_security_lifecycle_t security_lifecycle;
+    int32_t caller_id;
+#endif
 
     /* Only the size of the challenge is needed */
     challenge.ptr = NULL;
@@ -766,6 +1028,23 @@ initial_attest_get_token_size(const size_t challenge_size,
         goto error;
     }
 
+#ifndef TFM_PARTITION_MEASURED_BOOT
+    cache = attest_get_token_size_cache(challenge_size);
+
+    attest_err = attest_get_caller_client_id(&caller_id);
+    if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
+        goto error;
+    }
+    security_lifecycle = tfm_attest_hal_get_security_lifecycle();
+
+    if (cache->valid &&
+        (cache->caller_id == caller_id) &&
+        (cache->security_lifecycle == security_lifecycle)) {
+        *token_size = cache->token_size;
+        return PSA_SUCCESS;
+    }
+#endif
+
     attest_err = attest_create_token(&challenge, &token, &completed_token);
     if (attest_err != PSA_ATTEST_ERR_SUCCESS) {
         goto error;
@@ -773,6 +1052,13 @@ initial_attest_get_token_size(const size_t challenge_size,
 
     *token_size = completed_token.len;
 
+#ifndef TFM_PARTITION_MEASURED_BOOT
+    cache->caller_id = caller_id;
+    cache->security_lifecycle = security_lifecycle;
+    cache->token_size = completed_token.len;
+    cache->valid = true;
+#endif
+
 error:
     return error_mapping_to_psa_status_t(attest_err);
 }
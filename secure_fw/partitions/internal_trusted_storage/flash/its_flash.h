@@ -36,6 +36,12 @@ extern struct its_flash_nand_dev_t its_flash_nand_dev;
 #define ITS_FLASH_DEV its_flash_nand_dev
 #define ITS_FLASH_ALIGNMENT 1
 #define ITS_FLASH_OPS its_flash_fs_ops_nand
+#if ITS_JOURNALED_WRITE
+#error "ITS_JOURNALED_WRITE requires a flash device which can be programmed in place"
+#endif
+#if ITS_TRANSACTION
+#error "ITS_TRANSACTION requires a flash device which can be programmed in place"
+#endif
 
 #else
 /* NOR flash: no write buffering, require each file in the filesystem to be
@@ -66,6 +72,9 @@ extern struct its_flash_nand_dev_t ps_flash_nand_dev;
 #define PS_FLASH_DEV ps_flash_nand_dev
 #define PS_FLASH_ALIGNMENT 1
 #define PS_FLASH_OPS its_flash_fs_ops_nand
+#if ITS_JOURNALED_WRITE
+#error "ITS_JOURNALED_WRITE requires a flash device which can be programmed in place"
+#endif
 
 #else
 /* NOR flash: no write buffering, require each file in the filesystem to be
@@ -20,6 +20,10 @@
 /* Flag that indicates the file is to be deleted in the next block update */
 #define ITS_FLASH_FS_FLAG_DELETE          (1U << 24)
 
+#if ITS_JOURNALED_WRITE && defined(ITS_ENCRYPTION)
+#error "ITS_JOURNALED_WRITE is not supported with ITS_ENCRYPTION"
+#endif
+
 static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
                                             uint32_t del_file_idx);
 
@@ -56,6 +60,63 @@ static psa_status_t its_flash_fs_file_write_aligned_data(
                                           size, data);
 }
 
+#if ITS_JOURNALED_WRITE
+/**
+ * \brief Appends data to an existing file in place, and commits the new size of
+ *        the file with a journal record instead of a metadata block update.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     idx        File metadata entry index
+ * \param[in]     file_meta  File metadata
+ * \param[in]     size       Size of the incoming data
+ * \param[in]     data       Pointer to data buffer to append to the file
+ *
+ * \return Returns PSA_ERROR_NOT_SUPPORTED if the data cannot be appended in
+ *         place, in which case the caller must fall back to a metadata block
+ *         update. Otherwise, returns error code as specified in
+ *         \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_file_append_in_place(
+                                        struct its_flash_fs_ctx_t *fs_ctx,
+                                        uint32_t idx,
+                                        const struct its_file_meta_t *file_meta,
+                                        size_t size,
+                                        const uint8_t *data)
+{
+    size_t offset = file_meta->cur_size;
+    size_t write_size = size;
+    psa_status_t err;
+
+    if (!its_flash_fs_mblock_journal_has_space(fs_ctx)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+    /* Check that the offset is aligned with the flash program unit */
+    if (!ITS_UTILS_IS_ALIGNED(offset, fs_ctx->cfg->program_unit)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    /* Set the size to be aligned with the flash program unit */
+    write_size = ITS_UTILS_ALIGN(size, fs_ctx->cfg->program_unit);
+#endif
+
+    /* Check that the new data is contained within the file's max size */
+    if (its_utils_check_contained_in(file_meta->max_size, offset, write_size)
+        != PSA_SUCCESS) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    err = its_flash_fs_dblock_write_file_in_place(fs_ctx, file_meta, offset,
+                                                  write_size, data);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return its_flash_fs_mblock_journal_append(fs_ctx, idx, offset + size);
+}
+#endif /* ITS_JOURNALED_WRITE */
+
 /* TODO This is very similar to (static) its_num_active_dblocks() */
 static uint32_t its_flash_fs_num_active_dblocks(
                                         const struct its_flash_fs_config_t *cfg)
@@ -84,7 +145,11 @@ static size_t its_flash_fs_all_metadata_size(
     return sizeof(struct its_metadata_block_header_t)
            + (its_flash_fs_num_active_dblocks(cfg)
               * sizeof(struct its_block_meta_t))
-           + (cfg->max_num_files * sizeof(struct its_file_meta_t));
+           + (cfg->max_num_files * sizeof(struct its_file_meta_t))
+#if ITS_JOURNALED_WRITE
+           + (ITS_JOURNAL_NUM_RECORDS * sizeof(struct its_journal_record_t))
+#endif
+           ;
 }
 
 /**
@@ -175,14 +240,19 @@ psa_status_t its_flash_fs_prepare(its_flash_fs_ctx_t *fs_ctx)
         return err;
     }
 
-    /* Check if a file marked for deletion has been left behind by a power
-     * failure. If so, delete it.
+    /* Check if files marked for deletion have been left behind by a power
+     * failure. If so, delete them.
      */
-    err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
-                                                ITS_FLASH_FS_FLAG_DELETE, &idx);
-    if (err == PSA_SUCCESS) {
-        return its_flash_fs_delete_idx(fs_ctx, idx);
-    } else if (err != PSA_ERROR_DOES_NOT_EXIST) {
+    while ((err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
+                                                    ITS_FLASH_FS_FLAG_DELETE,
+                                                    &idx)) == PSA_SUCCESS) {
+        err = its_flash_fs_delete_idx(fs_ctx, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    if (err != PSA_ERROR_DOES_NOT_EXIST) {
         return err;
     }
 
@@ -191,6 +261,11 @@ psa_status_t its_flash_fs_prepare(its_flash_fs_ctx_t *fs_ctx)
 
 psa_status_t its_flash_fs_wipe_all(struct its_flash_fs_ctx_t *fs_ctx)
 {
+#if ITS_TRANSACTION
+    /* The staged changes are erased with the rest of the filesystem */
+    fs_ctx->txn.active = false;
+#endif
+
     /* Clean and initialize the metadata block */
     return its_flash_fs_mblock_reset_metablock(fs_ctx);
 }
@@ -240,6 +315,13 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+#if ITS_TRANSACTION
+    /* The scratch blocks hold the changes staged by the transaction */
+    if (fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+#endif
+
     /* Do not permit the user to pass filesystem-internal flags */
     if (finfo->flags & ITS_FLASH_FS_INTERNAL_FLAGS_MASK) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -250,8 +332,26 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     finfo->size_max = ITS_UTILS_ALIGN(finfo->size_max, fs_ctx->cfg->program_unit);
 #endif
 
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, data_bytes, data_size);
     /* Check if the file already exists */
     err = its_flash_fs_mblock_get_file_idx_meta(fs_ctx, fid, &old_idx, &file_meta);
+
+#if ITS_JOURNALED_WRITE
+    /* Appending to an existing file does not require a metadata block update
+     * if the data can be programmed in place.
+     */
+    if ((err == PSA_SUCCESS) && !(finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE) &&
+        (data_size != 0) && (offset == file_meta.cur_size)) {
+        err = its_flash_fs_file_append_in_place(fs_ctx, old_idx, &file_meta,
+                                                data_size, data);
+        if (err != PSA_ERROR_NOT_SUPPORTED) {
+            return err;
+        }
+
+        err = PSA_SUCCESS;
+    }
+#endif
+
     if (err == PSA_SUCCESS) {
         if (finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE) {
             if (file_meta.max_size == finfo->size_max) {
@@ -557,6 +657,13 @@ psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
     psa_status_t err;
     uint32_t del_file_idx;
 
+#if ITS_TRANSACTION
+    /* The scratch blocks hold the changes staged by the transaction */
+    if (fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+#endif
+
     /* Get the file index. */
     err = its_flash_fs_mblock_get_file_idx_meta(fs_ctx, fid, &del_file_idx, NULL);
     if (err != PSA_SUCCESS) {
@@ -597,3 +704,919 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
 
     return PSA_SUCCESS;
 }
+
+#if ITS_TRANSACTION
+/* Positions of logical block 0 and of the staged logical block in the cursor
+ * and keep arrays of the transaction state.
+ */
+#define ITS_TXN_LB0       0U
+#define ITS_TXN_DBLOCK    1U
+#define ITS_TXN_NO_SLOT   2U
+
+/**
+ * \brief Finds the entry staged by the transaction for a file metadata index.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ * \param[in] idx     File metadata entry index
+ *
+ * \return Pointer to the staged entry, or NULL if there is none
+ */
+static struct its_txn_entry_t *its_txn_find_idx(
+                                         const struct its_flash_fs_ctx_t *fs_ctx,
+                                         uint32_t idx)
+{
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->txn.num_entries; i++) {
+        if (fs_ctx->cfg->txn_entries[i].idx == idx) {
+            return &fs_ctx->cfg->txn_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Finds the file written by the transaction with the given file ID.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ * \param[in] fid     File ID
+ *
+ * \return Pointer to the staged entry, or NULL if there is none
+ */
+static struct its_txn_entry_t *its_txn_find_fid(
+                                         const struct its_flash_fs_ctx_t *fs_ctx,
+                                         const uint8_t *fid)
+{
+    struct its_txn_entry_t *entry;
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->txn.num_entries; i++) {
+        entry = &fs_ctx->cfg->txn_entries[i];
+        if (!(entry->meta.flags & ITS_FLASH_FS_FLAG_DELETE) &&
+            !memcmp(entry->meta.id, fid, ITS_FILE_ID_SIZE)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Gets the committed metadata of a file which has not been written or
+ *        deleted by the transaction.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     fid        File ID
+ * \param[out]    idx        File metadata entry index
+ * \param[out]    file_meta  File metadata
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_get_committed_file(
+                                             struct its_flash_fs_ctx_t *fs_ctx,
+                                             const uint8_t *fid,
+                                             uint32_t *idx,
+                                             struct its_file_meta_t *file_meta)
+{
+    psa_status_t err;
+
+    err = its_flash_fs_mblock_get_file_idx_meta(fs_ctx, fid, idx, file_meta);
+    if ((err == PSA_SUCCESS) && (its_txn_find_idx(fs_ctx, *idx) != NULL)) {
+        /* The file has already been replaced or deleted by the transaction */
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    return err;
+}
+
+/**
+ * \brief Gets the position of a logical block in the transaction state.
+ *
+ * \param[in] txn     Transaction state
+ * \param[in] lblock  Logical block number
+ *
+ * \return ITS_TXN_LB0 or ITS_TXN_DBLOCK if the logical block is staged,
+ *         ITS_TXN_NO_SLOT otherwise
+ */
+static uint32_t its_txn_block_slot(const struct its_txn_t *txn, uint32_t lblock)
+{
+    if (lblock == ITS_LOGICAL_DBLOCK0) {
+        return ITS_TXN_LB0;
+    } else if (lblock == txn->dblock) {
+        return ITS_TXN_DBLOCK;
+    }
+
+    return ITS_TXN_NO_SLOT;
+}
+
+/**
+ * \brief Gets the size of the file data which the transaction has allocated in
+ *        place, in the free area of a logical block which is not staged.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ * \param[in] lblock  Logical block number, other than logical block 0 and the
+ *                    staged logical block
+ *
+ * \return Size of the allocated data
+ */
+static size_t its_txn_in_place_size(const struct its_flash_fs_ctx_t *fs_ctx,
+                                    uint32_t lblock)
+{
+    const struct its_txn_entry_t *entry;
+    size_t size = 0;
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->txn.num_entries; i++) {
+        entry = &fs_ctx->cfg->txn_entries[i];
+        if (!(entry->meta.flags & ITS_FLASH_FS_FLAG_DELETE) &&
+            (entry->meta.lblock == lblock) &&
+            (its_utils_validate_fid(entry->meta.id) == PSA_SUCCESS)) {
+            size += entry->meta.max_size;
+        }
+    }
+
+    return size;
+}
+
+/**
+ * \brief Stages a logical block in the scratch data block, if no other logical
+ *        block is staged yet and the transaction has not allocated data in
+ *        place in it.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] txn     Transaction state to update
+ * \param[in]     lblock  Logical block number
+ * \param[out]    slot    Position of the logical block in the transaction
+ *                        state, or ITS_TXN_NO_SLOT if it cannot be staged
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_stage_block(struct its_flash_fs_ctx_t *fs_ctx,
+                                        struct its_txn_t *txn,
+                                        uint32_t lblock,
+                                        uint32_t *slot)
+{
+    struct its_block_meta_t block_meta;
+    psa_status_t err;
+
+    *slot = its_txn_block_slot(txn, lblock);
+    if ((*slot != ITS_TXN_NO_SLOT) || (txn->dblock != ITS_BLOCK_INVALID_ID) ||
+        (its_txn_in_place_size(fs_ctx, lblock) != 0)) {
+        return PSA_SUCCESS;
+    }
+
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, lblock, &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    txn->dblock = lblock;
+    txn->cursor[ITS_TXN_DBLOCK] = block_meta.data_start;
+    txn->keep[ITS_TXN_DBLOCK] = fs_ctx->cfg->block_size - block_meta.free_size
+                                - block_meta.data_start;
+    *slot = ITS_TXN_DBLOCK;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Allocates space for the data of a file in a staged logical block, or
+ *        in place in the free area of another logical block.
+ *
+ * \details The space is taken from logical block 0 and the staged logical
+ *          block first, then from the erased free area of the other logical
+ *          blocks, and finally from a logical block which is staged for the
+ *          allocation if none is staged yet.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in,out] txn        Transaction state to update
+ * \param[in]     size       Size to allocate
+ * \param[out]    file_meta  File metadata to update with the location of the
+ *                           data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_alloc(struct its_flash_fs_ctx_t *fs_ctx,
+                                  struct its_txn_t *txn,
+                                  size_t size,
+                                  struct its_file_meta_t *file_meta)
+{
+    struct its_block_meta_t block_meta;
+    size_t block_size = fs_ctx->cfg->block_size;
+    size_t used;
+    size_t pos;
+    psa_status_t err;
+    uint32_t slot;
+    uint32_t i;
+
+    for (slot = ITS_TXN_LB0; slot < ITS_TXN_NO_SLOT; slot++) {
+        if ((slot == ITS_TXN_DBLOCK) && (txn->dblock == ITS_BLOCK_INVALID_ID)) {
+            break;
+        }
+
+        if ((txn->cursor[slot] + txn->keep[slot] + size) <= block_size) {
+            file_meta->lblock = (slot == ITS_TXN_LB0) ? ITS_LOGICAL_DBLOCK0
+                                                      : txn->dblock;
+            file_meta->data_idx = txn->cursor[slot];
+            file_meta->max_size = size;
+            txn->cursor[slot] += size;
+            return PSA_SUCCESS;
+        }
+    }
+
+    /* Allocate in place after the data of a logical block which is not
+     * staged, if that area is still erased. It may not be, if it was
+     * programmed by a transaction which has been aborted or interrupted.
+     */
+    for (i = ITS_LOGICAL_DBLOCK0 + 1;
+         i < its_flash_fs_num_active_dblocks(fs_ctx->cfg); i++) {
+        if (i == txn->dblock) {
+            continue;
+        }
+
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        used = its_txn_in_place_size(fs_ctx, i);
+        if ((block_meta.free_size - used) < size) {
+            continue;
+        }
+
+        pos = block_size - block_meta.free_size + used;
+        err = its_flash_fs_dblock_check_erased(fs_ctx, block_meta.phy_id, pos,
+                                               size);
+        if (err == PSA_ERROR_NOT_SUPPORTED) {
+            continue;
+        } else if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        file_meta->lblock = i;
+        file_meta->data_idx = pos;
+        file_meta->max_size = size;
+        return PSA_SUCCESS;
+    }
+
+    /* Stage a logical block with enough free space, if none is staged yet */
+    if (txn->dblock == ITS_BLOCK_INVALID_ID) {
+        for (i = ITS_LOGICAL_DBLOCK0 + 1;
+             i < its_flash_fs_num_active_dblocks(fs_ctx->cfg); i++) {
+            err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i,
+                                                          &block_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            if (block_meta.free_size < size) {
+                continue;
+            }
+
+            err = its_txn_stage_block(fs_ctx, txn, i, &slot);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            if (slot == ITS_TXN_DBLOCK) {
+                file_meta->lblock = txn->dblock;
+                file_meta->data_idx = txn->cursor[slot];
+                file_meta->max_size = size;
+                txn->cursor[slot] += size;
+                return PSA_SUCCESS;
+            }
+        }
+    }
+
+    return PSA_ERROR_INSUFFICIENT_STORAGE;
+}
+
+/**
+ * \brief Finds the next file metadata entry which is free in the active
+ *        metadata block, from the position reached by the previous search of
+ *        the transaction.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] txn     Transaction state to update
+ *
+ * \return Return index of a free file meta entry
+ */
+static uint32_t its_txn_next_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
+                                             struct its_txn_t *txn)
+{
+    bool used;
+    uint32_t i;
+
+    for (i = txn->free_idx_pos; i < fs_ctx->cfg->max_num_files; i++) {
+        if (its_flash_fs_mblock_file_idx_is_used(fs_ctx, i, &used)
+            != PSA_SUCCESS) {
+            return ITS_METADATA_INVALID_INDEX;
+        }
+
+        if (!used) {
+            txn->free_idx_pos = i + 1;
+            return i;
+        }
+    }
+
+    txn->free_idx_pos = fs_ctx->cfg->max_num_files;
+
+    return ITS_METADATA_INVALID_INDEX;
+}
+
+/**
+ * \brief Gets a file metadata entry which is free in the active metadata block
+ *        and has not been used by the transaction.
+ *
+ * \details The entries used by the transaction are all free entries found by
+ *          the previous searches, so each entry is looked at once per
+ *          transaction.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in,out] txn        Transaction state to update
+ * \param[in]     use_spare  If true then the spare file index will be used,
+ *                           otherwise at least one file index will be left free
+ *
+ * \return Return index of a free file meta entry
+ */
+static uint32_t its_txn_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
+                                            struct its_txn_t *txn,
+                                            bool use_spare)
+{
+    uint32_t idx;
+
+    if (txn->spare_idx == ITS_METADATA_INVALID_INDEX) {
+        txn->spare_idx = its_txn_next_free_file_index(fs_ctx, txn);
+        if (txn->spare_idx == ITS_METADATA_INVALID_INDEX) {
+            return ITS_METADATA_INVALID_INDEX;
+        }
+    }
+
+    if (use_spare) {
+        idx = txn->spare_idx;
+        txn->spare_idx = ITS_METADATA_INVALID_INDEX;
+        return idx;
+    }
+
+    return its_txn_next_free_file_index(fs_ctx, txn);
+}
+
+/**
+ * \brief Programs file data in the scratch block of a staged logical block, or
+ *        in place in the block of another logical block.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     file_meta  File metadata
+ * \param[in]     offset     Offset in the file
+ * \param[in]     size       Size of the data
+ * \param[in]     data       Pointer to the data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_write_data(struct its_flash_fs_ctx_t *fs_ctx,
+                                       const struct its_file_meta_t *file_meta,
+                                       size_t offset,
+                                       size_t size,
+                                       const uint8_t *data)
+{
+    struct its_block_meta_t block_meta;
+    uint32_t block_id;
+    psa_status_t err;
+
+    if (file_meta->lblock == ITS_LOGICAL_DBLOCK0) {
+        block_id = fs_ctx->scratch_metablock;
+    } else if (file_meta->lblock == fs_ctx->txn.dblock) {
+        block_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                           file_meta->lblock);
+    } else {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                      file_meta->lblock,
+                                                      &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+        block_id = block_meta.phy_id;
+    }
+
+    fs_ctx->txn.programmed = true;
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, block_id, data,
+                             file_meta->data_idx + offset, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, size);
+
+    return fs_ctx->ops->flush(fs_ctx->cfg, block_id);
+}
+
+/**
+ * \brief Relocates the files kept in the staged logical blocks after the data
+ *        written by the transaction.
+ *
+ * \param[in,out] fs_ctx       Filesystem context
+ * \param[in]     block_meta   Committed metadata of logical block 0 and of the
+ *                             staged logical block
+ * \param[in]     copy_slot    Staged logical block of which the file data is
+ *                             copied to its scratch block
+ * \param[in]     update_meta  Whether to write all the file metadata entries
+ *                             in the scratch metadata block
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_relocate_files(
+                                    struct its_flash_fs_ctx_t *fs_ctx,
+                                    const struct its_block_meta_t *block_meta,
+                                    uint32_t copy_slot,
+                                    bool update_meta)
+{
+    struct its_txn_t *txn = &fs_ctx->txn;
+    const struct its_txn_entry_t *entry;
+    struct its_file_meta_t file_meta;
+    size_t cursor[2];
+    uint32_t dst_block;
+    psa_status_t err;
+    uint32_t slot;
+    uint32_t idx;
+
+    cursor[ITS_TXN_LB0] = txn->cursor[ITS_TXN_LB0];
+    cursor[ITS_TXN_DBLOCK] = txn->cursor[ITS_TXN_DBLOCK];
+
+    if (copy_slot == ITS_TXN_LB0) {
+        dst_block = fs_ctx->scratch_metablock;
+    } else {
+        dst_block = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                            txn->dblock);
+    }
+
+    for (idx = 0; idx < fs_ctx->cfg->max_num_files; idx++) {
+        entry = its_txn_find_idx(fs_ctx, idx);
+        if (entry != NULL) {
+            file_meta = entry->meta;
+        } else {
+            err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &file_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            slot = its_txn_block_slot(txn, file_meta.lblock);
+            if ((its_utils_validate_fid(file_meta.id) == PSA_SUCCESS) &&
+                (slot != ITS_TXN_NO_SLOT)) {
+                if (slot == copy_slot) {
+                    err = its_flash_fs_block_to_block_move(fs_ctx, dst_block,
+                                                      cursor[slot],
+                                                      block_meta[slot].phy_id,
+                                                      file_meta.data_idx,
+                                                      file_meta.max_size);
+                    if (err != PSA_SUCCESS) {
+                        return err;
+                    }
+                }
+
+                file_meta.data_idx = cursor[slot];
+                cursor[slot] += file_meta.max_size;
+            }
+        }
+
+        if (update_meta) {
+            err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, idx,
+                                                               &file_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes the staged changes in the scratch blocks and swaps the metadata
+ *        blocks.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_txn_commit_staged(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_txn_t *txn = &fs_ctx->txn;
+    struct its_block_meta_t block_meta[2];
+    struct its_block_meta_t tmp_meta;
+    uint32_t scratch_id = ITS_BLOCK_INVALID_ID;
+    psa_status_t err;
+    uint32_t lblock;
+
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &block_meta[ITS_TXN_LB0]);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The data of the staged logical block is completed first, as writes to
+     * a block must be flushed before another block is written.
+     */
+    if (txn->dblock != ITS_BLOCK_INVALID_ID) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, txn->dblock,
+                                                   &block_meta[ITS_TXN_DBLOCK]);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_txn_relocate_files(fs_ctx, block_meta, ITS_TXN_DBLOCK,
+                                     false);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                             txn->dblock);
+        err = fs_ctx->ops->flush(fs_ctx->cfg, scratch_id);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* Copy the data of logical block 0 and write all the file metadata */
+    err = its_txn_relocate_files(fs_ctx, block_meta, ITS_TXN_LB0, true);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Write the block metadata */
+    for (lblock = 0; lblock < its_flash_fs_num_active_dblocks(fs_ctx->cfg);
+         lblock++) {
+        if (lblock == ITS_LOGICAL_DBLOCK0) {
+            tmp_meta = block_meta[ITS_TXN_LB0];
+            tmp_meta.phy_id = fs_ctx->scratch_metablock;
+            tmp_meta.free_size = fs_ctx->cfg->block_size
+                                 - (txn->cursor[ITS_TXN_LB0]
+                                    + txn->keep[ITS_TXN_LB0]);
+        } else if (lblock == txn->dblock) {
+            tmp_meta = block_meta[ITS_TXN_DBLOCK];
+            tmp_meta.phy_id = scratch_id;
+            tmp_meta.free_size = fs_ctx->cfg->block_size
+                                 - (txn->cursor[ITS_TXN_DBLOCK]
+                                    + txn->keep[ITS_TXN_DBLOCK]);
+        } else {
+            err = its_flash_fs_mblock_read_block_metadata(fs_ctx, lblock,
+                                                          &tmp_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            /* The data allocated in place is now in use */
+            tmp_meta.free_size -= its_txn_in_place_size(fs_ctx, lblock);
+        }
+
+        err = its_flash_fs_mblock_write_scratch_block_meta(fs_ctx, lblock,
+                                                           &tmp_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* The previous physical block of the staged logical block becomes the
+     * scratch data block.
+     */
+    if (txn->dblock != ITS_BLOCK_INVALID_ID) {
+        its_flash_fs_mblock_set_data_scratch(fs_ctx,
+                                             block_meta[ITS_TXN_DBLOCK].phy_id,
+                                             txn->dblock);
+    }
+
+    /* Write metadata header, swap metadata blocks and erase scratch blocks */
+    return its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+}
+
+psa_status_t its_flash_fs_txn_begin(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_txn_t *txn = &fs_ctx->txn;
+    struct its_block_meta_t block_meta;
+    psa_status_t err;
+
+    if (fs_ctx->cfg->txn_entries == NULL) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    if (txn->active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, ITS_LOGICAL_DBLOCK0,
+                                                  &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    txn->num_entries = 0;
+    txn->programmed = false;
+    txn->dblock = ITS_BLOCK_INVALID_ID;
+    txn->free_idx_pos = 0;
+    txn->spare_idx = ITS_METADATA_INVALID_INDEX;
+    txn->cursor[ITS_TXN_LB0] = block_meta.data_start;
+    txn->keep[ITS_TXN_LB0] = fs_ctx->cfg->block_size - block_meta.free_size
+                             - block_meta.data_start;
+    txn->active = true;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_file_write(struct its_flash_fs_ctx_t *fs_ctx,
+                                         const uint8_t *fid,
+                                         struct its_flash_fs_file_info_t *finfo,
+                                         size_t data_size,
+                                         size_t offset,
+                                         const uint8_t *data)
+{
+    struct its_txn_t txn = fs_ctx->txn;
+    struct its_txn_entry_t *entry;
+    struct its_file_meta_t old_meta;
+    struct its_file_meta_t file_meta = {0};
+    size_t write_size = data_size;
+    uint32_t num_entries = 1;
+    uint32_t old_idx = ITS_METADATA_INVALID_INDEX;
+    uint32_t new_idx;
+    uint32_t slot;
+    psa_status_t err;
+
+    if (!txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (finfo == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Do not permit the user to pass filesystem-internal flags */
+    if (finfo->flags & ITS_FLASH_FS_INTERNAL_FLAGS_MASK) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+    /* Check that the offset is aligned with the flash program unit */
+    if (!ITS_UTILS_IS_ALIGNED(offset, fs_ctx->cfg->program_unit)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Set the max_size and the size to be aligned with the flash program
+     * unit
+     */
+    finfo->size_max = ITS_UTILS_ALIGN(finfo->size_max,
+                                      fs_ctx->cfg->program_unit);
+    write_size = ITS_UTILS_ALIGN(data_size, fs_ctx->cfg->program_unit);
+#endif
+
+    entry = its_txn_find_fid(fs_ctx, fid);
+    if (entry != NULL) {
+        /* The file has already been written by the transaction. Its data can
+         * only be appended to, as the area written so far cannot be written
+         * again.
+         */
+        if ((finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE) ||
+            (offset != entry->meta.cur_size)) {
+            return PSA_ERROR_NOT_SUPPORTED;
+        }
+
+        if (its_utils_check_contained_in(entry->meta.max_size, offset,
+                                         write_size) != PSA_SUCCESS) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        if (data_size != 0) {
+            err = its_txn_write_data(fs_ctx, &entry->meta, offset, write_size,
+                                     data);
+            if (err != PSA_SUCCESS) {
+                (void)its_flash_fs_txn_abort(fs_ctx);
+                return err;
+            }
+        }
+
+        entry->meta.cur_size = offset + data_size;
+#ifdef ITS_ENCRYPTION
+        memcpy(entry->meta.nonce, finfo->nonce, sizeof(finfo->nonce));
+        memcpy(entry->meta.tag, finfo->tag, sizeof(finfo->tag));
+#endif
+        return PSA_SUCCESS;
+    }
+
+    /* Check if the file already exists */
+    err = its_txn_get_committed_file(fs_ctx, fid, &old_idx, &old_meta);
+    if (err == PSA_SUCCESS) {
+        /* Writing to an existing file requires its data to be copied, which
+         * is not supported in a transaction.
+         */
+        if (!(finfo->flags & ITS_FLASH_FS_FLAG_TRUNCATE)) {
+            return PSA_ERROR_NOT_SUPPORTED;
+        }
+    } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        /* The create flag must be supplied to create a new file */
+        if (!(finfo->flags & ITS_FLASH_FS_FLAG_CREATE)) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        old_idx = ITS_METADATA_INVALID_INDEX;
+    } else {
+        return err;
+    }
+
+    /* Check that the file's maximum size is valid, and that the new data is
+     * contained within it.
+     */
+    if ((finfo->size_max > fs_ctx->cfg->max_file_size) || (offset != 0) ||
+        (its_utils_check_contained_in(finfo->size_max, offset, write_size)
+         != PSA_SUCCESS)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    slot = ITS_TXN_NO_SLOT;
+    if (old_idx != ITS_METADATA_INVALID_INDEX) {
+        err = its_txn_stage_block(fs_ctx, &txn, old_meta.lblock, &slot);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    if (slot != ITS_TXN_NO_SLOT) {
+        /* The old data is dropped when the staged block is committed, so the
+         * file metadata entry can be reused.
+         */
+        txn.keep[slot] -= old_meta.max_size;
+        new_idx = old_idx;
+    } else {
+        /* Only use the spare file if there is an old file to be deleted. The
+         * old file is marked to be deleted after the transaction is
+         * committed.
+         */
+        new_idx = its_txn_get_free_file_index(fs_ctx, &txn,
+                                          old_idx != ITS_METADATA_INVALID_INDEX);
+        if (new_idx == ITS_METADATA_INVALID_INDEX) {
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+
+        if (old_idx != ITS_METADATA_INVALID_INDEX) {
+            num_entries++;
+        }
+    }
+
+    if ((txn.num_entries + num_entries) > fs_ctx->cfg->txn_max_entries) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    err = its_txn_alloc(fs_ctx, &txn, finfo->size_max, &file_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    memcpy(file_meta.id, fid, ITS_FILE_ID_SIZE);
+    file_meta.cur_size = data_size;
+    file_meta.flags = finfo->flags;
+#ifdef ITS_ENCRYPTION
+    memcpy(file_meta.nonce, finfo->nonce, sizeof(finfo->nonce));
+    memcpy(file_meta.tag, finfo->tag, sizeof(finfo->tag));
+#endif
+
+    /* Commit the new transaction state and stage the file metadata */
+    fs_ctx->txn = txn;
+
+    if (num_entries > 1) {
+        entry = &fs_ctx->cfg->txn_entries[fs_ctx->txn.num_entries++];
+        entry->idx = old_idx;
+        entry->meta = old_meta;
+        entry->meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+    }
+
+    entry = &fs_ctx->cfg->txn_entries[fs_ctx->txn.num_entries++];
+    entry->idx = new_idx;
+    entry->meta = file_meta;
+
+    if (data_size != 0) {
+        err = its_txn_write_data(fs_ctx, &file_meta, 0, write_size, data);
+        if (err != PSA_SUCCESS) {
+            (void)its_flash_fs_txn_abort(fs_ctx);
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
+                                          const uint8_t *fid)
+{
+    struct its_txn_t txn = fs_ctx->txn;
+    struct its_txn_entry_t *entry;
+    struct its_file_meta_t file_meta;
+    psa_status_t err;
+    uint32_t slot;
+    uint32_t idx;
+
+    if (!txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* The data of a file written by the transaction cannot be dropped */
+    if (its_txn_find_fid(fs_ctx, fid) != NULL) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    err = its_txn_get_committed_file(fs_ctx, fid, &idx, &file_meta);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if (txn.num_entries >= fs_ctx->cfg->txn_max_entries) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    err = its_txn_stage_block(fs_ctx, &txn, file_meta.lblock, &slot);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (slot != ITS_TXN_NO_SLOT) {
+        /* The data is dropped when the staged block is committed */
+        txn.keep[slot] -= file_meta.max_size;
+        file_meta = (struct its_file_meta_t){0};
+    } else {
+        /* The file is deleted after the transaction is committed */
+        file_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+    }
+
+    fs_ctx->txn = txn;
+
+    entry = &fs_ctx->cfg->txn_entries[fs_ctx->txn.num_entries++];
+    entry->idx = idx;
+    entry->meta = file_meta;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_commit(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t idx;
+
+    if (!fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (fs_ctx->txn.num_entries == 0) {
+        return its_flash_fs_txn_abort(fs_ctx);
+    }
+
+    err = its_txn_commit_staged(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        (void)its_flash_fs_txn_abort(fs_ctx);
+        return err;
+    }
+
+    fs_ctx->txn.active = false;
+
+    /* Delete the files which were replaced or deleted in logical blocks which
+     * could not be staged.
+     */
+    while ((err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
+                                                    ITS_FLASH_FS_FLAG_DELETE,
+                                                    &idx)) == PSA_SUCCESS) {
+        err = its_flash_fs_delete_idx(fs_ctx, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return (err == PSA_ERROR_DOES_NOT_EXIST) ? PSA_SUCCESS : err;
+}
+
+psa_status_t its_flash_fs_txn_abort(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    bool programmed = fs_ctx->txn.programmed;
+
+    if (!fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    fs_ctx->txn.active = false;
+    fs_ctx->txn.programmed = false;
+
+    /* The scratch blocks only need to be erased again if data was staged */
+    if (programmed) {
+        return its_flash_fs_mblock_erase_scratch_blocks(fs_ctx);
+    }
+
+    return PSA_SUCCESS;
+}
+
+bool its_flash_fs_txn_is_active(const struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return fs_ctx->txn.active;
+}
+#endif /* ITS_TRANSACTION */
+
+#if ITS_FLASH_FS_STATS
+void its_flash_fs_get_stats(const struct its_flash_fs_ctx_t *fs_ctx,
+                            struct its_flash_fs_stats_t *stats)
+{
+    *stats = fs_ctx->stats;
+}
+#endif
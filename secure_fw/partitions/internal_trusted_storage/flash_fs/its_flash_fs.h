@@ -17,6 +17,7 @@
 #ifndef __ITS_FLASH_FS_H__
 #define __ITS_FLASH_FS_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -61,8 +62,36 @@ struct its_flash_fs_config_t {
     uint16_t max_file_size;   /**< Maximum file size */
     uint16_t max_num_files;   /**< Maximum number of files */
     uint8_t erase_val;        /**< Value of a byte after erase (usually 0xFF) */
+#if ITS_RAM_FILE_INDEX
+    uint32_t *file_index_buf; /**< RAM buffer for the file index, of at least
+                               *   ITS_FLASH_FS_FILE_INDEX_WORDS(max_num_files)
+                               *   words. NULL disables the index.
+                               */
+#endif
+#if ITS_TRANSACTION
+    struct its_txn_entry_t *txn_entries; /**< RAM buffer for the file metadata
+                                          *   entries staged by a transaction.
+                                          *   NULL disables transactions.
+                                          */
+    uint16_t txn_max_entries;            /**< Number of entries of the
+                                          *   txn_entries buffer
+                                          */
+#endif
 };
 
+#if ITS_RAM_FILE_INDEX
+/**
+ * \brief Evaluates to the number of 32-bit words required by the RAM file index
+ *        of a filesystem with \p num_files file metadata entries.
+ *
+ * \details The index is made of a bitmap of the metadata entries in use, a
+ *          16-bit FID hash per metadata entry and a hash table of
+ *          (2 * num_files) 16-bit slots.
+ */
+#define ITS_FLASH_FS_FILE_INDEX_WORDS(num_files) \
+    ((((num_files) + 31) / 32) + (((3 * (num_files)) + 1) / 2))
+#endif
+
 /**
  * \struct its_flash_fs_ops_t
  *
@@ -249,7 +278,8 @@ psa_status_t its_flash_fs_file_get_info(its_flash_fs_ctx_t *fs_ctx,
  *                           equal to the current file size.
  * \param[in]     data       Pointer to buffer containing data to be written
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \return Returns PSA_ERROR_BAD_STATE if a transaction is in progress.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
  */
 psa_status_t its_flash_fs_file_write(its_flash_fs_ctx_t *fs_ctx,
                                      const uint8_t *fid,
@@ -281,11 +311,121 @@ psa_status_t its_flash_fs_file_read(its_flash_fs_ctx_t *fs_ctx,
  * \param[in,out] fs_ctx  Filesystem context
  * \param[in]     fid     File ID
  *
- * \return Returns error code as specified in \ref psa_status_t
+ * \return Returns PSA_ERROR_BAD_STATE if a transaction is in progress.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
  */
 psa_status_t its_flash_fs_file_delete(its_flash_fs_ctx_t *fs_ctx,
                                       const uint8_t *fid);
 
+#if ITS_TRANSACTION
+/**
+ * \brief Starts a transaction. Until the transaction is committed, the file
+ *        writes and deletions made with its_flash_fs_txn_file_write() and
+ *        its_flash_fs_txn_file_delete() are staged, and are not visible to the
+ *        other filesystem operations.
+ *
+ * \note its_flash_fs_file_write() and its_flash_fs_file_delete() fail with
+ *       PSA_ERROR_BAD_STATE while the transaction is in progress.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if a transaction is already in progress,
+ *         PSA_ERROR_NOT_SUPPORTED if the filesystem has no transaction buffer.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_begin(its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Stages a write to a file in the transaction in progress.
+ *
+ * \details A file can be created or truncated once in a transaction, and then
+ *          only be appended to. The data of the file is programmed in the
+ *          scratch blocks, or in the erased free area of a data block, and
+ *          only becomes visible when the transaction is committed.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     fid        File ID
+ * \param[in]     finfo      Pointer to \ref its_flash_fs_file_info_t
+ * \param[in]     data_size  Size of the incoming write data.
+ * \param[in]     offset     Offset in the file to write. Must be 0 when the
+ *                           file is truncated, and the current file size
+ *                           otherwise.
+ * \param[in]     data       Pointer to buffer containing data to be written
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if no transaction is in progress,
+ *         PSA_ERROR_NOT_SUPPORTED if the write cannot be staged in the
+ *         transaction. Otherwise, returns error code as specified in
+ *         \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_file_write(its_flash_fs_ctx_t *fs_ctx,
+                                         const uint8_t *fid,
+                                         struct its_flash_fs_file_info_t *finfo,
+                                         size_t data_size,
+                                         size_t offset,
+                                         const uint8_t *data);
+
+/**
+ * \brief Stages the deletion of a file in the transaction in progress.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     fid     File ID
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if no transaction is in progress,
+ *         PSA_ERROR_NOT_SUPPORTED if the file has been written by the
+ *         transaction. Otherwise, returns error code as specified in
+ *         \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_file_delete(its_flash_fs_ctx_t *fs_ctx,
+                                          const uint8_t *fid);
+
+/**
+ * \brief Commits the transaction in progress. All the staged changes are
+ *        committed by a single metadata block update, so either all or none of
+ *        them are applied in the case of a power failure.
+ *
+ * \note If the commit fails, the transaction is aborted.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if no transaction is in progress.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_commit(its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Aborts the transaction in progress and discards the staged changes.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if no transaction is in progress.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_abort(its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Checks if a transaction is in progress.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ *
+ * \return true if a transaction is in progress, false otherwise
+ */
+bool its_flash_fs_txn_is_active(const its_flash_fs_ctx_t *fs_ctx);
+#endif /* ITS_TRANSACTION */
+
+#if ITS_FLASH_FS_STATS
+struct its_flash_fs_stats_t;
+
+/**
+ * \brief Gets the flash usage counters of the filesystem.
+ *
+ * \param[in]  fs_ctx  Filesystem context
+ * \param[out] stats   Pointer to the flash usage counters
+ *                      \ref its_flash_fs_stats_t
+ */
+void its_flash_fs_get_stats(const its_flash_fs_ctx_t *fs_ctx,
+                            struct its_flash_fs_stats_t *stats);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
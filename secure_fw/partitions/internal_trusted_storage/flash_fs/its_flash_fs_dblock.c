@@ -8,6 +8,12 @@
 #include "its_flash_fs_dblock.h"
 
 #include "its_flash_fs.h"
+#include "its_utils.h"
+
+#if ITS_JOURNALED_WRITE || ITS_TRANSACTION
+/* Size of the buffer used to check that a region of a block is erased */
+#define ITS_DBLOCK_ERASE_CHECK_BUF_SIZE  32
+#endif
 
 /**
  * \brief Converts logical data block number to physical number.
@@ -168,6 +174,7 @@ psa_status_t its_flash_fs_dblock_write_file(
     if (err != PSA_SUCCESS) {
         return err;
     }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, size);
 
     /* Calculate the position of the end of the file */
     pos = file_meta->data_idx + file_meta->max_size;
@@ -192,3 +199,71 @@ psa_status_t its_flash_fs_dblock_write_file(
 
     return err;
 }
+
+#if ITS_JOURNALED_WRITE || ITS_TRANSACTION
+psa_status_t its_flash_fs_dblock_check_erased(struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block_id,
+                                              size_t offset,
+                                              size_t size)
+{
+    uint8_t buf[ITS_DBLOCK_ERASE_CHECK_BUF_SIZE];
+    psa_status_t err;
+    size_t bytes;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < size; i += bytes) {
+        bytes = ITS_UTILS_MIN(size - i, sizeof(buf));
+
+        err = fs_ctx->ops->read(fs_ctx->cfg, block_id, buf, offset + i, bytes);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        for (j = 0; j < bytes; j++) {
+            if (buf[j] != fs_ctx->cfg->erase_val) {
+                return PSA_ERROR_NOT_SUPPORTED;
+            }
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_JOURNALED_WRITE || ITS_TRANSACTION */
+
+#if ITS_JOURNALED_WRITE
+psa_status_t its_flash_fs_dblock_write_file_in_place(
+                                        struct its_flash_fs_ctx_t *fs_ctx,
+                                        const struct its_file_meta_t *file_meta,
+                                        size_t offset,
+                                        size_t size,
+                                        const uint8_t *data)
+{
+    uint32_t phys_block;
+    psa_status_t err;
+    size_t pos;
+
+    phys_block = its_dblock_lo_to_phy(fs_ctx, file_meta->lblock);
+    if (phys_block == ITS_BLOCK_INVALID_ID) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    pos = file_meta->data_idx + offset;
+
+    /* Check that the region to write is erased. It may not be, if a previous
+     * in-place write was interrupted before its size was committed.
+     */
+    err = its_flash_fs_dblock_check_erased(fs_ctx, phys_block, pos, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, phys_block, data, pos, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, size);
+
+    return fs_ctx->ops->flush(fs_ctx->cfg, phys_block);
+}
+#endif /* ITS_JOURNALED_WRITE */
@@ -81,6 +81,50 @@ psa_status_t its_flash_fs_dblock_write_file(
                                       size_t size,
                                       const uint8_t *data);
 
+#if ITS_JOURNALED_WRITE || ITS_TRANSACTION
+/**
+ * \brief Checks that a region of a physical block is erased.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     block_id  Physical block ID
+ * \param[in]     offset    Offset of the region in the block
+ * \param[in]     size      Size of the region
+ *
+ * \return Returns PSA_ERROR_NOT_SUPPORTED if the region is not erased.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_dblock_check_erased(struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t block_id,
+                                              size_t offset,
+                                              size_t size);
+#endif
+
+#if ITS_JOURNALED_WRITE
+/**
+ * \brief Writes file data in place in the active data block, without copying
+ *        the block to the scratch data block.
+ *
+ * \note The region to write must be erased. The file metadata is not updated,
+ *       so the new data is only visible once the new size of the file is
+ *       committed.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     file_meta  File metadata
+ * \param[in]     offset     Offset in the file where to write the data
+ * \param[in]     size       Size of the incoming data
+ * \param[in]     data       Pointer to data buffer to write in the file
+ *
+ * \return Returns PSA_ERROR_NOT_SUPPORTED if the region to write is not erased.
+ *         Otherwise, returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_dblock_write_file_in_place(
+                                        struct its_flash_fs_ctx_t *fs_ctx,
+                                        const struct its_file_meta_t *file_meta,
+                                        size_t offset,
+                                        size_t size,
+                                        const uint8_t *data);
+#endif /* ITS_JOURNALED_WRITE */
+
 #ifdef __cplusplus
 }
 #endif
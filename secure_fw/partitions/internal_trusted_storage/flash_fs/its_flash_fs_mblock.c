@@ -35,6 +35,16 @@
 #define ITS_BLOCK_METADATA_SIZE     sizeof(struct its_block_meta_t)
 #define ITS_FILE_METADATA_SIZE      sizeof(struct its_file_meta_t)
 
+#if ITS_JOURNALED_WRITE
+#define ITS_JOURNAL_RECORD_SIZE     sizeof(struct its_journal_record_t)
+#define ITS_JOURNAL_AREA_SIZE       (ITS_JOURNAL_NUM_RECORDS \
+                                     * ITS_JOURNAL_RECORD_SIZE)
+/* Value mixed into the check value of the journal records */
+#define ITS_JOURNAL_CHECK_MAGIC     0x4A524E4CU
+#else
+#define ITS_JOURNAL_AREA_SIZE       0
+#endif
+
 /* FIXME: Precompute these for each context */
 /**
  * \brief Gets the physical block ID of the initial position of the scratch
@@ -135,6 +145,22 @@ static size_t its_mblock_file_meta_offset(struct its_flash_fs_ctx_t *fs_ctx,
            + (idx * ITS_FILE_METADATA_SIZE);
 }
 
+/**
+ * \brief Gets offset of the data of logical block 0 in metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Return offset value in metadata block
+ */
+static size_t its_mblock_lb0_data_start(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    /* The journal area, if any, is located between the file metadata table and
+     * the data of logical block 0.
+     */
+    return its_mblock_file_meta_offset(fs_ctx, fs_ctx->cfg->max_num_files)
+           + ITS_JOURNAL_AREA_SIZE;
+}
+
 /**
  * \brief Swaps metablocks. Scratch becomes active and active becomes scratch.
  *
@@ -255,9 +281,7 @@ static psa_status_t its_mblock_validate_file_meta(
 
         if (file_meta->lblock == ITS_LOGICAL_DBLOCK0) {
             /* In block 0, data index must be located after the metadata */
-            if (file_meta->data_idx <
-                its_mblock_file_meta_offset(fs_ctx,
-                                            fs_ctx->cfg->max_num_files)) {
+            if (file_meta->data_idx < its_mblock_lb0_data_start(fs_ctx)) {
                 return PSA_ERROR_DATA_CORRUPT;
             }
         }
@@ -312,8 +336,7 @@ static psa_status_t its_mblock_validate_block_meta(
         /* For metadata + data block, data index must start after the
          * metadata area.
          */
-        valid_data_start_value =
-            its_mblock_file_meta_offset(fs_ctx, fs_ctx->cfg->max_num_files);
+        valid_data_start_value = its_mblock_lb0_data_start(fs_ctx);
     }
 
     if (block_meta->data_start != valid_data_start_value) {
@@ -464,6 +487,379 @@ static psa_status_t its_mblock_validate_metadata_xor(
 }
 #endif /* ITS_VALIDATE_METADATA_FROM_FLASH */
 
+#if ITS_RAM_FILE_INDEX
+/**
+ * \brief Calculates the hash of a file ID used by the RAM file index.
+ *
+ * \param[in] fid  File ID
+ *
+ * \return 16-bit hash of the file ID (32-bit FNV-1a, xor-folded)
+ */
+static uint16_t its_mblock_index_hash(const uint8_t *fid)
+{
+    uint32_t hash = 2166136261U;
+    uint32_t i;
+
+    for (i = 0; i < ITS_FILE_ID_SIZE; i++) {
+        hash ^= fid[i];
+        hash *= 16777619U;
+    }
+
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/**
+ * \brief Checks if a file metadata entry is in use in the RAM file index.
+ *
+ * \param[in] index  RAM file index
+ * \param[in] idx    File metadata entry index
+ *
+ * \return true if the entry is in use, false otherwise
+ */
+__attribute__((always_inline))
+static inline bool its_mblock_index_is_used(const struct its_file_index_t *index,
+                                            uint32_t idx)
+{
+    return (index->used[idx / 32] & (1U << (idx % 32))) != 0;
+}
+
+/**
+ * \brief Adds a file metadata entry to the RAM file index.
+ *
+ * \param[in,out] index  RAM file index
+ * \param[in]     idx    File metadata entry index
+ * \param[in]     hash   Hash of the entry's file ID
+ */
+static void its_mblock_index_insert(struct its_file_index_t *index,
+                                    uint32_t idx, uint16_t hash)
+{
+    uint32_t pos = hash % index->num_slots;
+
+    /* The table has twice as many slots as entries, so there is always an
+     * empty slot to be found.
+     */
+    while (index->slots[pos] != ITS_METADATA_INVALID_INDEX) {
+        pos = (pos + 1) % index->num_slots;
+    }
+
+    index->slots[pos] = (uint16_t)idx;
+    index->fid_hash[idx] = hash;
+    index->used[idx / 32] |= (1U << (idx % 32));
+}
+
+/**
+ * \brief Removes a file metadata entry from the RAM file index.
+ *
+ * \param[in,out] index  RAM file index
+ * \param[in]     idx    File metadata entry index, which must be in use
+ */
+static void its_mblock_index_remove(struct its_file_index_t *index,
+                                    uint32_t idx)
+{
+    uint32_t pos = index->fid_hash[idx] % index->num_slots;
+    uint32_t next;
+    uint32_t home;
+
+    while (index->slots[pos] != idx) {
+        pos = (pos + 1) % index->num_slots;
+    }
+
+    index->slots[pos] = ITS_METADATA_INVALID_INDEX;
+    index->used[idx / 32] &= ~(1U << (idx % 32));
+
+    /* Shift back the following entries of the probe sequence which can no
+     * longer be reached from their home slot, so that no tombstones are needed.
+     */
+    next = (pos + 1) % index->num_slots;
+    while (index->slots[next] != ITS_METADATA_INVALID_INDEX) {
+        home = index->fid_hash[index->slots[next]] % index->num_slots;
+
+        /* The entry can stay unless its home slot is cyclically in
+         * (pos, next].
+         */
+        if ((pos <= next) ? ((home <= pos) || (home > next))
+                          : ((home <= pos) && (home > next))) {
+            index->slots[pos] = index->slots[next];
+            index->slots[next] = ITS_METADATA_INVALID_INDEX;
+            pos = next;
+        }
+
+        next = (next + 1) % index->num_slots;
+    }
+}
+
+/**
+ * \brief Rebuilds the RAM file index from the active metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_index_build(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t tmp_metadata;
+
+    if (!index->enabled) {
+        return PSA_SUCCESS;
+    }
+
+    (void)memset(index->used, 0,
+                 ((fs_ctx->cfg->max_num_files + 31) / 32) * sizeof(uint32_t));
+    (void)memset(index->slots, 0xFF, index->num_slots * sizeof(uint16_t));
+    index->dirty = false;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
+        if (err != PSA_SUCCESS) {
+            /* Leave the index to be rebuilt on the next access */
+            index->dirty = true;
+            return err;
+        }
+
+        if (its_utils_validate_fid(tmp_metadata.id) == PSA_SUCCESS) {
+            its_mblock_index_insert(index, i,
+                                    its_mblock_index_hash(tmp_metadata.id));
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Associates the RAM file index with the buffer provided by the
+ *        filesystem configuration, and clears it.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_mblock_index_init(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint32_t num_files = fs_ctx->cfg->max_num_files;
+
+    index->enabled = (fs_ctx->cfg->file_index_buf != NULL);
+    if (!index->enabled) {
+        return;
+    }
+
+    index->used = fs_ctx->cfg->file_index_buf;
+    index->fid_hash = (uint16_t *)(index->used + ((num_files + 31) / 32));
+    index->slots = index->fid_hash + num_files;
+    index->num_slots = 2 * num_files;
+
+    (void)memset(index->used, 0, ((num_files + 31) / 32) * sizeof(uint32_t));
+    (void)memset(index->slots, 0xFF, index->num_slots * sizeof(uint16_t));
+    index->dirty = false;
+}
+
+/**
+ * \brief Makes sure the RAM file index reflects the active metadata block.
+ *
+ * \details A dirty index means that an update staged in the scratch metadata
+ *          block has been abandoned before being finalized, so the index is
+ *          rebuilt from the active metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+__attribute__((always_inline))
+static inline psa_status_t its_mblock_index_sync(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    if (fs_ctx->file_index.dirty) {
+        return its_mblock_index_build(fs_ctx);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Records in the RAM file index a file metadata entry written into the
+ *        scratch metadata block.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     idx        File metadata entry index
+ * \param[in]     file_meta  File metadata written in the entry
+ */
+static void its_mblock_index_stage(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint32_t idx,
+                                   const struct its_file_meta_t *file_meta)
+{
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    bool was_used;
+    bool is_used;
+    uint16_t hash = 0;
+
+    if (!index->enabled) {
+        return;
+    }
+
+    was_used = its_mblock_index_is_used(index, idx);
+    is_used = (its_utils_validate_fid(file_meta->id) == PSA_SUCCESS);
+    if (is_used) {
+        hash = its_mblock_index_hash(file_meta->id);
+    }
+
+    /* Entries rewritten with the same file ID leave the index unchanged */
+    if (was_used && is_used && (index->fid_hash[idx] == hash)) {
+        return;
+    }
+
+    if (was_used) {
+        its_mblock_index_remove(index, idx);
+        index->dirty = true;
+    }
+
+    if (is_used) {
+        its_mblock_index_insert(index, idx, hash);
+        index->dirty = true;
+    }
+}
+#endif /* ITS_RAM_FILE_INDEX */
+
+#if ITS_JOURNALED_WRITE
+/**
+ * \brief Calculates the check value of a journal record.
+ *
+ * \param[in] idx       File metadata entry index
+ * \param[in] cur_size  Current size of the file
+ *
+ * \return Check value of the record
+ */
+static uint32_t its_mblock_journal_check(uint32_t idx, uint32_t cur_size)
+{
+    uint32_t check = 2166136261U ^ ITS_JOURNAL_CHECK_MAGIC;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(uint32_t); i++) {
+        check = (check ^ ((idx >> (8 * i)) & 0xFFU)) * 16777619U;
+    }
+
+    for (i = 0; i < sizeof(uint32_t); i++) {
+        check = (check ^ ((cur_size >> (8 * i)) & 0xFFU)) * 16777619U;
+    }
+
+    return check;
+}
+
+/**
+ * \brief Gets offset of a journal record slot in metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     slot    Journal record slot
+ *
+ * \return Return offset value in metadata block
+ */
+static size_t its_mblock_journal_offset(struct its_flash_fs_ctx_t *fs_ctx,
+                                        uint32_t slot)
+{
+    return its_mblock_file_meta_offset(fs_ctx, fs_ctx->cfg->max_num_files)
+           + (slot * ITS_JOURNAL_RECORD_SIZE);
+}
+
+/**
+ * \brief Empties the RAM copy of the journal. Called when the active metadata
+ *        block changes, as the journal area of a new active block is erased.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ */
+static void its_mblock_journal_reset(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    fs_ctx->journal.num_entries = 0;
+    fs_ctx->journal.next_slot = 0;
+}
+
+/**
+ * \brief Loads the journal records of the active metadata block in RAM.
+ *
+ * \details Records which are not completely programmed, because of a power
+ *          failure, fail the check and are ignored. Their slot is not reused.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_journal_load(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_journal_t *journal = &fs_ctx->journal;
+    struct its_journal_record_t record;
+    psa_status_t err;
+    uint32_t slot;
+    uint32_t i;
+    bool erased;
+
+    its_mblock_journal_reset(fs_ctx);
+
+    for (slot = 0; slot < ITS_JOURNAL_NUM_RECORDS; slot++) {
+        err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
+                                (uint8_t *)&record,
+                                its_mblock_journal_offset(fs_ctx, slot),
+                                ITS_JOURNAL_RECORD_SIZE);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        erased = true;
+        for (i = 0; i < ITS_JOURNAL_RECORD_SIZE; i++) {
+            if (((uint8_t *)&record)[i] != fs_ctx->cfg->erase_val) {
+                erased = false;
+                break;
+            }
+        }
+
+        if (erased) {
+            continue;
+        }
+
+        /* Any programmed slot, valid or not, is used */
+        journal->next_slot = slot + 1;
+
+        if ((record.check == its_mblock_journal_check(record.idx,
+                                                      record.cur_size)) &&
+            (record.idx < fs_ctx->cfg->max_num_files) &&
+            (record.cur_size <= fs_ctx->cfg->max_file_size)) {
+            journal->entries[journal->num_entries].idx = record.idx;
+            journal->entries[journal->num_entries].cur_size = record.cur_size;
+            journal->num_entries++;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Applies the latest journal record of a file, if any, to the file
+ *        metadata read from the active metadata block.
+ *
+ * \param[in]     fs_ctx     Filesystem context
+ * \param[in]     idx        File metadata entry index
+ * \param[in,out] file_meta  File metadata
+ *
+ * \return true if a journal record applies to the file, false otherwise
+ */
+static bool its_mblock_journal_apply(const struct its_flash_fs_ctx_t *fs_ctx,
+                                     uint32_t idx,
+                                     struct its_file_meta_t *file_meta)
+{
+    const struct its_journal_t *journal = &fs_ctx->journal;
+    uint32_t i = journal->num_entries;
+
+    while (i-- > 0) {
+        if (journal->entries[i].idx == idx) {
+            if (file_meta != NULL) {
+                file_meta->cur_size = journal->entries[i].cur_size;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif /* ITS_JOURNALED_WRITE */
+
 /**
  * \brief Gets a free file metadata table entry.
  *
@@ -480,6 +876,32 @@ static uint32_t its_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
     uint32_t i;
     struct its_file_meta_t tmp_metadata;
 
+#if ITS_RAM_FILE_INDEX
+    if (fs_ctx->file_index.enabled) {
+        if (its_mblock_index_sync(fs_ctx) != PSA_SUCCESS) {
+            return ITS_METADATA_INVALID_INDEX;
+        }
+
+        for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+            /* Skip whole words of entries in use */
+            if ((i % 32 == 0) && (fs_ctx->file_index.used[i / 32] == UINT32_MAX)) {
+                i += 31;
+                continue;
+            }
+
+            if (!its_mblock_index_is_used(&fs_ctx->file_index, i)) {
+                if (!use_spare) {
+                    use_spare = true;
+                    continue;
+                }
+                return i;
+            }
+        }
+
+        return ITS_METADATA_INVALID_INDEX;
+    }
+#endif
+
     for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
         err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
         if (err != PSA_SUCCESS) {
@@ -526,6 +948,7 @@ static psa_status_t its_mblock_erase_scratch_blocks(
     if (err != PSA_SUCCESS) {
         return err;
     }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, erased_blocks, 1);
 
     /* If the number of blocks is bigger than 2, the code needs to erase the
      * scratch block used to process any change in the data block which contains
@@ -537,6 +960,7 @@ static psa_status_t its_mblock_erase_scratch_blocks(
             its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
                                                     (ITS_LOGICAL_DBLOCK0 + 1));
         err = fs_ctx->ops->erase(fs_ctx->cfg, scratch_datablock);
+        ITS_FLASH_FS_STATS_ADD(fs_ctx, erased_blocks, 1);
     }
 
     return err;
@@ -561,6 +985,7 @@ static psa_status_t its_mblock_update_scratch_block_meta(
 
     /* Calculate the position */
     pos = its_mblock_block_meta_offset(lblock);
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, ITS_BLOCK_METADATA_SIZE);
     return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
                               (const uint8_t *)block_meta, pos,
                               ITS_BLOCK_METADATA_SIZE);
@@ -771,6 +1196,7 @@ static psa_status_t its_mblock_write_scratch_meta_header(
 #endif
 
     /* Write the metadata block header */
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, ITS_BLOCK_META_HEADER_SIZE);
     return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
                               (uint8_t *)(&fs_ctx->meta_block_header), 0,
                               ITS_BLOCK_META_HEADER_SIZE);
@@ -970,9 +1396,48 @@ psa_status_t its_flash_fs_mblock_cp_file_meta(struct its_flash_fs_ctx_t *fs_ctx,
                                               uint32_t idx_start,
                                               uint32_t idx_end)
 {
+    size_t pos_start;
+    size_t pos_end;
+#if ITS_JOURNALED_WRITE
+    psa_status_t err;
+    struct its_file_meta_t file_meta;
+    uint32_t idx;
+
+    /* The entries updated by journal records are written with their current
+     * values, which folds the journal into the scratch metadata block.
+     */
+    for (idx = idx_start; idx < idx_end; idx++) {
+        if (!its_mblock_journal_apply(fs_ctx, idx, NULL)) {
+            continue;
+        }
+
+        err = its_flash_fs_mblock_cp_file_meta(fs_ctx, idx_start, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, idx,
+                                                           &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        idx_start = idx + 1;
+    }
+
+    if (idx_start >= idx_end) {
+        return PSA_SUCCESS;
+    }
+#endif /* ITS_JOURNALED_WRITE */
+
     /* Calculate the positions of the two indexes in the metadata block */
-    size_t pos_start = its_mblock_file_meta_offset(fs_ctx, idx_start);
-    size_t pos_end = its_mblock_file_meta_offset(fs_ctx, idx_end);
+    pos_start = its_mblock_file_meta_offset(fs_ctx, idx_start);
+    pos_end = its_mblock_file_meta_offset(fs_ctx, idx_end);
 
     /* Copy all data between the two positions from the scratch metadata block
      * to the active metadata block.
@@ -1002,6 +1467,45 @@ psa_status_t its_flash_fs_mblock_get_file_idx_meta(struct its_flash_fs_ctx_t *fs
     psa_status_t err;
     uint32_t i;
     struct its_file_meta_t tmp_metadata;
+#if ITS_RAM_FILE_INDEX
+    struct its_file_index_t *index = &fs_ctx->file_index;
+    uint16_t hash;
+    uint32_t pos;
+
+    if (index->enabled) {
+        err = its_mblock_index_sync(fs_ctx);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        hash = its_mblock_index_hash(fid);
+        pos = hash % index->num_slots;
+
+        /* Only the entries with a matching hash are read from flash */
+        while (index->slots[pos] != ITS_METADATA_INVALID_INDEX) {
+            i = index->slots[pos];
+            if (index->fid_hash[i] == hash) {
+                err = its_flash_fs_mblock_read_file_meta(fs_ctx, i,
+                                                         &tmp_metadata);
+                if (err != PSA_SUCCESS) {
+                    return PSA_ERROR_GENERIC_ERROR;
+                }
+
+                if (!memcmp(tmp_metadata.id, fid, ITS_FILE_ID_SIZE)) {
+                    /* Found */
+                    *idx = i;
+                    if (file_meta != NULL) {
+                        *file_meta = tmp_metadata;
+                    }
+                    return PSA_SUCCESS;
+                }
+            }
+            pos = (pos + 1) % index->num_slots;
+        }
+
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+#endif
 
     for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
         err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
@@ -1077,7 +1581,28 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
     }
 
     /* Upgrade the metadata header if required. */
-    return its_mblock_upgrade_meta_header(fs_ctx);
+    err = its_mblock_upgrade_meta_header(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#if ITS_JOURNALED_WRITE
+    /* Load the journal before any file metadata is read, so that the journal
+     * records are applied.
+     */
+    err = its_mblock_journal_load(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+#if ITS_RAM_FILE_INDEX
+    /* Build the RAM file index from the active metadata block */
+    its_mblock_index_init(fs_ctx);
+    err = its_mblock_index_build(fs_ctx);
+#endif
+
+    return err;
 }
 
 psa_status_t its_flash_fs_mblock_meta_update_finalize(
@@ -1100,6 +1625,18 @@ psa_status_t its_flash_fs_mblock_meta_update_finalize(
     /* Update the running context */
     its_mblock_swap_metablocks(fs_ctx);
 
+#if ITS_RAM_FILE_INDEX
+    /* The staged changes are now in the active metadata block */
+    fs_ctx->file_index.dirty = false;
+#endif
+
+#if ITS_JOURNALED_WRITE
+    /* The journal records have been folded in the new active metadata block,
+     * and its journal area is erased.
+     */
+    its_mblock_journal_reset(fs_ctx);
+#endif
+
     /* Erase meta block and current scratch block */
     return its_mblock_erase_scratch_blocks(fs_ctx);
 }
@@ -1140,6 +1677,12 @@ psa_status_t its_flash_fs_mblock_read_file_meta(
                             (uint8_t *)file_meta, offset,
                             ITS_FILE_METADATA_SIZE);
 
+#if ITS_JOURNALED_WRITE
+    if (err == PSA_SUCCESS) {
+        (void)its_mblock_journal_apply(fs_ctx, idx, file_meta);
+    }
+#endif
+
 #if ITS_VALIDATE_METADATA_FROM_FLASH
     if (err == PSA_SUCCESS) {
         err = its_mblock_validate_file_meta(fs_ctx, file_meta);
@@ -1246,6 +1789,16 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
     if (err != PSA_SUCCESS) {
         return err;
     }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, erased_blocks, 2);
+
+#if ITS_RAM_FILE_INDEX
+    /* All the file metadata entries are about to be freed */
+    its_mblock_index_init(fs_ctx);
+#endif
+
+#if ITS_JOURNALED_WRITE
+    its_mblock_journal_reset(fs_ctx);
+#endif
 
     fs_ctx->meta_block_header.active_swap_count =
                                     (fs_ctx->cfg->erase_val == 0x00U) ? 1U : 0U;
@@ -1260,8 +1813,7 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
      * datablock, the space available for data is from the end of the metadata
      * to the end of the block.
      */
-    block_meta.data_start =
-        its_mblock_file_meta_offset(fs_ctx, fs_ctx->cfg->max_num_files);
+    block_meta.data_start = its_mblock_lb0_data_start(fs_ctx);
     block_meta.free_size = fs_ctx->cfg->block_size - block_meta.data_start;
     block_meta.phy_id = fs_ctx->scratch_metablock;
     err = its_mblock_update_scratch_block_meta(fs_ctx, ITS_LOGICAL_DBLOCK0,
@@ -1283,6 +1835,7 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
          */
         err |= fs_ctx->ops->erase(fs_ctx->cfg,
                                   i + its_init_dblock_start(fs_ctx));
+        ITS_FLASH_FS_STATS_ADD(fs_ctx, erased_blocks, 1);
     }
 
     /* If an error is detected while erasing the flash, then return a
@@ -1366,13 +1919,23 @@ psa_status_t its_flash_fs_mblock_update_scratch_file_meta(
                                         uint32_t idx,
                                         const struct its_file_meta_t *file_meta)
 {
+    psa_status_t err;
     size_t pos;
 
     /* Calculate the position */
     pos = its_mblock_file_meta_offset(fs_ctx, idx);
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (const uint8_t *)file_meta, pos,
-                              ITS_FILE_METADATA_SIZE);
+    err = fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
+                             (const uint8_t *)file_meta, pos,
+                             ITS_FILE_METADATA_SIZE);
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, ITS_FILE_METADATA_SIZE);
+
+#if ITS_RAM_FILE_INDEX
+    if (err == PSA_SUCCESS) {
+        its_mblock_index_stage(fs_ctx, idx, file_meta);
+    }
+#endif
+
+    return err;
 }
 
 psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
@@ -1405,6 +1968,7 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
         if (status != PSA_SUCCESS) {
             return status;
         }
+        ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, bytes_to_move);
 
         /* Updates pointers to the source and destination flash regions */
         dst_offset += bytes_to_move;
@@ -1416,3 +1980,99 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
 
     return PSA_SUCCESS;
 }
+
+#if ITS_JOURNALED_WRITE
+bool its_flash_fs_mblock_journal_has_space(
+                                        const struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return fs_ctx->journal.next_slot < ITS_JOURNAL_NUM_RECORDS;
+}
+
+psa_status_t its_flash_fs_mblock_journal_append(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t idx,
+                                              size_t cur_size)
+{
+    struct its_journal_t *journal = &fs_ctx->journal;
+    struct its_journal_record_t record;
+    psa_status_t err;
+    uint32_t slot;
+
+    if (!its_flash_fs_mblock_journal_has_space(fs_ctx) ||
+        (idx >= fs_ctx->cfg->max_num_files)) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    memset(&record, fs_ctx->cfg->erase_val, sizeof(record));
+    record.idx = idx;
+    record.cur_size = (uint32_t)cur_size;
+    record.check = its_mblock_journal_check(record.idx, record.cur_size);
+
+    /* Consume the slot before it is programmed, so that it is not reused if
+     * the write fails part way.
+     */
+    slot = journal->next_slot++;
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->active_metablock,
+                             (const uint8_t *)&record,
+                             its_mblock_journal_offset(fs_ctx, slot),
+                             ITS_JOURNAL_RECORD_SIZE);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+    ITS_FLASH_FS_STATS_ADD(fs_ctx, programmed_bytes, ITS_JOURNAL_RECORD_SIZE);
+
+    err = fs_ctx->ops->flush(fs_ctx->cfg, fs_ctx->active_metablock);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    journal->entries[journal->num_entries].idx = record.idx;
+    journal->entries[journal->num_entries].cur_size = record.cur_size;
+    journal->num_entries++;
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_JOURNALED_WRITE */
+
+#if ITS_TRANSACTION
+psa_status_t its_flash_fs_mblock_write_scratch_block_meta(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      const struct its_block_meta_t *block_meta)
+{
+    return its_mblock_update_scratch_block_meta(fs_ctx, lblock, block_meta);
+}
+
+psa_status_t its_flash_fs_mblock_erase_scratch_blocks(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return its_mblock_erase_scratch_blocks(fs_ctx);
+}
+
+psa_status_t its_flash_fs_mblock_file_idx_is_used(
+                                             struct its_flash_fs_ctx_t *fs_ctx,
+                                             uint32_t idx,
+                                             bool *used)
+{
+    struct its_file_meta_t tmp_metadata;
+    psa_status_t err;
+
+#if ITS_RAM_FILE_INDEX
+    if (fs_ctx->file_index.enabled) {
+        err = its_mblock_index_sync(fs_ctx);
+        if (err == PSA_SUCCESS) {
+            *used = its_mblock_index_is_used(&fs_ctx->file_index, idx);
+        }
+        return err;
+    }
+#endif
+
+    err = its_flash_fs_mblock_read_file_meta(fs_ctx, idx, &tmp_metadata);
+    if (err == PSA_SUCCESS) {
+        *used = (its_utils_validate_fid(tmp_metadata.id) == PSA_SUCCESS);
+    }
+
+    return err;
+}
+#endif /* ITS_TRANSACTION */
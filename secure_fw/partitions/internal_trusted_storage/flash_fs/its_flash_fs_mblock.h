@@ -179,6 +179,135 @@ struct its_file_meta_t {
 };
 #undef _T3
 
+#if ITS_JOURNALED_WRITE
+/*!
+ * \struct its_journal_record_t
+ *
+ * \brief Structure to store a journal record. A journal record commits an
+ *        in-place append to a file without swapping the metadata blocks.
+ *
+ * \note The journal records are stored in the active metadata block, between
+ *       the file metadata table and the data of logical block 0.
+ *
+ * \note This structure is programmed to flash, so its size must be padded
+ *       to a multiple of the maximum required flash program unit.
+ */
+#define _T4 \
+    uint32_t idx;       /*!< File metadata entry index */ \
+    uint32_t cur_size;  /*!< New current size of the file */ \
+    uint32_t check;     /*!< Check value, to detect incomplete records */
+
+struct its_journal_record_t {
+    _T4
+#if ((ITS_FLASH_MAX_ALIGNMENT) > 4)
+    uint8_t roundup[sizeof(struct __attribute__((__aligned__(ITS_FLASH_MAX_ALIGNMENT))) { _T4 }) -
+                    sizeof(struct { _T4 })];
+#endif
+};
+#undef _T4
+
+/**
+ * \struct its_journal_t
+ *
+ * \brief RAM copy of the valid journal records of the active metadata block.
+ */
+struct its_journal_t {
+    struct {
+        uint32_t idx;       /**< File metadata entry index */
+        uint32_t cur_size;  /**< Current size of the file */
+    } entries[ITS_JOURNAL_NUM_RECORDS]; /**< Valid records, oldest first */
+    uint32_t num_entries;  /**< Number of valid records */
+    uint32_t next_slot;    /**< Next free record slot in flash */
+};
+#endif /* ITS_JOURNALED_WRITE */
+
+#if ITS_FLASH_FS_STATS
+/**
+ * \struct its_flash_fs_stats_t
+ *
+ * \brief Flash usage counters of a filesystem context. The ratio between
+ *        programmed_bytes and data_bytes is the write amplification.
+ */
+struct its_flash_fs_stats_t {
+    uint32_t data_bytes;        /**< Bytes of file data written by the user */
+    uint32_t programmed_bytes;  /**< Bytes programmed to flash */
+    uint32_t erased_blocks;     /**< Number of blocks erased */
+};
+
+#define ITS_FLASH_FS_STATS_ADD(fs_ctx, field, val) \
+    ((fs_ctx)->stats.field += (uint32_t)(val))
+#else
+#define ITS_FLASH_FS_STATS_ADD(fs_ctx, field, val)
+#endif /* ITS_FLASH_FS_STATS */
+
+#if ITS_RAM_FILE_INDEX
+/**
+ * \struct its_file_index_t
+ *
+ * \brief RAM-resident index of the file metadata table, used to find a file or
+ *        a free file metadata entry without scanning the table in flash.
+ *
+ * \note The storage is provided by the filesystem configuration, see
+ *       ITS_FLASH_FS_FILE_INDEX_WORDS.
+ */
+struct its_file_index_t {
+    uint32_t *used;      /**< Bitmap of the file metadata entries in use */
+    uint16_t *fid_hash;  /**< Hash of the file ID of each entry in use */
+    uint16_t *slots;     /**< Open-addressed hash table of entry indexes */
+    uint32_t num_slots;  /**< Number of slots in the hash table */
+    bool enabled;        /**< Whether the index is used by this context */
+    bool dirty;          /**< Whether the index contains changes which have
+                          *   not been committed to the active metadata block
+                          */
+};
+#endif
+
+#if ITS_TRANSACTION
+/**
+ * \struct its_txn_entry_t
+ *
+ * \brief File metadata entry staged by a transaction.
+ */
+struct its_txn_entry_t {
+    uint32_t idx;                  /**< File metadata entry index */
+    struct its_file_meta_t meta;   /**< New file metadata */
+};
+
+/**
+ * \struct its_txn_t
+ *
+ * \brief State of the transaction of a filesystem context.
+ *
+ * \details The data of the files written by a transaction is programmed in the
+ *          scratch metadata block, for logical block 0, and in the scratch data
+ *          block, for at most one other logical block. The data of the files
+ *          which are kept in these logical blocks is copied after it when the
+ *          transaction is committed. New file data which does not fit there is
+ *          programmed in place in the erased free area of the other logical
+ *          blocks, which the commit then accounts as used.
+ */
+struct its_txn_t {
+    bool active;           /**< Whether a transaction is in progress */
+    bool programmed;       /**< Whether the scratch blocks have been written */
+    uint32_t num_entries;  /**< Number of staged file metadata entries */
+    uint32_t dblock;       /**< Logical block staged in the scratch data block,
+                            *   or ITS_BLOCK_INVALID_ID
+                            */
+    size_t cursor[2];      /**< Next free position for file data in logical
+                            *   block 0 and in the staged logical block
+                            */
+    size_t keep[2];        /**< Size of the data of the files kept in logical
+                            *   block 0 and in the staged logical block
+                            */
+    uint32_t free_idx_pos; /**< Next file metadata entry to look at for a free
+                            *   entry
+                            */
+    uint32_t spare_idx;    /**< Free file metadata entry kept as the spare, or
+                            *   ITS_METADATA_INVALID_INDEX if not found yet
+                            */
+};
+#endif /* ITS_TRANSACTION */
+
 /**
  * \struct its_flash_fs_ctx_t
  *
@@ -192,6 +321,18 @@ struct its_flash_fs_ctx_t {
                                                            */
     uint32_t active_metablock;  /**< Active metadata block */
     uint32_t scratch_metablock; /**< Scratch metadata block */
+#if ITS_RAM_FILE_INDEX
+    struct its_file_index_t file_index; /**< RAM file index */
+#endif
+#if ITS_JOURNALED_WRITE
+    struct its_journal_t journal;       /**< Journal of in-place appends */
+#endif
+#if ITS_FLASH_FS_STATS
+    struct its_flash_fs_stats_t stats;  /**< Flash usage counters */
+#endif
+#if ITS_TRANSACTION
+    struct its_txn_t txn;               /**< Transaction state */
+#endif
 };
 
 /**
@@ -288,6 +429,38 @@ psa_status_t its_flash_fs_mblock_meta_update_finalize(
 psa_status_t its_flash_fs_mblock_migrate_lb0_data_to_scratch(
                                              struct its_flash_fs_ctx_t *fs_ctx);
 
+#if ITS_JOURNALED_WRITE
+/**
+ * \brief Checks if a journal record slot is available in the active metadata
+ *        block.
+ *
+ * \param[in] fs_ctx  Filesystem context
+ *
+ * \return true if a journal record can be appended, false otherwise
+ */
+bool its_flash_fs_mblock_journal_has_space(
+                                       const struct its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Appends a journal record to the active metadata block, which commits
+ *        a new current size for a file without swapping the metadata blocks.
+ *
+ * \note The file data must have been programmed and flushed before the record
+ *       is appended. If the record is not completely programmed because of a
+ *       power failure, it is discarded when the filesystem is prepared again.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     idx       File metadata entry index
+ * \param[in]     cur_size  New current size of the file
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_journal_append(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t idx,
+                                              size_t cur_size);
+#endif /* ITS_JOURNALED_WRITE */
+
 /**
  * \brief Reads specified file metadata.
  *
@@ -376,6 +549,48 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
 void its_flash_fs_mblock_set_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
                                           uint32_t phy_id, uint32_t lblock);
 
+#if ITS_TRANSACTION
+/**
+ * \brief Writes the metadata of one logical block in the scratch metadata
+ *        block, without copying the metadata of the other logical blocks.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
+ * \param[in]     block_meta  Pointer to block's metadata
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_write_scratch_block_meta(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      const struct its_block_meta_t *block_meta);
+
+/**
+ * \brief Erases the scratch metadata block and the scratch data block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_erase_scratch_blocks(
+                                             struct its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Checks if a file metadata entry of the active metadata block is in
+ *        use. The RAM file index is used if it is enabled.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     idx     File metadata entry index
+ * \param[out]    used    Set to true if the entry is in use
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_file_idx_is_used(
+                                             struct its_flash_fs_ctx_t *fs_ctx,
+                                             uint32_t idx,
+                                             bool *used);
+#endif /* ITS_TRANSACTION */
+
 /**
  * \brief Puts logical block's metadata in scratch metadata block
  *
@@ -164,3 +164,87 @@ psa_status_t tfm_its_crypt_file(struct its_flash_fs_file_info_t *finfo,
     return PSA_SUCCESS;
 }
 
+#if ITS_ENCRYPTION_STREAMING
+psa_status_t tfm_its_crypt_chunk(struct its_flash_fs_file_info_t *finfo,
+                                 uint8_t *fid,
+                                 const size_t fid_size,
+                                 const size_t file_size,
+                                 const uint32_t chunk,
+                                 const uint8_t *input,
+                                 const size_t chunk_size,
+                                 uint8_t *output,
+                                 uint8_t *tag,
+                                 const bool is_encrypt)
+{
+    struct tfm_hal_its_auth_crypt_ctx aead_ctx = {0};
+    uint8_t label[ITS_FILE_ID_SIZE + sizeof(chunk)];
+    size_t label_size = fid_size;
+    enum tfm_hal_status_t err;
+
+    if ((finfo == NULL) || (fid_size > ITS_FILE_ID_SIZE)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    err =  tfm_its_fill_enc_add(finfo->add,
+                                sizeof(finfo->add),
+                                fid,
+                                fid_size,
+                                finfo->flags,
+                                file_size);
+    if (err != TFM_HAL_SUCCESS) {
+        return tfm_hal_to_psa_error(err);
+    }
+
+    /* A new nonce is used for each write of the file, and is shared by its
+     * chunks.
+     */
+    if (is_encrypt && (chunk == 0)) {
+        err = tfm_hal_its_aead_generate_nonce(finfo->nonce,
+                                              sizeof(finfo->nonce));
+
+        if (err != TFM_HAL_SUCCESS) {
+            return tfm_hal_to_psa_error(err);
+        }
+    }
+
+    /* The chunks after the first one are encrypted with keys derived from
+     * the file id and the chunk index, so that the nonce is never reused with
+     * the same key. The first chunk uses the key of the whole file, so that a
+     * file of one chunk is encrypted as without ITS_ENCRYPTION_STREAMING.
+     */
+    memcpy(label, fid, fid_size);
+    if (chunk != 0) {
+        memcpy(label + fid_size, &chunk, sizeof(chunk));
+        label_size += sizeof(chunk);
+    }
+
+    /* Set all required parameters for the aead operation context */
+    aead_ctx.nonce = finfo->nonce;
+    aead_ctx.nonce_size = sizeof(finfo->nonce);
+    aead_ctx.deriv_label = label;
+    aead_ctx.deriv_label_size = label_size;
+    aead_ctx.aad = finfo->add;
+    aead_ctx.add_size = sizeof(finfo->add);
+
+    err = tfm_hal_its_aead_setup(&aead_ctx, is_encrypt, chunk_size);
+    if (err != TFM_HAL_SUCCESS) {
+        return tfm_hal_to_psa_error(err);
+    }
+
+    err = tfm_hal_its_aead_update(input, chunk_size, output, chunk_size);
+    if (err == TFM_HAL_SUCCESS) {
+        if (is_encrypt) {
+            err = tfm_hal_its_aead_finish(tag, sizeof(finfo->tag));
+        } else {
+            err = tfm_hal_its_aead_verify(tag, sizeof(finfo->tag));
+        }
+    }
+
+    if (err != TFM_HAL_SUCCESS) {
+        tfm_hal_its_aead_abort();
+        return tfm_hal_to_psa_error(err);
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_ENCRYPTION_STREAMING */
@@ -41,3 +41,38 @@ psa_status_t tfm_its_crypt_file(struct its_flash_fs_file_info_t *finfo,
                                 const size_t output_size,
                                 const bool is_encrypt);
 
+#if ITS_ENCRYPTION_STREAMING
+/**
+ * \brief Perform encryption/decryption of a chunk of a file, which has its
+ *        own authentication tag, using the multi-part tfm_hal_its APIs
+ *
+ * \details When encrypting the first chunk, a new nonce is generated in
+ *          \p finfo. The additional data is computed from the file
+ *          identifier, the file flags and \p file_size. The output can be the
+ *          same buffer as the input.
+ *
+ * \param[in,out] finfo       Pointer to \ref its_flash_fs_file_info_t
+ * \param[in]     fid         File identifier
+ * \param[in]     fid_size    File identifier size in bytes
+ * \param[in]     file_size   Total size of the file data in bytes
+ * \param[in]     chunk       Index of the chunk in the file
+ * \param[in]     input       Input buffer
+ * \param[in]     chunk_size  Size of the chunk in bytes
+ * \param[out]    output      Output buffer, of chunk_size bytes
+ * \param[in,out] tag         Authentication tag of the chunk, computed when
+ *                            encrypting and checked when decrypting
+ * \param[in]     is_encrypt  Set the operation type (encryption/decryption)
+ *
+ * \return PSA_SUCCESS on successful operation or a valid PSA error code
+ */
+psa_status_t tfm_its_crypt_chunk(struct its_flash_fs_file_info_t *finfo,
+                                 uint8_t *fid,
+                                 const size_t fid_size,
+                                 const size_t file_size,
+                                 const uint32_t chunk,
+                                 const uint8_t *input,
+                                 const size_t chunk_size,
+                                 uint8_t *output,
+                                 uint8_t *tag,
+                                 const bool is_encrypt);
+#endif /* ITS_ENCRYPTION_STREAMING */
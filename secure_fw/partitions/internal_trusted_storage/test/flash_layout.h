@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __FLASH_LAYOUT_H__
+#define __FLASH_LAYOUT_H__
+
+/* Minimal flash layout for the host tests of the ITS filesystem. The tests
+ * access the filesystem through their own flash operations, so the flash
+ * driver is only declared to satisfy tfm_hal_its.h.
+ */
+#define TFM_HAL_ITS_FLASH_DRIVER Driver_ITS_TEST_FLASH
+
+#ifndef TFM_HAL_ITS_PROGRAM_UNIT
+#define TFM_HAL_ITS_PROGRAM_UNIT 1
+#endif
+
+#endif /* __FLASH_LAYOUT_H__ */
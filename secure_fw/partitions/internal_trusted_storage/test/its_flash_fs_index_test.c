@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the file lookups of the ITS flash filesystem, which use the RAM
+ * file index when ITS_RAM_FILE_INDEX is enabled: the number of flash reads
+ * made to look up a file, and the lookups after random writes and deletes,
+ * changes interrupted by a power cut and remounts. The same tests run with the
+ * index disabled, as the reference.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_fs/its_flash_fs_mblock.h"
+#include "its_test_flash.h"
+
+/* Files written by the tests, leaving the spare file metadata entries needed
+ * to replace a file.
+ */
+#define NUM_FILES       (ITS_TEST_MAX_NUM_FILES - 2U)
+/* Files looked up by the tests which are never written */
+#define NUM_ABSENT      16U
+#define NUM_SEEDS       32U
+#define NUM_RAND_OPS    48U
+#define UNIT            TFM_HAL_ITS_PROGRAM_UNIT
+#define FILE_SIZE       ITS_UTILS_ALIGN(64U, UNIT)
+
+struct test_file_t {
+    bool exists;
+    size_t size;
+    uint8_t pattern;
+};
+
+static struct its_test_fs_t fs;
+static struct test_file_t files[NUM_FILES];
+
+static void fill_data(uint8_t *buf, size_t size, uint8_t pattern)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(pattern + (i * 7U));
+    }
+}
+
+static psa_status_t write_file(uint32_t num, size_t size, uint8_t pattern)
+{
+    struct its_flash_fs_file_info_t finfo = {0};
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t data[FILE_SIZE];
+
+    its_test_fid(num, fid);
+    fill_data(data, size, pattern);
+    finfo.size_max = size;
+    finfo.flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
+
+    return its_flash_fs_file_write(&fs.ctx, fid, &finfo, size, 0, data);
+}
+
+static psa_status_t delete_file(uint32_t num)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+
+    its_test_fid(num, fid);
+
+    return its_flash_fs_file_delete(&fs.ctx, fid);
+}
+
+/**
+ * \brief Writes or deletes a file, as given by a test file.
+ */
+static psa_status_t change_file(uint32_t num, const struct test_file_t *file)
+{
+    if (!file->exists) {
+        return delete_file(num);
+    }
+
+    return write_file(num, file->size, file->pattern);
+}
+
+/**
+ * \brief Checks whether a file of the filesystem matches a test file.
+ *
+ * \return true if it matches
+ */
+static bool file_matches(uint32_t num, const struct test_file_t *file)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t buf[FILE_SIZE];
+    uint8_t expected[FILE_SIZE];
+    psa_status_t err;
+
+    its_test_fid(num, fid);
+
+    err = its_flash_fs_file_get_info(&fs.ctx, fid, &info);
+    if (!file->exists) {
+        return err == PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if ((err != PSA_SUCCESS) || (info.size_current != file->size)) {
+        return false;
+    }
+
+    fill_data(expected, file->size, file->pattern);
+
+    return (its_flash_fs_file_read(&fs.ctx, fid, file->size, 0, buf)
+            == PSA_SUCCESS) &&
+           (memcmp(buf, expected, file->size) == 0);
+}
+
+/**
+ * \brief Checks whether the filesystem holds the test files, and none of the
+ *        files which are never written.
+ *
+ * \return true if it does
+ */
+static bool fs_matches(void)
+{
+    const struct test_file_t absent = {0};
+    uint32_t i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        if (!file_matches(i, &files[i])) {
+            return false;
+        }
+    }
+
+    for (i = NUM_FILES; i < NUM_FILES + NUM_ABSENT; i++) {
+        if (!file_matches(i, &absent)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Checks whether the lookups of all the files agree with a scan of the
+ *        file metadata table of the active metadata block, which is what the
+ *        filesystem holds until the next update is finalized. A lookup finds
+ *        a file if, and only if, the table has an entry for it.
+ *
+ * \return true if they agree
+ */
+static bool lookups_match_table(void)
+{
+    struct its_flash_fs_file_info_t info;
+    struct its_file_meta_t meta;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    bool in_table;
+    bool size_found;
+    psa_status_t err;
+    uint32_t i;
+    uint32_t idx;
+
+    for (i = 0; i < NUM_FILES + NUM_ABSENT; i++) {
+        its_test_fid(i, fid);
+
+        err = its_flash_fs_file_get_info(&fs.ctx, fid, &info);
+        if ((err != PSA_SUCCESS) && (err != PSA_ERROR_DOES_NOT_EXIST)) {
+            return false;
+        }
+
+        in_table = false;
+        size_found = false;
+        for (idx = 0; idx < ITS_TEST_MAX_NUM_FILES; idx++) {
+            if (its_flash_fs_mblock_read_file_meta(&fs.ctx, idx, &meta)
+                != PSA_SUCCESS) {
+                return false;
+            }
+            if (memcmp(meta.id, fid, ITS_FILE_ID_SIZE) == 0) {
+                in_table = true;
+                if ((err == PSA_SUCCESS) &&
+                    (meta.cur_size == info.size_current)) {
+                    size_found = true;
+                }
+            }
+        }
+
+        if (in_table ? !size_found : (err != PSA_ERROR_DOES_NOT_EXIST)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Looks up files, and counts the flash reads made for it.
+ *
+ * \param[in]  first      Number of the first file
+ * \param[in]  num_files  Number of files to look up
+ * \param[in]  exist      Whether the files exist
+ * \param[out] max_reads  Largest number of reads made for a file
+ *
+ * \return Total number of reads, or UINT32_MAX if a lookup fails
+ */
+static uint32_t count_lookup_reads(uint32_t first, uint32_t num_files,
+                                   bool exist, uint32_t *max_reads)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint32_t total = 0;
+    uint32_t reads;
+    uint32_t i;
+    psa_status_t err;
+
+    *max_reads = 0;
+
+    for (i = first; i < first + num_files; i++) {
+        its_test_fid(i, fid);
+
+        its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+        err = its_flash_fs_file_get_info(&fs.ctx, fid, &info);
+        reads = its_test_flash_num_reads();
+
+        if (err != (exist ? PSA_SUCCESS : PSA_ERROR_DOES_NOT_EXIST)) {
+            return UINT32_MAX;
+        }
+
+        total += reads;
+        if (reads > *max_reads) {
+            *max_reads = reads;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * \brief Counts the flash reads of the lookups of existing and absent files,
+ *        before and after a remount which rebuilds the index.
+ */
+static int test_lookup_reads(void)
+{
+    uint32_t found_reads;
+    uint32_t found_max;
+    uint32_t absent_reads;
+    uint32_t absent_max;
+    uint32_t i;
+    uint32_t pass;
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    for (i = 0; i < NUM_FILES; i++) {
+        TEST_CHECK(write_file(i, 16, (uint8_t)i) == PSA_SUCCESS);
+    }
+
+    for (pass = 0; pass < 2; pass++) {
+        found_reads = count_lookup_reads(0, NUM_FILES, true, &found_max);
+        absent_reads = count_lookup_reads(NUM_FILES, NUM_ABSENT, false,
+                                          &absent_max);
+        TEST_CHECK(found_reads != UINT32_MAX);
+        TEST_CHECK(absent_reads != UINT32_MAX);
+
+        printf("%s: %u lookups of existing files: %u flash reads, at most "
+               "%u per lookup\n", (pass == 0) ? "written" : "mounted",
+               NUM_FILES, found_reads, found_max);
+        printf("%s: %u lookups of absent files: %u flash reads, at most "
+               "%u per lookup\n", (pass == 0) ? "written" : "mounted",
+               NUM_ABSENT, absent_reads, absent_max);
+
+#if ITS_RAM_FILE_INDEX
+        /* Only the file metadata entry of the file is read */
+        TEST_CHECK(found_max <= 1);
+        TEST_CHECK(absent_reads == 0);
+#else
+        /* The file metadata table is scanned up to the file, or entirely */
+        TEST_CHECK(absent_max >= ITS_TEST_MAX_NUM_FILES);
+#endif
+
+        TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Makes random writes and deletes, some of them interrupted by a power
+ *        cut, and remounts, and checks the lookups of all the files after
+ *        each of them.
+ */
+static int test_random(uint32_t seed)
+{
+    struct test_file_t old;
+    struct test_file_t written;
+    struct test_file_t *file;
+    uint32_t op;
+    uint32_t num;
+    psa_status_t err;
+
+    its_test_srand(seed);
+    (void)memset(files, 0, sizeof(files));
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+
+    for (op = 0; op < NUM_RAND_OPS; op++) {
+        num = its_test_rand(NUM_FILES);
+        file = &files[num];
+        old = *file;
+
+        /* Delete the file or write it */
+        if (old.exists && (its_test_rand(3) == 0)) {
+            written = (struct test_file_t){0};
+        } else {
+            written.exists = true;
+            written.size = UNIT * its_test_rand((FILE_SIZE / UNIT) + 1);
+            written.pattern = (uint8_t)its_test_rand(256);
+        }
+
+        if (its_test_rand(4) == 0) {
+            /* Cut the power during the change */
+            its_test_flash_set_budget(its_test_rand(12));
+            err = change_file(num, &written);
+            its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+
+            /* The lookups made before the reset, with the index of the
+             * abandoned update, find the files of the active metadata block.
+             */
+            if (!lookups_match_table()) {
+                printf("seed %u, op %u: file lookups do not match the file "
+                       "metadata table before the reset\n", seed, op);
+                return 1;
+            }
+
+            /* The file is then either unchanged or changed */
+            TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+            *file = ((err == PSA_SUCCESS) || file_matches(num, &written)) ?
+                    written : old;
+        } else {
+            TEST_CHECK(change_file(num, &written) == PSA_SUCCESS);
+            *file = written;
+        }
+
+        if (!fs_matches() || !lookups_match_table()) {
+            printf("seed %u, op %u: file lookups do not match\n", seed, op);
+            return 1;
+        }
+
+        if (its_test_rand(8) == 0) {
+            TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+            TEST_CHECK(fs_matches());
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    if (test_lookup_reads() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    for (seed = 1; seed <= NUM_SEEDS; seed++) {
+        if (test_random(seed) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("PASS: %u seeds\n", NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Power-cut tests of the ITS flash filesystem.
+ *
+ * Random sequences of file creations, appends and deletions are replayed with
+ * the power cut after every possible number of flash program and erase
+ * operations. After each cut, the filesystem is mounted again and must hold
+ * the files as they were either before or after the interrupted operation,
+ * and the files must still accept appends.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "its_test_flash.h"
+
+#define NUM_FILES     4U
+#define NUM_OPS       12U
+#define NUM_SEEDS     64U
+#define MAX_DATA_SIZE 48U
+
+/* Data is written in multiples of the program unit, so that every append is
+ * at an aligned offset.
+ */
+#define UNIT          TFM_HAL_ITS_PROGRAM_UNIT
+
+enum test_op_type_t {
+    TEST_OP_CREATE,
+    TEST_OP_APPEND,
+    TEST_OP_DELETE,
+};
+
+struct test_op_t {
+    enum test_op_type_t type;
+    uint32_t file;
+    size_t size;
+    size_t size_max;
+    uint8_t pattern;
+};
+
+struct test_file_t {
+    bool exists;
+    size_t size;
+    size_t size_max;
+    uint8_t data[ITS_TEST_MAX_FILE_SIZE];
+};
+
+struct test_state_t {
+    struct test_file_t files[NUM_FILES];
+};
+
+static struct test_op_t ops[NUM_OPS];
+static struct test_state_t states[NUM_OPS + 1];
+static struct its_test_fs_t fs;
+
+static void fill_data(uint8_t *buf, size_t size, uint8_t pattern, size_t pos)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(pattern + ((pos + i) * 7U));
+    }
+}
+
+/**
+ * \brief Applies an operation to a state of the files.
+ */
+static void model_apply(const struct test_op_t *op, struct test_state_t *state)
+{
+    struct test_file_t *file = &state->files[op->file];
+
+    switch (op->type) {
+    case TEST_OP_CREATE:
+        file->exists = true;
+        file->size_max = op->size_max;
+        file->size = op->size;
+        fill_data(file->data, op->size, op->pattern, 0);
+        break;
+    case TEST_OP_APPEND:
+        fill_data(file->data + file->size, op->size, op->pattern, file->size);
+        file->size += op->size;
+        break;
+    case TEST_OP_DELETE:
+        file->exists = false;
+        break;
+    }
+}
+
+/**
+ * \brief Generates a random sequence of valid operations and the state of the
+ *        files after each of them.
+ */
+static void generate_ops(void)
+{
+    const struct test_file_t *file;
+    struct test_op_t *op;
+    uint32_t i;
+
+    (void)memset(&states[0], 0, sizeof(states[0]));
+
+    for (i = 0; i < NUM_OPS; i++) {
+        op = &ops[i];
+        op->file = its_test_rand(NUM_FILES);
+        op->pattern = (uint8_t)its_test_rand(256);
+        file = &states[i].files[op->file];
+
+        if (!file->exists) {
+            op->type = TEST_OP_CREATE;
+        } else if ((file->size < file->size_max) && (its_test_rand(4) != 0)) {
+            op->type = TEST_OP_APPEND;
+        } else {
+            op->type = its_test_rand(2) ? TEST_OP_CREATE : TEST_OP_DELETE;
+        }
+
+        if (op->type == TEST_OP_CREATE) {
+            op->size_max = ITS_UTILS_ALIGN(MAX_DATA_SIZE +
+                                   its_test_rand(ITS_TEST_MAX_FILE_SIZE
+                                                 - MAX_DATA_SIZE + 1), UNIT);
+            op->size = UNIT * its_test_rand((MAX_DATA_SIZE / UNIT) + 1);
+        } else if (op->type == TEST_OP_APPEND) {
+            op->size = UNIT * (1 + its_test_rand(ITS_UTILS_MIN(MAX_DATA_SIZE,
+                                          file->size_max - file->size) / UNIT));
+        }
+
+        states[i + 1] = states[i];
+        model_apply(op, &states[i + 1]);
+    }
+}
+
+/**
+ * \brief Runs an operation on the filesystem.
+ */
+static psa_status_t run_op(const struct test_op_t *op,
+                           const struct test_state_t *state)
+{
+    const struct test_file_t *file = &state->files[op->file];
+    struct its_flash_fs_file_info_t finfo = {0};
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t data[MAX_DATA_SIZE];
+
+    its_test_fid(op->file, fid);
+
+    switch (op->type) {
+    case TEST_OP_CREATE:
+        fill_data(data, op->size, op->pattern, 0);
+        finfo.size_max = op->size_max;
+        finfo.flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
+        return its_flash_fs_file_write(&fs.ctx, fid, &finfo, op->size, 0, data);
+    case TEST_OP_APPEND:
+        fill_data(data, op->size, op->pattern, file->size);
+        finfo.size_max = file->size_max;
+        return its_flash_fs_file_write(&fs.ctx, fid, &finfo, op->size,
+                                       file->size, data);
+    case TEST_OP_DELETE:
+        return its_flash_fs_file_delete(&fs.ctx, fid);
+    }
+
+    return PSA_ERROR_GENERIC_ERROR;
+}
+
+/**
+ * \brief Checks whether the files of the filesystem match a state.
+ *
+ * \return true if they match
+ */
+static bool fs_matches(const struct test_state_t *state)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t buf[ITS_TEST_MAX_FILE_SIZE];
+    const struct test_file_t *file;
+    psa_status_t err;
+    uint32_t i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        file = &state->files[i];
+        its_test_fid(i, fid);
+
+        err = its_flash_fs_file_get_info(&fs.ctx, fid, &info);
+        if (!file->exists) {
+            if (err != PSA_ERROR_DOES_NOT_EXIST) {
+                return false;
+            }
+            continue;
+        }
+
+        if ((err != PSA_SUCCESS) || (info.size_current != file->size) ||
+            (info.size_max != file->size_max)) {
+            return false;
+        }
+
+        if ((its_flash_fs_file_read(&fs.ctx, fid, file->size, 0, buf)
+             != PSA_SUCCESS) ||
+            (memcmp(buf, file->data, file->size) != 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Checks that the files left after a power cut can still be appended
+ *        to, and that an append which follows a copy-on-write append is done
+ *        in place again.
+ */
+static int check_appends(struct test_state_t *state)
+{
+    struct test_op_t op = {0};
+    uint32_t erased;
+    bool fallback;
+    uint32_t i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        if (!state->files[i].exists ||
+            ((state->files[i].size + (2 * UNIT)) > state->files[i].size_max)) {
+            continue;
+        }
+
+        op.type = TEST_OP_APPEND;
+        op.file = i;
+        op.size = UNIT;
+        op.pattern = (uint8_t)i;
+
+        erased = its_test_fs_erased_blocks(&fs);
+        TEST_CHECK(run_op(&op, state) == PSA_SUCCESS);
+        model_apply(&op, state);
+        fallback = (its_test_fs_erased_blocks(&fs) != erased);
+
+        erased = its_test_fs_erased_blocks(&fs);
+        TEST_CHECK(run_op(&op, state) == PSA_SUCCESS);
+        model_apply(&op, state);
+
+        /* A metadata block update empties the journal, so once the file has
+         * been rewritten, the next append must be done in place.
+         */
+        if (ITS_JOURNALED_WRITE && fallback) {
+            TEST_CHECK(its_test_fs_erased_blocks(&fs) == erased);
+        }
+    }
+
+    TEST_CHECK(fs_matches(state));
+
+    return 0;
+}
+
+/**
+ * \brief Replays a sequence of operations with the power cut after each
+ *        possible number of flash operations.
+ */
+static int test_seed(uint32_t seed)
+{
+    struct test_state_t state;
+    uint32_t total_ops;
+    uint32_t cut;
+    uint32_t i;
+
+    its_test_srand(seed);
+    generate_ops();
+
+    /* Count the flash operations of the sequence without a power cut */
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+    for (i = 0; i < NUM_OPS; i++) {
+        TEST_CHECK(run_op(&ops[i], &states[i]) == PSA_SUCCESS);
+    }
+    TEST_CHECK(fs_matches(&states[NUM_OPS]));
+    total_ops = its_test_flash_num_ops();
+
+    for (cut = 0; cut < total_ops; cut++) {
+        TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+        its_test_flash_set_budget(cut);
+
+        for (i = 0; i < NUM_OPS; i++) {
+            if (run_op(&ops[i], &states[i]) != PSA_SUCCESS) {
+                break;
+            }
+        }
+        TEST_CHECK(i < NUM_OPS);
+
+        /* Reset */
+        its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+        TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+
+        if (fs_matches(&states[i])) {
+            state = states[i];
+        } else if (fs_matches(&states[i + 1])) {
+            state = states[i + 1];
+        } else {
+            printf("seed %u, cut %u: files do not match the state before or "
+                   "after operation %u\n", seed, cut, i);
+            return 1;
+        }
+
+        if (check_appends(&state) != 0) {
+            printf("seed %u, cut %u: append after the power cut failed\n",
+                   seed, cut);
+            return 1;
+        }
+
+        TEST_CHECK(its_test_flash_num_overwrites() == 0);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Interrupts an in-place append while its data is programmed, and
+ *        checks that the file falls back to a copy-on-write append only once.
+ */
+static int test_interrupted_append(void)
+{
+    struct its_flash_fs_file_info_t finfo = {0};
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t data[32];
+    uint8_t buf[96];
+    uint32_t erased;
+
+    fill_data(data, sizeof(data), 0x3C, 0);
+    its_test_fid(0, fid);
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    finfo.size_max = 128;
+    finfo.flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
+    TEST_CHECK(its_flash_fs_file_write(&fs.ctx, fid, &finfo, 32, 0, data)
+               == PSA_SUCCESS);
+
+    /* Cut the power while the appended data is programmed in place, so that
+     * the area after the file data is no longer erased.
+     */
+    finfo.flags = 0;
+    its_test_flash_set_budget(0);
+    TEST_CHECK(its_flash_fs_file_write(&fs.ctx, fid, &finfo, 32, 32, data)
+               != PSA_SUCCESS);
+
+    its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(its_flash_fs_file_get_info(&fs.ctx, fid, &info) == PSA_SUCCESS);
+    TEST_CHECK(info.size_current == 32);
+
+    /* The area is not erased, so the append is done by copy-on-write */
+    erased = its_test_fs_erased_blocks(&fs);
+    TEST_CHECK(its_flash_fs_file_write(&fs.ctx, fid, &finfo, 32, 32, data)
+               == PSA_SUCCESS);
+#if ITS_JOURNALED_WRITE
+    TEST_CHECK(its_test_fs_erased_blocks(&fs) != erased);
+#endif
+
+    /* The copy leaves the rest of the file erased, so the next append is done
+     * in place again.
+     */
+    erased = its_test_fs_erased_blocks(&fs);
+    TEST_CHECK(its_flash_fs_file_write(&fs.ctx, fid, &finfo, 32, 64, data)
+               == PSA_SUCCESS);
+#if ITS_JOURNALED_WRITE
+    TEST_CHECK(its_test_fs_erased_blocks(&fs) == erased);
+#endif
+
+    TEST_CHECK(its_flash_fs_file_read(&fs.ctx, fid, 96, 0, buf) == PSA_SUCCESS);
+    TEST_CHECK((memcmp(buf, data, 32) == 0) &&
+               (memcmp(buf + 32, data, 32) == 0) &&
+               (memcmp(buf + 64, data, 32) == 0));
+    TEST_CHECK(its_test_flash_num_overwrites() == 0);
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    if (test_interrupted_append() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    for (seed = 1; seed <= NUM_SEEDS; seed++) {
+        if (test_seed(seed) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("PASS: %u seeds\n", NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the transactions of the ITS flash filesystem: commit, abort,
+ * writes of other clients while a transaction is in progress, transactions
+ * which use the free space of all the data blocks, and power cuts during a
+ * transaction and its commit.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "its_test_flash.h"
+
+#define NUM_FILES     7U
+#define NUM_SEEDS     32U
+#define UNIT          TFM_HAL_ITS_PROGRAM_UNIT
+#define FILE_SIZE     ITS_UTILS_ALIGN(200U, UNIT)
+
+/* Files set before the transactions of the power cut tests, and files changed
+ * by them. A file replaced by a transaction takes a second file metadata entry
+ * until the commit, so the ranges only overlap as much as the metadata allows.
+ */
+#define CUT_FIRST_SET     0U
+#define CUT_LAST_SET      3U
+#define CUT_FIRST_TXN     2U
+#define CUT_LAST_TXN      4U
+
+struct test_file_t {
+    bool exists;
+    size_t size;
+    uint8_t pattern;
+};
+
+struct test_state_t {
+    struct test_file_t files[NUM_FILES];
+};
+
+static struct its_test_fs_t fs;
+
+static void fill_data(uint8_t *buf, size_t size, uint8_t pattern)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(pattern + (i * 13U));
+    }
+}
+
+static psa_status_t write_file(uint32_t num, size_t size, uint8_t pattern,
+                               bool in_txn)
+{
+    struct its_flash_fs_file_info_t finfo = {0};
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t data[ITS_TEST_MAX_FILE_SIZE];
+
+    its_test_fid(num, fid);
+    fill_data(data, size, pattern);
+    finfo.size_max = size;
+    finfo.flags = ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
+
+    if (in_txn) {
+        return its_flash_fs_txn_file_write(&fs.ctx, fid, &finfo, size, 0,
+                                           data);
+    }
+
+    return its_flash_fs_file_write(&fs.ctx, fid, &finfo, size, 0, data);
+}
+
+static psa_status_t delete_file(uint32_t num, bool in_txn)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+
+    its_test_fid(num, fid);
+
+    if (in_txn) {
+        return its_flash_fs_txn_file_delete(&fs.ctx, fid);
+    }
+
+    return its_flash_fs_file_delete(&fs.ctx, fid);
+}
+
+/**
+ * \brief Checks whether the files of the filesystem match a state.
+ *
+ * \return true if they match
+ */
+static bool fs_matches(const struct test_state_t *state)
+{
+    struct its_flash_fs_file_info_t info;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint8_t buf[ITS_TEST_MAX_FILE_SIZE];
+    uint8_t expected[ITS_TEST_MAX_FILE_SIZE];
+    const struct test_file_t *file;
+    psa_status_t err;
+    uint32_t i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        file = &state->files[i];
+        its_test_fid(i, fid);
+
+        err = its_flash_fs_file_get_info(&fs.ctx, fid, &info);
+        if (!file->exists) {
+            if (err != PSA_ERROR_DOES_NOT_EXIST) {
+                return false;
+            }
+            continue;
+        }
+
+        if ((err != PSA_SUCCESS) || (info.size_current != file->size)) {
+            return false;
+        }
+
+        fill_data(expected, file->size, file->pattern);
+        if ((its_flash_fs_file_read(&fs.ctx, fid, file->size, 0, buf)
+             != PSA_SUCCESS) ||
+            (memcmp(buf, expected, file->size) != 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Writes the files of a state which are not in the filesystem yet,
+ *        outside of a transaction.
+ */
+static int setup_state(const struct test_state_t *state)
+{
+    uint32_t i;
+
+    for (i = 0; i < NUM_FILES; i++) {
+        if (state->files[i].exists) {
+            TEST_CHECK(write_file(i, state->files[i].size,
+                                  state->files[i].pattern, false)
+                       == PSA_SUCCESS);
+        }
+    }
+
+    return 0;
+}
+
+static int test_commit(void)
+{
+    struct test_state_t before = {0};
+    struct test_state_t after;
+
+    before.files[0] = (struct test_file_t){true, 64, 0x10};
+    before.files[1] = (struct test_file_t){true, 96, 0x20};
+    before.files[2] = (struct test_file_t){true, 32, 0x30};
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    TEST_CHECK(setup_state(&before) == 0);
+
+    /* Replace a file, delete a file and create two files */
+    after = before;
+    after.files[0] = (struct test_file_t){true, 128, 0x11};
+    after.files[1].exists = false;
+    after.files[3] = (struct test_file_t){true, FILE_SIZE, 0x40};
+    after.files[4] = (struct test_file_t){true, 0, 0x50};
+
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(write_file(0, 128, 0x11, true) == PSA_SUCCESS);
+    TEST_CHECK(delete_file(1, true) == PSA_SUCCESS);
+    TEST_CHECK(write_file(3, FILE_SIZE, 0x40, true) == PSA_SUCCESS);
+    TEST_CHECK(write_file(4, 0, 0x50, true) == PSA_SUCCESS);
+
+    /* A file can only be set once in a transaction */
+    TEST_CHECK(write_file(3, 16, 0x41, true) == PSA_ERROR_NOT_SUPPORTED);
+
+    /* The staged changes are not visible before the commit */
+    TEST_CHECK(fs_matches(&before));
+
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(!its_flash_fs_txn_is_active(&fs.ctx));
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(fs_matches(&after));
+
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+    TEST_CHECK(its_test_flash_num_overwrites() == 0);
+
+    return 0;
+}
+
+static int test_abort(void)
+{
+    struct test_state_t before = {0};
+    struct test_state_t after;
+    uint32_t i;
+
+    before.files[0] = (struct test_file_t){true, 64, 0x10};
+    before.files[1] = (struct test_file_t){true, 96, 0x20};
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    TEST_CHECK(setup_state(&before) == 0);
+
+    /* Stage changes in every data block, then abort them */
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(write_file(0, 16, 0x11, true) == PSA_SUCCESS);
+    TEST_CHECK(delete_file(1, true) == PSA_SUCCESS);
+    for (i = 2; i < NUM_FILES; i++) {
+        TEST_CHECK(write_file(i, FILE_SIZE, (uint8_t)i, true) == PSA_SUCCESS);
+    }
+    TEST_CHECK(its_flash_fs_txn_abort(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(its_flash_fs_txn_abort(&fs.ctx) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(fs_matches(&before));
+
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&before));
+
+    /* The areas programmed by the aborted transaction are not reused without
+     * an erase, so the same changes can still be committed.
+     */
+    after = before;
+    after.files[0] = (struct test_file_t){true, 16, 0x12};
+    after.files[1].exists = false;
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(write_file(0, 16, 0x12, true) == PSA_SUCCESS);
+    TEST_CHECK(delete_file(1, true) == PSA_SUCCESS);
+    for (i = 2; i < NUM_FILES; i++) {
+        after.files[i] = (struct test_file_t){true, FILE_SIZE, (uint8_t)~i};
+        TEST_CHECK(write_file(i, FILE_SIZE, (uint8_t)~i, true) == PSA_SUCCESS);
+    }
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+    TEST_CHECK(its_test_flash_num_overwrites() == 0);
+
+    return 0;
+}
+
+/**
+ * \brief The writes which are not part of the transaction in progress are
+ *        refused and leave the transaction intact. The ITS service aborts the
+ *        transaction before a write of another client, which then succeeds,
+ *        and the commit of the aborted transaction fails.
+ */
+static int test_interleaved(void)
+{
+    struct test_state_t before = {0};
+    struct test_state_t after;
+
+    before.files[0] = (struct test_file_t){true, 64, 0x10};
+    before.files[1] = (struct test_file_t){true, 96, 0x20};
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    TEST_CHECK(setup_state(&before) == 0);
+
+    after = before;
+    after.files[0] = (struct test_file_t){true, 48, 0x11};
+    after.files[2] = (struct test_file_t){true, FILE_SIZE, 0x30};
+
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(write_file(0, 48, 0x11, true) == PSA_SUCCESS);
+
+    TEST_CHECK(write_file(1, 32, 0x21, false) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(write_file(3, 32, 0x31, false) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(delete_file(1, false) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(its_flash_fs_txn_is_active(&fs.ctx));
+
+    /* Reads of the other clients see the committed data */
+    TEST_CHECK(fs_matches(&before));
+
+    TEST_CHECK(write_file(2, FILE_SIZE, 0x30, true) == PSA_SUCCESS);
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+
+    /* The other clients can write again once the transaction is over */
+    after.files[1] = (struct test_file_t){true, 32, 0x21};
+    TEST_CHECK(write_file(1, 32, 0x21, false) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+
+    /* A write of another client, after the transaction has been aborted */
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(write_file(0, 16, 0x12, true) == PSA_SUCCESS);
+    TEST_CHECK(its_flash_fs_txn_abort(&fs.ctx) == PSA_SUCCESS);
+    after.files[3] = (struct test_file_t){true, 32, 0x31};
+    TEST_CHECK(write_file(3, 32, 0x31, false) == PSA_SUCCESS);
+    TEST_CHECK(write_file(2, 16, 0x32, true) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_ERROR_BAD_STATE);
+    TEST_CHECK(fs_matches(&after));
+
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+    TEST_CHECK(its_test_flash_num_overwrites() == 0);
+
+    return 0;
+}
+
+/**
+ * \brief A transaction can create files in the free space of all the data
+ *        blocks, not only in logical block 0 and one other data block.
+ */
+static int test_fill(void)
+{
+    struct test_state_t after = {0};
+    uint32_t i;
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+
+    TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+    for (i = 0; i < NUM_FILES; i++) {
+        after.files[i] = (struct test_file_t){true, ITS_TEST_MAX_FILE_SIZE,
+                                              (uint8_t)i};
+        TEST_CHECK(write_file(i, ITS_TEST_MAX_FILE_SIZE, (uint8_t)i, true)
+                   == PSA_SUCCESS);
+    }
+    TEST_CHECK(its_flash_fs_txn_commit(&fs.ctx) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+
+    /* The files allocated in place can be replaced and deleted as usual */
+    after.files[NUM_FILES - 1] = (struct test_file_t){true, 24, 0x77};
+    TEST_CHECK(write_file(NUM_FILES - 1, 24, 0x77, false) == PSA_SUCCESS);
+    after.files[NUM_FILES - 2].exists = false;
+    TEST_CHECK(delete_file(NUM_FILES - 2, false) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+
+    TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+    TEST_CHECK(its_test_flash_num_overwrites() == 0);
+
+    return 0;
+}
+
+/**
+ * \brief Runs a random transaction which changes the files from CUT_FIRST_TXN
+ *        to CUT_LAST_TXN, and builds the state after it.
+ */
+static psa_status_t run_txn(const struct test_state_t *before,
+                            struct test_state_t *after, uint32_t seed)
+{
+    struct test_file_t *file;
+    psa_status_t err;
+    uint32_t i;
+
+    its_test_srand(seed);
+    *after = *before;
+
+    err = its_flash_fs_txn_begin(&fs.ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    for (i = CUT_FIRST_TXN; i <= CUT_LAST_TXN; i++) {
+        file = &after->files[i];
+
+        if (file->exists && (its_test_rand(3) == 0)) {
+            file->exists = false;
+            err = delete_file(i, true);
+        } else {
+            file->exists = true;
+            file->size = UNIT * its_test_rand((FILE_SIZE / UNIT) + 1);
+            file->pattern = (uint8_t)its_test_rand(256);
+            err = write_file(i, file->size, file->pattern, true);
+        }
+
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return its_flash_fs_txn_commit(&fs.ctx);
+}
+
+/**
+ * \brief Cuts the power at every point of a transaction and of its commit.
+ *        The filesystem must then hold the files as they were either before
+ *        or after the transaction, and accept a new transaction.
+ */
+static int test_powercut(uint32_t seed)
+{
+    struct test_state_t before = {0};
+    struct test_state_t after;
+    struct test_state_t retry;
+    uint32_t total_ops;
+    uint32_t cut;
+    uint32_t i;
+
+    its_test_srand(seed);
+    for (i = CUT_FIRST_SET; i <= CUT_LAST_SET; i++) {
+        if (its_test_rand(2) != 0) {
+            before.files[i] = (struct test_file_t){true,
+                                   UNIT * its_test_rand((FILE_SIZE / UNIT) + 1),
+                                   (uint8_t)its_test_rand(256)};
+        }
+    }
+
+    TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+    TEST_CHECK(setup_state(&before) == 0);
+    its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+    TEST_CHECK(run_txn(&before, &after, seed) == PSA_SUCCESS);
+    TEST_CHECK(fs_matches(&after));
+    total_ops = its_test_flash_num_ops();
+
+    for (cut = 0; cut < total_ops; cut++) {
+        TEST_CHECK(its_test_fs_format(&fs) == PSA_SUCCESS);
+        TEST_CHECK(setup_state(&before) == 0);
+
+        /* The power cut draws random numbers, so the state built by this
+         * run is not the one after the transaction.
+         */
+        its_test_flash_set_budget(cut);
+        TEST_CHECK(run_txn(&before, &retry, seed) != PSA_SUCCESS);
+
+        /* Reset */
+        its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+        TEST_CHECK(its_test_fs_mount(&fs) == PSA_SUCCESS);
+
+        if (!fs_matches(&before) && !fs_matches(&after)) {
+            printf("seed %u, cut %u: files do not match the state before or "
+                   "after the transaction\n", seed, cut);
+            return 1;
+        }
+
+        /* The filesystem accepts a new transaction, whatever the areas left
+         * programmed by the interrupted one.
+         */
+        TEST_CHECK(its_flash_fs_txn_begin(&fs.ctx) == PSA_SUCCESS);
+        TEST_CHECK(its_flash_fs_txn_abort(&fs.ctx) == PSA_SUCCESS);
+        if (fs_matches(&before)) {
+            TEST_CHECK(run_txn(&before, &retry, seed) == PSA_SUCCESS);
+            TEST_CHECK(fs_matches(&after));
+        }
+
+        TEST_CHECK(its_test_flash_num_overwrites() == 0);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    if ((test_commit() != 0) || (test_abort() != 0) ||
+        (test_interleaved() != 0) || (test_fill() != 0)) {
+        return EXIT_FAILURE;
+    }
+
+    for (seed = 1; seed <= NUM_SEEDS; seed++) {
+        if (test_powercut(seed) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("PASS: %u seeds\n", NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __ITS_TEST_CONFIG_H__
+#define __ITS_TEST_CONFIG_H__
+
+/* Project configuration of the host tests of the ITS filesystem. Options which
+ * are not set here, or by the test build, take their config_base.h default.
+ */
+#define ITS_FLASH_FS_STATS                     1
+
+#ifndef ITS_RAM_FS
+#define ITS_RAM_FS                             1
+#endif
+
+#ifndef ITS_JOURNALED_WRITE
+#define ITS_JOURNALED_WRITE                    1
+#endif
+
+#ifndef ITS_JOURNAL_NUM_RECORDS
+#define ITS_JOURNAL_NUM_RECORDS                4
+#endif
+
+#ifndef ITS_TRANSACTION
+#define ITS_TRANSACTION                        1
+#endif
+
+#endif /* __ITS_TEST_CONFIG_H__ */
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "its_test_flash.h"
+
+#include <string.h>
+
+#include "flash/its_flash_ram.h"
+
+#define ITS_TEST_ERASE_VAL 0xFFU
+
+static uint8_t its_test_flash_mem[ITS_TEST_BLOCK_SIZE * ITS_TEST_NUM_BLOCKS];
+
+static uint32_t flash_budget = ITS_TEST_FLASH_NO_CUT;
+static uint32_t flash_num_ops;
+static uint32_t flash_num_reads;
+static uint32_t flash_num_overwrites;
+static bool flash_is_cut;
+static uint32_t rand_state = 1;
+
+/**
+ * \brief Uses up one program or erase operation of the budget.
+ *
+ * \param[in]  size       Size of the range of the operation
+ * \param[out] done_size  Size of the range which is actually programmed or
+ *                        erased
+ *
+ * \return PSA_SUCCESS if the operation completes, otherwise
+ *         PSA_ERROR_STORAGE_FAILURE
+ */
+static psa_status_t its_test_flash_use_budget(size_t size, size_t *done_size)
+{
+    *done_size = 0;
+
+    if (flash_is_cut) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    flash_num_ops++;
+
+    if (flash_budget == ITS_TEST_FLASH_NO_CUT) {
+        *done_size = size;
+        return PSA_SUCCESS;
+    }
+
+    if (flash_budget == 0) {
+        /* The power is cut while the operation is in progress, after it has
+         * changed at least one byte.
+         */
+        flash_is_cut = true;
+        *done_size = (size != 0) ? (1 + its_test_rand(size)) : 0;
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    flash_budget--;
+    *done_size = size;
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t its_test_flash_init(const struct its_flash_fs_config_t *cfg)
+{
+    return its_flash_fs_ops_ram.init(cfg);
+}
+
+static psa_status_t its_test_flash_read(const struct its_flash_fs_config_t *cfg,
+                                        uint32_t block_id, uint8_t *buff,
+                                        size_t offset, size_t size)
+{
+    flash_num_reads++;
+
+    return its_flash_fs_ops_ram.read(cfg, block_id, buff, offset, size);
+}
+
+static psa_status_t its_test_flash_write(const struct its_flash_fs_config_t *cfg,
+                                         uint32_t block_id, const uint8_t *buff,
+                                         size_t offset, size_t size)
+{
+    const uint8_t *cur = its_test_flash_mem + (block_id * cfg->block_size)
+                         + offset;
+    psa_status_t ret;
+    size_t done_size;
+    size_t i;
+
+    ret = its_test_flash_use_budget(size, &done_size);
+
+    for (i = 0; i < done_size; i++) {
+        if ((cur[i] != cfg->erase_val) && (cur[i] != buff[i])) {
+            flash_num_overwrites++;
+        }
+    }
+
+    if (done_size != 0) {
+        (void)its_flash_fs_ops_ram.write(cfg, block_id, buff, offset,
+                                         done_size);
+    }
+
+    return ret;
+}
+
+static psa_status_t its_test_flash_flush(const struct its_flash_fs_config_t *cfg,
+                                         uint32_t block_id)
+{
+    if (flash_is_cut) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    return its_flash_fs_ops_ram.flush(cfg, block_id);
+}
+
+static psa_status_t its_test_flash_erase(const struct its_flash_fs_config_t *cfg,
+                                         uint32_t block_id)
+{
+    psa_status_t ret;
+    size_t done_size;
+
+    ret = its_test_flash_use_budget(cfg->block_size, &done_size);
+    if (ret == PSA_SUCCESS) {
+        return its_flash_fs_ops_ram.erase(cfg, block_id);
+    }
+
+    /* An interrupted erase leaves the start of the block erased */
+    (void)memset(its_test_flash_mem + (block_id * cfg->block_size),
+                 cfg->erase_val, done_size);
+
+    return ret;
+}
+
+const struct its_flash_fs_ops_t its_test_flash_ops = {
+    .init = its_test_flash_init,
+    .read = its_test_flash_read,
+    .write = its_test_flash_write,
+    .flush = its_test_flash_flush,
+    .erase = its_test_flash_erase,
+};
+
+void its_test_flash_set_budget(uint32_t num_ops)
+{
+    flash_budget = num_ops;
+    flash_num_ops = 0;
+    flash_num_reads = 0;
+    flash_is_cut = false;
+}
+
+uint32_t its_test_flash_num_ops(void)
+{
+    return flash_num_ops;
+}
+
+uint32_t its_test_flash_num_reads(void)
+{
+    return flash_num_reads;
+}
+
+uint32_t its_test_flash_num_overwrites(void)
+{
+    return flash_num_overwrites;
+}
+
+void its_test_srand(uint32_t seed)
+{
+    rand_state = (seed != 0) ? seed : 1;
+}
+
+uint32_t its_test_rand(uint32_t bound)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+
+    return rand_state % bound;
+}
+
+/**
+ * \brief Sets the filesystem configuration of the test flash.
+ *
+ * \param[out] fs  Test filesystem
+ */
+static void its_test_fs_init_cfg(struct its_test_fs_t *fs)
+{
+    (void)memset(&fs->cfg, 0, sizeof(fs->cfg));
+
+    fs->cfg.flash_dev = its_test_flash_mem;
+    fs->cfg.sector_size = ITS_TEST_BLOCK_SIZE;
+    fs->cfg.block_size = ITS_TEST_BLOCK_SIZE;
+    fs->cfg.num_blocks = ITS_TEST_NUM_BLOCKS;
+    fs->cfg.program_unit = TFM_HAL_ITS_PROGRAM_UNIT;
+    fs->cfg.max_file_size = ITS_TEST_MAX_FILE_SIZE;
+    fs->cfg.max_num_files = ITS_TEST_MAX_NUM_FILES;
+    fs->cfg.erase_val = ITS_TEST_ERASE_VAL;
+#if ITS_RAM_FILE_INDEX
+    fs->cfg.file_index_buf = fs->index_buf;
+#endif
+#if ITS_TRANSACTION
+    fs->cfg.txn_entries = fs->txn_entries;
+    fs->cfg.txn_max_entries = ITS_TEST_TXN_MAX_ENTRIES;
+#endif
+}
+
+psa_status_t its_test_fs_format(struct its_test_fs_t *fs)
+{
+    psa_status_t err;
+
+    its_test_flash_set_budget(ITS_TEST_FLASH_NO_CUT);
+    (void)memset(its_test_flash_mem, ITS_TEST_ERASE_VAL,
+                 sizeof(its_test_flash_mem));
+    flash_num_overwrites = 0;
+
+    its_test_fs_init_cfg(fs);
+
+    err = its_flash_fs_init_ctx(&fs->ctx, &fs->cfg, &its_test_flash_ops);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = its_flash_fs_wipe_all(&fs->ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return its_flash_fs_prepare(&fs->ctx);
+}
+
+psa_status_t its_test_fs_mount(struct its_test_fs_t *fs)
+{
+    psa_status_t err;
+
+    its_test_fs_init_cfg(fs);
+
+    err = its_flash_fs_init_ctx(&fs->ctx, &fs->cfg, &its_test_flash_ops);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return its_flash_fs_prepare(&fs->ctx);
+}
+
+void its_test_fid(uint32_t num, uint8_t *fid)
+{
+    (void)memset(fid, 0, ITS_FILE_ID_SIZE);
+    (void)memcpy(fid, &num, sizeof(num));
+    fid[ITS_FILE_ID_SIZE - 1] = 0xA5;
+}
+
+uint32_t its_test_fs_erased_blocks(const struct its_test_fs_t *fs)
+{
+    struct its_flash_fs_stats_t stats;
+
+    its_flash_fs_get_stats(&fs->ctx, &stats);
+
+    return stats.erased_blocks;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __ITS_TEST_FLASH_H__
+#define __ITS_TEST_FLASH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "flash_fs/its_flash_fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Geometry of the flash emulated in RAM by the host tests */
+#define ITS_TEST_BLOCK_SIZE       1024U
+#define ITS_TEST_NUM_BLOCKS       6U
+#define ITS_TEST_MAX_FILE_SIZE    256U
+#define ITS_TEST_MAX_NUM_FILES    8U
+#define ITS_TEST_TXN_MAX_ENTRIES  8U
+
+/* Flash operation budget which never runs out */
+#define ITS_TEST_FLASH_NO_CUT     UINT32_MAX
+
+/**
+ * \brief Checks a condition in a test function returning int, and fails the
+ *        test if it does not hold.
+ */
+#define TEST_CHECK(cond)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                     \
+        }                                                                 \
+    } while (0)
+
+/**
+ * \struct its_test_fs_t
+ *
+ * \brief Filesystem context and configuration used by the host tests.
+ */
+struct its_test_fs_t {
+    its_flash_fs_ctx_t ctx;               /**< Filesystem context */
+    struct its_flash_fs_config_t cfg;     /**< Filesystem configuration */
+#if ITS_RAM_FILE_INDEX
+    uint32_t index_buf[ITS_FLASH_FS_FILE_INDEX_WORDS(ITS_TEST_MAX_NUM_FILES)];
+#endif
+#if ITS_TRANSACTION
+    struct its_txn_entry_t txn_entries[ITS_TEST_TXN_MAX_ENTRIES];
+#endif
+};
+
+/**
+ * \brief Flash operations of the test flash. They forward to the RAM flash
+ *        operations of its_flash_ram.c, and emulate a power cut once the
+ *        program and erase budget set by \ref its_test_flash_set_budget is
+ *        used up.
+ */
+extern const struct its_flash_fs_ops_t its_test_flash_ops;
+
+/**
+ * \brief Sets the number of program and erase operations which complete
+ *        before the power is cut, and restores the power.
+ *
+ * \details The operation which runs out of budget only programs or erases a
+ *          part of its range, and every following program or erase operation
+ *          fails with PSA_ERROR_STORAGE_FAILURE until the budget is set again.
+ *
+ * \param[in] num_ops  Number of operations, or ITS_TEST_FLASH_NO_CUT
+ */
+void its_test_flash_set_budget(uint32_t num_ops);
+
+/**
+ * \brief Gets the number of program and erase operations issued since the
+ *        last call to \ref its_test_flash_set_budget.
+ *
+ * \return Number of operations
+ */
+uint32_t its_test_flash_num_ops(void);
+
+/**
+ * \brief Gets the number of read operations issued since the last call to
+ *        \ref its_test_flash_set_budget.
+ *
+ * \return Number of operations
+ */
+uint32_t its_test_flash_num_reads(void);
+
+/**
+ * \brief Gets the number of bytes which have been programmed over a
+ *        programmed location with a different value, which a NOR flash cannot
+ *        do without an erase.
+ *
+ * \return Number of bytes
+ */
+uint32_t its_test_flash_num_overwrites(void);
+
+/**
+ * \brief Seeds the pseudo-random generator of the tests.
+ *
+ * \param[in] seed  Seed
+ */
+void its_test_srand(uint32_t seed);
+
+/**
+ * \brief Gets a pseudo-random number.
+ *
+ * \param[in] bound  Exclusive upper bound of the number, greater than 0
+ *
+ * \return Number between 0 and bound - 1
+ */
+uint32_t its_test_rand(uint32_t bound);
+
+/**
+ * \brief Erases the test flash and creates an empty filesystem on it.
+ *
+ * \param[out] fs  Test filesystem
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_test_fs_format(struct its_test_fs_t *fs);
+
+/**
+ * \brief Mounts the filesystem stored in the test flash with a new context, as
+ *        done after a reset.
+ *
+ * \param[out] fs  Test filesystem
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_test_fs_mount(struct its_test_fs_t *fs);
+
+/**
+ * \brief Builds the file ID of a test file.
+ *
+ * \param[in]  num  Number of the file
+ * \param[out] fid  File ID, of ITS_FILE_ID_SIZE bytes
+ */
+void its_test_fid(uint32_t num, uint8_t *fid);
+
+/**
+ * \brief Gets the number of blocks erased by the filesystem.
+ *
+ * \param[in] fs  Test filesystem
+ *
+ * \return Number of blocks
+ */
+uint32_t its_test_fs_erased_blocks(const struct its_test_fs_t *fs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ITS_TEST_FLASH_H__ */
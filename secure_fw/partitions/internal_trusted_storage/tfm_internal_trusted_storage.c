@@ -49,26 +49,87 @@ static uint8_t __ALIGNED(4) asset_data[ITS_UTILS_ALIGN(ITS_BUF_SIZE,
                                           ITS_FLASH_MAX_ALIGNMENT)];
 #endif
 
+#if defined(ITS_ENCRYPTION) && ITS_ENCRYPTION_STREAMING
+/* Size of the chunks of the encrypted files, each one with its own
+ * authentication tag
+ */
+#define ITS_ENC_CHUNK_SIZE  ITS_BUF_SIZE
+
+/* Size of a chunk and of its tag in the file, aligned so that each chunk can
+ * be written separately. The tag of the last chunk of a file is stored in the
+ * file metadata instead.
+ */
+#define ITS_ENC_CHUNK_STRIDE ITS_UTILS_ALIGN(ITS_ENC_CHUNK_SIZE + \
+                                             TFM_ITS_AUTH_TAG_LENGTH, \
+                                             ITS_FLASH_ALIGNMENT)
+
+/* Size in the filesystem of an encrypted file of the given data size */
+#define ITS_ENC_FILE_SIZE(size) ((size) + \
+    (((size) == 0) ? 0 : (((size) - 1) / ITS_ENC_CHUNK_SIZE)) * \
+    (ITS_ENC_CHUNK_STRIDE - ITS_ENC_CHUNK_SIZE))
+
+#define ITS_MAX_FILE_SIZE   ITS_ENC_FILE_SIZE(ITS_MAX_ASSET_SIZE)
+#else
+#define ITS_MAX_FILE_SIZE   ITS_MAX_ASSET_SIZE
+#endif /* ITS_ENCRYPTION && ITS_ENCRYPTION_STREAMING */
+
 #ifdef TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+#if ITS_RAM_FILE_INDEX
+static uint32_t its_file_index_buf[ITS_FLASH_FS_FILE_INDEX_WORDS(ITS_NUM_ASSETS + 1)];
+#endif
+#if ITS_TRANSACTION
+static struct its_txn_entry_t its_txn_entries[ITS_TRANSACTION_MAX_FILES];
+#endif
 static its_flash_fs_ctx_t fs_ctx_its;
 static struct its_flash_fs_config_t fs_cfg_its = {
     .flash_dev = &ITS_FLASH_DEV,
     .program_unit = ITS_FLASH_ALIGNMENT,
-    .max_file_size = ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE, ITS_FLASH_ALIGNMENT),
+    .max_file_size = ITS_UTILS_ALIGN(ITS_MAX_FILE_SIZE, ITS_FLASH_ALIGNMENT),
     .max_num_files = ITS_NUM_ASSETS + 1, /* Extra file for atomic replacement */
+#if ITS_RAM_FILE_INDEX
+    .file_index_buf = its_file_index_buf,
+#endif
+#if ITS_TRANSACTION
+    .txn_entries = its_txn_entries,
+    .txn_max_entries = ITS_TRANSACTION_MAX_FILES,
+#endif
 };
 #endif /* TFM_PARTITION_INTERNAL_TRUSTED_STORAGE */
 
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
+#if ITS_RAM_FILE_INDEX
+static uint32_t ps_file_index_buf[ITS_FLASH_FS_FILE_INDEX_WORDS(PS_MAX_NUM_OBJECTS)];
+#endif
 static its_flash_fs_ctx_t fs_ctx_ps;
 static struct its_flash_fs_config_t fs_cfg_ps = {
     .flash_dev = &PS_FLASH_DEV,
     .program_unit = PS_FLASH_ALIGNMENT,
     .max_file_size = ITS_UTILS_ALIGN(PS_MAX_OBJECT_SIZE, PS_FLASH_ALIGNMENT),
     .max_num_files = PS_MAX_NUM_OBJECTS,
+#if ITS_RAM_FILE_INDEX
+    .file_index_buf = ps_file_index_buf,
+#endif
 };
 #endif
 
+#if ITS_TRANSACTION
+/* Client which has started the transaction in progress, if any */
+static bool its_txn_open;
+static int32_t its_txn_client_id;
+
+/**
+ * \brief Checks if the writes of a client are staged in a transaction.
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return true if the client has started a transaction, false otherwise
+ */
+static bool its_txn_owned(int32_t client_id)
+{
+    return its_txn_open && (its_txn_client_id == client_id);
+}
+#endif /* ITS_TRANSACTION */
+
 static its_flash_fs_ctx_t *get_fs_ctx(int32_t client_id)
 {
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
@@ -84,7 +145,139 @@ static its_flash_fs_ctx_t *get_fs_ctx(int32_t client_id)
 #endif
 }
 
+#if ITS_TRANSACTION
+/**
+ * \brief Aborts the transaction of another client on the storage of a client,
+ *        before the client changes it. The staged changes of a transaction
+ *        are only preserved if no other change is made to the storage until
+ *        it is committed, and a transaction must not block the writes of the
+ *        other clients. The owner of the aborted transaction gets
+ *        PSA_ERROR_BAD_STATE when it stages another change or commits.
+ *
+ * \param[in] client_id  Identifier of the client
+ */
+static void its_txn_preempt(int32_t client_id)
+{
+    its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(client_id);
+
+    if (its_txn_open && (its_txn_client_id != client_id) &&
+        (get_fs_ctx(its_txn_client_id) == fs_ctx) &&
+        its_flash_fs_txn_is_active(fs_ctx)) {
+        (void)its_flash_fs_txn_abort(fs_ctx);
+    }
+}
+#endif /* ITS_TRANSACTION */
+
 #ifdef ITS_ENCRYPTION
+#if ITS_ENCRYPTION_STREAMING
+/* Buffer to store an encrypted chunk and its tag */
+static uint8_t enc_asset_data[ITS_UTILS_ALIGN(ITS_ENC_CHUNK_STRIDE,
+                                              ITS_FLASH_MAX_ALIGNMENT)];
+
+/**
+ * \brief Checks if the files of a client are encrypted.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return true if the files of the client are encrypted, false otherwise
+ */
+static bool tfm_its_is_encrypted(int32_t client_id)
+{
+/* With protected storage no encryption is used */
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+    return client_id != TFM_SP_PS;
+#else
+    (void)client_id;
+    return true;
+#endif /* TFM_PARTITION_PROTECTED_STORAGE */
+}
+
+/**
+ * \brief Gets the size of the data of an encrypted file.
+ *
+ * \param[in] file_size  Size of the file in the filesystem
+ *
+ * \return Size of the data of the file
+ */
+static size_t tfm_its_enc_data_size(size_t file_size)
+{
+    size_t num_tags = (file_size == 0) ? 0 :
+                      (file_size - 1) / ITS_ENC_CHUNK_STRIDE;
+
+    return file_size - num_tags * (ITS_ENC_CHUNK_STRIDE - ITS_ENC_CHUNK_SIZE);
+}
+
+/**
+ * \brief Reads and decrypts the chunks of the file which overlap the
+ *        requested data, and writes the requested part of each chunk to the
+ *        caller once the chunk is authenticated.
+ *
+ * \param[in]  client_id      Identifier of the asset's owner (client)
+ * \param[in]  data_offset    Offset of the requested data in the file
+ * \param[in]  data_size      Size of the requested data
+ * \param[out] p_data_length  On error, set to 0
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t tfm_its_get_encrypted(int32_t client_id,
+                         size_t data_offset,
+                         size_t data_size,
+                         size_t *p_data_length)
+{
+    psa_status_t status;
+    size_t file_size = g_file_info.size_current;
+    uint32_t chunk = data_offset / ITS_ENC_CHUNK_SIZE;
+    size_t pos = (size_t)chunk * ITS_ENC_CHUNK_SIZE;
+    size_t chunk_size;
+    size_t copy_start;
+    size_t copy_end;
+    bool is_last;
+
+    while (pos < data_offset + data_size) {
+        chunk_size = ITS_UTILS_MIN(file_size - pos, ITS_ENC_CHUNK_SIZE);
+        is_last = (pos + chunk_size == file_size);
+
+        /* Read the chunk, and its tag unless it is in the file metadata */
+        status = its_flash_fs_file_read(get_fs_ctx(client_id), g_fid,
+                                        is_last ? chunk_size :
+                                        chunk_size + sizeof(g_file_info.tag),
+                                        (size_t)chunk * ITS_ENC_CHUNK_STRIDE,
+                                        enc_asset_data);
+        if (status != PSA_SUCCESS) {
+            *p_data_length = 0;
+            return status;
+        }
+
+        /* Decrypt in place */
+        status = tfm_its_crypt_chunk(&g_file_info, g_fid, sizeof(g_fid),
+                                     file_size, chunk, enc_asset_data,
+                                     chunk_size, enc_asset_data,
+                                     is_last ? g_file_info.tag :
+                                     enc_asset_data + chunk_size,
+                                     false);
+        if (status != PSA_SUCCESS) {
+            *p_data_length = 0;
+            return status;
+        }
+
+        /* Write the part of the chunk which the caller requested */
+        copy_start = ITS_UTILS_MAX(pos, data_offset);
+        copy_end = ITS_UTILS_MIN(pos + chunk_size, data_offset + data_size);
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC == 1)
+        memcpy(its_req_mngr_get_vec_base() + (copy_start - data_offset),
+               enc_asset_data + (copy_start - pos), copy_end - copy_start);
+#else
+        its_req_mngr_write(enc_asset_data + (copy_start - pos),
+                           copy_end - copy_start);
+#endif
+
+        pos += chunk_size;
+        chunk++;
+    }
+
+    return PSA_SUCCESS;
+}
+#else /* ITS_ENCRYPTION_STREAMING */
 /* Buffer to store the encrypted asset data before it is stored in the
  * filesystem.
  */
@@ -182,6 +375,7 @@ static psa_status_t tfm_its_get_encrypted(int32_t client_id,
 
     return PSA_SUCCESS;
 }
+#endif /* ITS_ENCRYPTION_STREAMING */
 #endif /* ITS_ENCRYPTION */
 
 /**
@@ -368,6 +562,8 @@ psa_status_t tfm_its_init(void)
 
 static psa_status_t get_file_info(psa_storage_uid_t uid, int32_t client_id)
 {
+    psa_status_t status;
+
     /* Check that the UID is valid */
     if (uid == TFM_ITS_INVALID_UID) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -377,10 +573,122 @@ static psa_status_t get_file_info(psa_storage_uid_t uid, int32_t client_id)
     tfm_its_get_fid(client_id, uid, g_fid);
 
     /* Read file info */
-    return its_flash_fs_file_get_info(get_fs_ctx(client_id), g_fid,
-                                      &g_file_info);
+    status = its_flash_fs_file_get_info(get_fs_ctx(client_id), g_fid,
+                                        &g_file_info);
+
+#if ITS_ENCRYPTION_STREAMING
+    /* Report the size of the data, without the tags of the chunks */
+    if ((status == PSA_SUCCESS) && tfm_its_is_encrypted(client_id)) {
+        g_file_info.size_current =
+            tfm_its_enc_data_size(g_file_info.size_current);
+        g_file_info.size_max = tfm_its_enc_data_size(g_file_info.size_max);
+    }
+#endif /* ITS_ENCRYPTION_STREAMING */
+
+    return status;
+}
+
+
+/**
+ * \brief Writes data to a file in the filesystem of the client, or stages the
+ *        write if the client has a transaction in progress.
+ *
+ * \param[in]     client_id  Identifier of the asset's owner (client)
+ * \param[in]     fid        Identifier of the file
+ * \param[in,out] finfo      Pointer to \ref its_flash_fs_file_info_t
+ * \param[in]     data_size  Size of the data
+ * \param[in]     offset     Offset of the data in the file
+ * \param[in]     data       Pointer to the data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t tfm_its_write_file(const int32_t client_id,
+                                       const uint8_t *fid,
+                                       struct its_flash_fs_file_info_t *finfo,
+                                       const size_t data_size,
+                                       const size_t offset,
+                                       const uint8_t *data)
+{
+#if ITS_TRANSACTION
+    if (its_txn_owned(client_id)) {
+        /* Stage the write in the client's transaction */
+        return its_flash_fs_txn_file_write(get_fs_ctx(client_id), fid, finfo,
+                                           data_size, offset, data);
+    }
+#endif /* ITS_TRANSACTION */
+
+    return its_flash_fs_file_write(get_fs_ctx(client_id), fid, finfo,
+                                   data_size, offset, data);
 }
 
+#if ITS_ENCRYPTION_STREAMING
+/**
+ * \brief Reads the data from the caller in chunks, encrypts each chunk and
+ *        writes it to the file with its authentication tag. The tag of the
+ *        last chunk is stored in the file metadata by the last write.
+ *
+ * \param[in] client_id    Identifier of the asset's owner (client)
+ * \param[in] data_length  Size of the data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t tfm_its_set_encrypted(int32_t client_id,
+                                          size_t data_length)
+{
+    psa_status_t status;
+    const uint8_t *chunk_data;
+    size_t chunk_size;
+    size_t pos = 0;
+    uint32_t chunk = 0;
+    bool is_last;
+
+    if (data_length > ITS_MAX_ASSET_SIZE) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    g_file_info.size_max = ITS_ENC_FILE_SIZE(data_length);
+
+    do {
+        chunk_size = ITS_UTILS_MIN(data_length - pos, ITS_ENC_CHUNK_SIZE);
+        is_last = (pos + chunk_size == data_length);
+
+#if (PSA_FRAMEWORK_HAS_MM_IOVEC == 1)
+        chunk_data = its_req_mngr_get_vec_base() + pos;
+#else
+        (void)its_req_mngr_read(asset_data, chunk_size);
+        chunk_data = asset_data;
+#endif
+
+        status = tfm_its_crypt_chunk(&g_file_info, g_fid, sizeof(g_fid),
+                                     data_length, chunk, chunk_data,
+                                     chunk_size, enc_asset_data,
+                                     is_last ? g_file_info.tag :
+                                     enc_asset_data + chunk_size,
+                                     true);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        status = tfm_its_write_file(client_id, g_fid, &g_file_info,
+                                    is_last ? chunk_size :
+                                    chunk_size + sizeof(g_file_info.tag),
+                                    (size_t)chunk * ITS_ENC_CHUNK_STRIDE,
+                                    enc_asset_data);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        /* Do not create or truncate after the first chunk */
+        g_file_info.flags &= ~(ITS_FLASH_FS_FLAG_CREATE |
+                               ITS_FLASH_FS_FLAG_TRUNCATE);
+
+        pos += chunk_size;
+        chunk++;
+    } while (pos < data_length);
+
+    return PSA_SUCCESS;
+}
+#endif /* ITS_ENCRYPTION_STREAMING */
 
 static psa_status_t tfm_its_write_data_to_fs(const int32_t client_id,
                                      const uint8_t *fid,
@@ -391,7 +699,7 @@ static psa_status_t tfm_its_write_data_to_fs(const int32_t client_id,
 {
     psa_status_t status;
     uint8_t *buffer_ptr = data;
-#ifdef ITS_ENCRYPTION /* ITS_ENCRYPTION */
+#if defined(ITS_ENCRYPTION) && !ITS_ENCRYPTION_STREAMING
     /* If the data will be encrypted the whole file needs to be written */
     if (offset != 0) {
         return PSA_ERROR_INVALID_ARGUMENT;
@@ -400,11 +708,9 @@ static psa_status_t tfm_its_write_data_to_fs(const int32_t client_id,
     if (status != PSA_SUCCESS) {
         return status;
     }
-#endif /* ITS_ENCRYPTION */
-    status = its_flash_fs_file_write(get_fs_ctx(client_id),
-                                        fid,
-                                        &g_file_info,
-                                        data_size, offset, buffer_ptr);
+#endif /* ITS_ENCRYPTION && !ITS_ENCRYPTION_STREAMING */
+    status = tfm_its_write_file(client_id, fid, finfo, data_size, offset,
+                                buffer_ptr);
     if (status != PSA_SUCCESS) {
         return status;
     }
@@ -435,7 +741,8 @@ psa_status_t tfm_its_set(int32_t client_id,
         return PSA_ERROR_NOT_SUPPORTED;
     }
 
-#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE && \
+    !ITS_ENCRYPTION_STREAMING
     status = buffer_size_check(client_id, data_length);
     if (status != PSA_SUCCESS) {
         return status;
@@ -462,6 +769,15 @@ psa_status_t tfm_its_set(int32_t client_id,
     g_file_info.flags = (uint32_t)create_flags |
                         ITS_FLASH_FS_FLAG_CREATE | ITS_FLASH_FS_FLAG_TRUNCATE;
 
+#if ITS_TRANSACTION
+    its_txn_preempt(client_id);
+#endif /* ITS_TRANSACTION */
+
+#if ITS_ENCRYPTION_STREAMING
+    if (tfm_its_is_encrypted(client_id)) {
+        return tfm_its_set_encrypted(client_id, data_length);
+    }
+#endif /* ITS_ENCRYPTION_STREAMING */
 
 #ifndef TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
     /* Write to the file in the file system
@@ -585,7 +901,8 @@ psa_status_t tfm_its_get(int32_t client_id,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE
+#if defined ITS_ENCRYPTION && defined TFM_PARTITION_INTERNAL_TRUSTED_STORAGE && \
+    !ITS_ENCRYPTION_STREAMING
     status = buffer_size_check(client_id, data_offset + data_size);
     if (status != PSA_SUCCESS) {
         return status;
@@ -672,6 +989,74 @@ psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid)
         return PSA_ERROR_NOT_PERMITTED;
     }
 
+#if ITS_TRANSACTION
+    if (its_txn_owned(client_id)) {
+        /* Stage the deletion in the client's transaction */
+        return its_flash_fs_txn_file_delete(get_fs_ctx(client_id), g_fid);
+    }
+#endif /* ITS_TRANSACTION */
+
+#if ITS_TRANSACTION
+    its_txn_preempt(client_id);
+#endif /* ITS_TRANSACTION */
+
     /* Delete old file from the persistent area */
     return its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
 }
+
+#if ITS_TRANSACTION
+psa_status_t tfm_its_txn_begin(int32_t client_id)
+{
+    psa_status_t status;
+
+    /* Only one transaction can be in progress at a time */
+    if (its_txn_open) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    status = its_flash_fs_txn_begin(get_fs_ctx(client_id));
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    its_txn_open = true;
+    its_txn_client_id = client_id;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_txn_commit(int32_t client_id)
+{
+    if (!its_txn_owned(client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    its_txn_open = false;
+
+    /* If the transaction has been aborted by a failed write or by a write of
+     * another client, the filesystem reports that no transaction is in
+     * progress.
+     */
+    return its_flash_fs_txn_commit(get_fs_ctx(client_id));
+}
+
+psa_status_t tfm_its_txn_abort(int32_t client_id)
+{
+    its_flash_fs_ctx_t *fs_ctx = get_fs_ctx(client_id);
+
+    if (!its_txn_owned(client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    its_txn_open = false;
+
+    /* The transaction may already have been aborted by a failed write or by
+     * a write of another client.
+     */
+    if (!its_flash_fs_txn_is_active(fs_ctx)) {
+        return PSA_SUCCESS;
+    }
+
+    return its_flash_fs_txn_abort(fs_ctx);
+}
+#endif /* ITS_TRANSACTION */
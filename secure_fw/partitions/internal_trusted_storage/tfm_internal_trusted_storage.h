@@ -163,6 +163,62 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
  */
 psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid);
 
+#if ITS_TRANSACTION
+/**
+ * \brief Start a transaction for the client
+ *
+ * Until the transaction is committed, the set and remove operations of the
+ * client are staged, and all of them are applied atomically by the commit. The
+ * get operations return the data stored before the transaction. An asset can
+ * be set at most once in a transaction, and an asset set in the transaction
+ * cannot be removed in the same transaction.
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The operation failed because a
+ *                                    transaction is already in progress
+ * \retval PSA_ERROR_NOT_SUPPORTED    The operation failed because the storage
+ *                                    of the client does not support
+ *                                    transactions
+ */
+psa_status_t tfm_its_txn_begin(int32_t client_id);
+
+/**
+ * \brief Commit the transaction of the client
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The operation failed because the client
+ *                                    has no transaction in progress, or its
+ *                                    transaction has been aborted by a failed
+ *                                    write or by a write of another client
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_txn_commit(int32_t client_id);
+
+/**
+ * \brief Abort the transaction of the client and discard its staged changes
+ *
+ * \param[in] client_id  Identifier of the client
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The operation failed because the client
+ *                                    has no transaction in progress
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_txn_abort(int32_t client_id);
+#endif /* ITS_TRANSACTION */
+
 #ifdef __cplusplus
 }
 #endif
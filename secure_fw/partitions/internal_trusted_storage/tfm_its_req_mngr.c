@@ -163,6 +163,14 @@ psa_status_t tfm_internal_trusted_storage_service_sfn(const psa_msg_t *msg)
         return tfm_its_get_info_req(msg);
     case TFM_ITS_REMOVE:
         return tfm_its_remove_req(msg);
+#if ITS_TRANSACTION
+    case TFM_ITS_TXN_BEGIN:
+        return tfm_its_txn_begin(msg->client_id);
+    case TFM_ITS_TXN_COMMIT:
+        return tfm_its_txn_commit(msg->client_id);
+    case TFM_ITS_TXN_ABORT:
+        return tfm_its_txn_abort(msg->client_id);
+#endif
     default:
         return PSA_ERROR_NOT_SUPPORTED;
     }
@@ -24,6 +24,18 @@
 #error "Invalid config: NOT PS_ROLLBACK_PROTECTION and PS_ENCRYPTION and PSA_ALG_GCM or PSA_ALG_CCM!"
 #endif
 
+#if PS_OBJ_TABLE_HASH_TREE && (!defined(PS_ENCRYPTION))
+#error "Invalid config: PS_OBJ_TABLE_HASH_TREE and NOT PS_ENCRYPTION!"
+#endif
+
+#if PS_CHUNKED_OBJECTS && (!defined(PS_ENCRYPTION))
+#error "Invalid config: PS_CHUNKED_OBJECTS and NOT PS_ENCRYPTION!"
+#endif
+
+#if PS_CHUNKED_OBJECTS && (PS_OBJECT_CHUNK_SIZE == 0)
+#error "Invalid config: PS_CHUNKED_OBJECTS and PS_OBJECT_CHUNK_SIZE is 0!"
+#endif
+
 /*
  * ITS_VALIDATE_METADATA_FROM_FLASH shall be enabled when PS_VALIDATE_METADATA_FROM_FLASH is
  * enabled
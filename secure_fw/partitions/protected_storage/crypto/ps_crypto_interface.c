@@ -27,6 +27,9 @@
 #define PS_CRYPTO_ALG \
     PSA_ALG_AEAD_WITH_SHORTENED_TAG(PS_CRYPTO_AEAD_ALG, PS_TAG_LEN_BYTES)
 
+/* The PSA hash algorithm used by this implementation */
+#define PS_HASH_ALG PSA_ALG_SHA_256
+
 /*
  * \brief Check whether the PS AEAD algorithm is a valid one
  *
@@ -279,3 +282,17 @@ psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
 
     return PSA_SUCCESS;
 }
+
+psa_status_t ps_crypto_hash(const uint8_t *in, size_t in_len, uint8_t *hash)
+{
+    psa_status_t status;
+    size_t hash_len;
+
+    status = psa_hash_compute(PS_HASH_ALG, in, in_len,
+                              hash, PS_HASH_LEN_BYTES, &hash_len);
+    if (status != PSA_SUCCESS || hash_len != PS_HASH_LEN_BYTES) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
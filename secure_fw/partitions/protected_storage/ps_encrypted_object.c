@@ -7,6 +7,7 @@
 
 #include "ps_encrypted_object.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -15,12 +16,45 @@
 #include "ps_object_defs.h"
 #include "ps_utils.h"
 
+#define PS_OBJECT_START_POSITION  0
+
+#if PS_CHUNKED_OBJECTS
+/* The object is stored as a single image, made of the header IV, the crypto
+ * metadata of the chunks, the object information and the object data. The
+ * object information and each chunk of the object data are encrypted and
+ * authenticated separately, so that they can be accessed independently.
+ */
+#define PS_OBJECT_IMAGE(obj)  ((uint8_t *)(obj)->header.crypto.ref.iv)
+
+/* Offset of the object image in the object structure */
+#define PS_OBJECT_IMAGE_OFFSET  offsetof(struct ps_object_t, \
+                                         header.crypto.ref.iv)
+
+/* Size of the object image before the object data */
+#define PS_OBJECT_IMAGE_HDR_SIZE  (offsetof(struct ps_object_t, data) - \
+                                   PS_OBJECT_IMAGE_OFFSET)
+
+/* Size of the object information encrypted with the header IV */
+#define PS_OBJECT_INFO_SIZE  (offsetof(struct ps_object_t, data) - \
+                              offsetof(struct ps_object_t, header.info))
+
+/* Gets the number of chunks used to store the given size of object data */
+#define PS_OBJECT_NUM_CHUNKS(size) (((size) + PS_OBJECT_CHUNK_SIZE - 1) / \
+                                    PS_OBJECT_CHUNK_SIZE)
+
+/* The crypto layer uses the PS_TAG_LEN_BYTES following the region being
+ * processed to hold the tag, which are saved and restored for each region. The
+ * last chunk of the object data is followed by the tag_iv buffer.
+ */
+PS_UTILS_BOUND_CHECK(OBJ_TAG_NOT_FIT_AFTER_OBJ_DATA,
+                     PS_TAG_LEN_BYTES, PS_TAG_IV_LEN_MAX);
+PS_UTILS_BOUND_CHECK(OBJ_TAG_NOT_FIT_AFTER_OBJ_INFO,
+                     PS_TAG_LEN_BYTES, PS_MAX_OBJECT_DATA_SIZE);
+#else
 /* Gets the size of data to encrypt */
 #define PS_ENCRYPT_SIZE(plaintext_size) \
     ((plaintext_size) + PS_OBJECT_HEADER_SIZE - sizeof(union ps_crypto_t))
 
-#define PS_OBJECT_START_POSITION  0
-
 /* Buffer to store the maximum encrypted object */
 /* FIXME: Do partial encrypt/decrypt to reduce the size of internal buffer */
 #define PS_MAX_ENCRYPTED_OBJ_SIZE PS_ENCRYPT_SIZE(PS_MAX_OBJECT_DATA_SIZE)
@@ -31,6 +65,7 @@
 #define PS_TAG_IV_LEN_MAX   ((PS_TAG_LEN_BYTES > PS_IV_LEN_BYTES) ? \
                              PS_TAG_LEN_BYTES : PS_IV_LEN_BYTES)
 #define PS_CRYPTO_BUF_LEN (PS_MAX_ENCRYPTED_OBJ_SIZE + PS_TAG_IV_LEN_MAX)
+#endif /* PS_CHUNKED_OBJECTS */
 
 static psa_status_t fill_key_label(struct ps_object_t *obj, uint8_t *label)
 {
@@ -43,6 +78,411 @@ static psa_status_t fill_key_label(struct ps_object_t *obj, uint8_t *label)
     return PSA_SUCCESS;
 }
 
+#if PS_CHUNKED_OBJECTS
+/**
+ * \brief Sets the key used to encrypt the given object.
+ *
+ * \param[in] obj  Pointer to the object structure
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_setkey(struct ps_object_t *obj)
+{
+    psa_status_t err;
+    uint8_t label[sizeof(int32_t) + sizeof(psa_storage_uid_t)];
+
+    err = fill_key_label(obj, label);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_crypto_setkey(label, sizeof(label));
+}
+
+/**
+ * \brief Encrypts and tags, or authenticates and decrypts, a region of the
+ *        object in place.
+ *
+ * \param[in]     is_encrypt  true to encrypt the region, false to decrypt it
+ * \param[in,out] crypto      Pointer to the crypto union with the IV and the
+ *                            tag of the region
+ * \param[in]     add         Pointer to the associated data
+ * \param[in]     add_len     Length of the associated data
+ * \param[in,out] data        Pointer to the region, which must be followed by
+ *                            at least PS_TAG_LEN_BYTES of the object structure
+ * \param[in]     len         Length of the region
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_crypt_region(bool is_encrypt,
+                                           union ps_crypto_t *crypto,
+                                           const uint8_t *add,
+                                           size_t add_len,
+                                           uint8_t *data,
+                                           size_t len)
+{
+    psa_status_t err;
+    size_t out_len = 0;
+    uint8_t saved[PS_TAG_LEN_BYTES];
+
+    /* The crypto layer appends the tag to the region, so keep the data which
+     * follows it.
+     */
+    (void)memcpy(saved, data + len, PS_TAG_LEN_BYTES);
+
+    if (is_encrypt) {
+        err = ps_crypto_encrypt_and_tag(crypto, add, add_len, data, len,
+                                        data, len + PS_TAG_LEN_BYTES,
+                                        &out_len);
+    } else {
+        err = ps_crypto_auth_and_decrypt(crypto, add, add_len, data, len,
+                                         data, len, &out_len);
+    }
+
+    (void)memcpy(data + len, saved, PS_TAG_LEN_BYTES);
+
+    if (err != PSA_SUCCESS || out_len != len) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Encrypts and tags, or authenticates and decrypts, a chunk of the
+ *        object data in place. The key of the object must be set.
+ *
+ * \param[in]     is_encrypt  true to encrypt the chunk, false to decrypt it
+ * \param[in]     idx         Index of the chunk
+ * \param[in,out] obj         Pointer to the object structure
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_crypt_chunk(bool is_encrypt, uint32_t idx,
+                                          struct ps_object_t *obj)
+{
+    psa_status_t err;
+    union ps_crypto_t chunk_crypto;
+    uint32_t chunk_offset = idx * PS_OBJECT_CHUNK_SIZE;
+    uint32_t chunk_len = PS_UTILS_MIN(PS_OBJECT_CHUNK_SIZE,
+                                      obj->header.info.current_size -
+                                      chunk_offset);
+
+    if (is_encrypt) {
+        /* Get a new IV for each encryption */
+        err = ps_crypto_get_iv(&chunk_crypto);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    } else {
+        (void)memcpy(chunk_crypto.ref.iv, obj->header.chunks.iv[idx],
+                     PS_IV_LEN_BYTES);
+        (void)memcpy(chunk_crypto.ref.tag, obj->header.chunks.tag[idx],
+                     PS_TAG_LEN_BYTES);
+    }
+
+    /* Use the chunk index as the associated data, so that chunks cannot be
+     * moved within the object. The chunk's IV and tag are authenticated as a
+     * part of the object header.
+     */
+    err = ps_object_crypt_region(is_encrypt, &chunk_crypto,
+                                 (const uint8_t *)&idx, sizeof(idx),
+                                 obj->data + chunk_offset, chunk_len);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (is_encrypt) {
+        (void)memcpy(obj->header.chunks.iv[idx], chunk_crypto.ref.iv,
+                     PS_IV_LEN_BYTES);
+        (void)memcpy(obj->header.chunks.tag[idx], chunk_crypto.ref.tag,
+                     PS_TAG_LEN_BYTES);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Authenticates and decrypts the chunks of the object data which overlap
+ *        the given range. The key of the object must be set.
+ *
+ * \param[in]     offset  Offset of the range in the object data
+ * \param[in]     size    Size of the range
+ * \param[in]     only_partial  true to skip the chunks which are fully covered
+ *                              by the range
+ * \param[in,out] obj     Pointer to the object structure
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_decrypt_chunks(uint32_t offset, uint32_t size,
+                                             bool only_partial,
+                                             struct ps_object_t *obj)
+{
+    psa_status_t err;
+    uint32_t idx;
+    uint32_t chunk_start;
+    uint32_t chunk_end;
+    uint32_t current_size = obj->header.info.current_size;
+
+    for (idx = offset / PS_OBJECT_CHUNK_SIZE;
+         idx < PS_OBJECT_NUM_CHUNKS(PS_UTILS_MIN(offset + size, current_size));
+         idx++) {
+        chunk_start = idx * PS_OBJECT_CHUNK_SIZE;
+        chunk_end = PS_UTILS_MIN(chunk_start + PS_OBJECT_CHUNK_SIZE,
+                                 current_size);
+
+        if (only_partial && chunk_start >= offset &&
+            chunk_end <= offset + size) {
+            /* The whole chunk is going to be overwritten */
+            continue;
+        }
+
+        err = ps_object_crypt_chunk(false, idx, obj);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Encrypts the chunks of the object data which overlap the given range
+ *        and the object header, and writes the object image.
+ *
+ * \param[in]     fid     File ID
+ * \param[in]     offset  Offset of the range in the object data
+ * \param[in]     size    Size of the range
+ * \param[in,out] obj     Pointer to the object structure. The chunks outside
+ *                        the range must contain their encrypted data.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_encrypt_and_write(uint32_t fid,
+                                                uint32_t offset,
+                                                uint32_t size,
+                                                struct ps_object_t *obj)
+{
+    psa_status_t err;
+    uint32_t idx;
+    /* The object information is encrypted in place, so keep the data size */
+    uint32_t current_size = obj->header.info.current_size;
+    uint32_t num_chunks = PS_OBJECT_NUM_CHUNKS(current_size);
+
+    err = ps_object_setkey(obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    for (idx = offset / PS_OBJECT_CHUNK_SIZE;
+         idx < PS_OBJECT_NUM_CHUNKS(offset + size); idx++) {
+        err = ps_object_crypt_chunk(true, idx, obj);
+        if (err != PSA_SUCCESS) {
+            goto destroy_key_and_return;
+        }
+    }
+
+    /* Clear the metadata of the chunks which are not used */
+    for (idx = num_chunks; idx < PS_MAX_OBJECT_CHUNKS; idx++) {
+        (void)memset(obj->header.chunks.iv[idx], 0, PS_IV_LEN_BYTES);
+        (void)memset(obj->header.chunks.tag[idx], 0, PS_TAG_LEN_BYTES);
+    }
+
+    /* Get a new IV for each encryption */
+    err = ps_crypto_get_iv(&obj->header.crypto);
+    if (err != PSA_SUCCESS) {
+        goto destroy_key_and_return;
+    }
+
+    /* Use File ID and the chunks' metadata as the associated data of the
+     * object information. The resulting tag will be stored in the object
+     * table, and it authenticates the whole object.
+     */
+    obj->header.chunks.fid = fid;
+
+    err = ps_object_crypt_region(true, &obj->header.crypto,
+                                 (const uint8_t *)&obj->header.chunks,
+                                 sizeof(obj->header.chunks),
+                                 (uint8_t *)&obj->header.info,
+                                 PS_OBJECT_INFO_SIZE);
+    if (err != PSA_SUCCESS) {
+        goto destroy_key_and_return;
+    }
+
+    err = ps_crypto_destroykey();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* The tag value is not written as it is stored in the object table */
+    return psa_its_set(fid, PS_OBJECT_IMAGE_HDR_SIZE + current_size,
+                       (const void *)PS_OBJECT_IMAGE(obj),
+                       PSA_STORAGE_FLAG_NONE);
+
+destroy_key_and_return:
+    (void)ps_crypto_destroykey();
+    return err;
+}
+
+psa_status_t ps_encrypted_object_read_header(uint32_t fid,
+                                             struct ps_object_t *obj)
+{
+    psa_status_t err;
+    size_t data_length;
+
+    err = psa_its_get(fid, PS_OBJECT_START_POSITION, PS_OBJECT_IMAGE_HDR_SIZE,
+                      (void *)PS_OBJECT_IMAGE(obj), &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != PS_OBJECT_IMAGE_HDR_SIZE) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    err = ps_object_setkey(obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Authenticate the header against the File ID the object is read from */
+    obj->header.chunks.fid = fid;
+
+    err = ps_object_crypt_region(false, &obj->header.crypto,
+                                 (const uint8_t *)&obj->header.chunks,
+                                 sizeof(obj->header.chunks),
+                                 (uint8_t *)&obj->header.info,
+                                 PS_OBJECT_INFO_SIZE);
+    if (err != PSA_SUCCESS) {
+        (void)ps_crypto_destroykey();
+        return err;
+    }
+
+    err = ps_crypto_destroykey();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (obj->header.info.current_size > PS_MAX_OBJECT_DATA_SIZE) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_encrypted_object_read_data(uint32_t fid,
+                                           uint32_t offset,
+                                           uint32_t size,
+                                           struct ps_object_t *obj)
+{
+    psa_status_t err;
+    uint32_t start;
+    uint32_t end;
+    size_t data_length;
+
+    if (size == 0) {
+        return PSA_SUCCESS;
+    }
+
+    /* Read the chunks which overlap the requested data */
+    start = (offset / PS_OBJECT_CHUNK_SIZE) * PS_OBJECT_CHUNK_SIZE;
+    end = PS_UTILS_MIN(PS_OBJECT_NUM_CHUNKS(offset + size) *
+                       PS_OBJECT_CHUNK_SIZE, obj->header.info.current_size);
+
+    err = psa_its_get(fid, PS_OBJECT_IMAGE_HDR_SIZE + start, end - start,
+                      (void *)(obj->data + start), &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != end - start) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    err = ps_object_setkey(obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_object_decrypt_chunks(offset, size, false, obj);
+    if (err != PSA_SUCCESS) {
+        (void)ps_crypto_destroykey();
+        return err;
+    }
+
+    return ps_crypto_destroykey();
+}
+
+psa_status_t ps_encrypted_object_read_for_update(uint32_t fid,
+                                                 uint32_t offset,
+                                                 uint32_t size,
+                                                 struct ps_object_t *obj)
+{
+    psa_status_t err;
+    size_t data_length;
+
+    if (obj->header.info.current_size == 0) {
+        return PSA_SUCCESS;
+    }
+
+    /* The chunks which are not updated are copied to the new object image
+     * as they are stored.
+     */
+    err = psa_its_get(fid, PS_OBJECT_IMAGE_HDR_SIZE,
+                      obj->header.info.current_size,
+                      (void *)obj->data, &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != obj->header.info.current_size) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    err = ps_object_setkey(obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Only the chunks partially covered by the update need their current
+     * content.
+     */
+    err = ps_object_decrypt_chunks(offset, size, true, obj);
+    if (err != PSA_SUCCESS) {
+        (void)ps_crypto_destroykey();
+        return err;
+    }
+
+    return ps_crypto_destroykey();
+}
+
+psa_status_t ps_encrypted_object_write_update(uint32_t fid,
+                                              uint32_t offset,
+                                              uint32_t size,
+                                              struct ps_object_t *obj)
+{
+    return ps_object_encrypt_and_write(fid, offset, size, obj);
+}
+
+psa_status_t ps_encrypted_object_read(uint32_t fid, struct ps_object_t *obj)
+{
+    psa_status_t err;
+
+    err = ps_encrypted_object_read_header(fid, obj);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_encrypted_object_read_data(fid, 0,
+                                         obj->header.info.current_size, obj);
+}
+
+psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj)
+{
+    return ps_object_encrypt_and_write(fid, 0, obj->header.info.current_size,
+                                       obj);
+}
+#else /* PS_CHUNKED_OBJECTS */
 /**
  * \brief Performs authenticated decryption on object data, with the header as
  *        the associated data.
@@ -215,3 +655,50 @@ psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj)
     return psa_its_set(fid, wrt_size, (const void *)obj->header.crypto.ref.iv,
                        PSA_STORAGE_FLAG_NONE);
 }
+
+psa_status_t ps_encrypted_object_read_header(uint32_t fid,
+                                             struct ps_object_t *obj)
+{
+    /* The object is encrypted as a whole, so it is read as a whole */
+    return ps_encrypted_object_read(fid, obj);
+}
+
+psa_status_t ps_encrypted_object_read_data(uint32_t fid,
+                                           uint32_t offset,
+                                           uint32_t size,
+                                           struct ps_object_t *obj)
+{
+    (void)fid;
+    (void)offset;
+    (void)size;
+    (void)obj;
+
+    /* The object data has been read with the object header */
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_encrypted_object_read_for_update(uint32_t fid,
+                                                 uint32_t offset,
+                                                 uint32_t size,
+                                                 struct ps_object_t *obj)
+{
+    (void)fid;
+    (void)offset;
+    (void)size;
+    (void)obj;
+
+    /* The object data has been read with the object header */
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_encrypted_object_write_update(uint32_t fid,
+                                              uint32_t offset,
+                                              uint32_t size,
+                                              struct ps_object_t *obj)
+{
+    (void)offset;
+    (void)size;
+
+    return ps_encrypted_object_write(fid, obj);
+}
+#endif /* PS_CHUNKED_OBJECTS */
@@ -44,6 +44,83 @@ psa_status_t ps_encrypted_object_read(uint32_t fid,
 psa_status_t ps_encrypted_object_write(uint32_t fid,
                                        struct ps_object_t *obj);
 
+/**
+ * \brief Reads and authenticates the header of the object referenced by the
+ *        object File ID.
+ *
+ * \param[in]  fid      File ID
+ * \param[out] obj      Pointer to the object structure to fill in
+ *
+ * \note When PS_CHUNKED_OBJECTS is disabled, the object is encrypted as a
+ *       whole, so the object data is read as well.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read_header(uint32_t fid,
+                                             struct ps_object_t *obj);
+
+/**
+ * \brief Reads and authenticates part of the data of the object referenced by
+ *        the object File ID. Only the chunks of the object which contain the
+ *        requested data are read and decrypted.
+ *
+ * \param[in]     fid     File ID
+ * \param[in]     offset  Offset of the data to read in the object data
+ * \param[in]     size    Size of the data to read, which must be contained in
+ *                        the current object data
+ * \param[in,out] obj     Pointer to the object structure, with the header read
+ *                        by \ref ps_encrypted_object_read_header. The data is
+ *                        placed at the given offset of the object data.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read_data(uint32_t fid,
+                                           uint32_t offset,
+                                           uint32_t size,
+                                           struct ps_object_t *obj);
+
+/**
+ * \brief Reads the data of the object referenced by the object File ID, to
+ *        be updated in the given range and written with
+ *        \ref ps_encrypted_object_write_update.
+ *
+ * \param[in]     fid     File ID
+ * \param[in]     offset  Offset of the data to update in the object data
+ * \param[in]     size    Size of the data to update
+ * \param[in,out] obj     Pointer to the object structure, with the header read
+ *                        by \ref ps_encrypted_object_read_header.
+ *
+ * Note: Only the chunks partially covered by the range are decrypted. The
+ *       other chunks are kept encrypted, as they are stored.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read_for_update(uint32_t fid,
+                                                 uint32_t offset,
+                                                 uint32_t size,
+                                                 struct ps_object_t *obj);
+
+/**
+ * \brief Writes a new encrypted object, after the data of the object read by
+ *        \ref ps_encrypted_object_read_for_update has been updated in the
+ *        given range.
+ *
+ * \param[in]     fid     File ID
+ * \param[in]     offset  Offset of the updated data in the object data
+ * \param[in]     size    Size of the updated data
+ * \param[in,out] obj     Pointer to the object structure to write
+ *
+ * Note: Only the chunks which overlap the range are encrypted again. As for
+ *       \ref ps_encrypted_object_write, the object will contain the encrypted
+ *       object stored in the flash.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_write_update(uint32_t fid,
+                                              uint32_t offset,
+                                              uint32_t size,
+                                              struct ps_object_t *obj);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,28 @@ struct ps_object_info_t {
     psa_storage_create_flags_t create_flags; /*!< Object creation flags */
 };
 
+#if defined(PS_ENCRYPTION) && PS_CHUNKED_OBJECTS
+/* Number of chunks needed to store the object data of the maximum size */
+#define PS_MAX_OBJECT_CHUNKS ((PS_MAX_ASSET_SIZE + PS_OBJECT_CHUNK_SIZE - 1) / \
+                              PS_OBJECT_CHUNK_SIZE)
+
+/*!
+ * \struct ps_obj_chunks_t
+ *
+ * \brief Crypto metadata of the chunks of an object, each one of them
+ *        encrypted and authenticated separately.
+ */
+struct ps_obj_chunks_t {
+    uint32_t fid;                                      /*!< File ID */
+    uint8_t iv[PS_MAX_OBJECT_CHUNKS][PS_IV_LEN_BYTES];   /*!< IV of each
+                                                          *   chunk
+                                                          */
+    uint8_t tag[PS_MAX_OBJECT_CHUNKS][PS_TAG_LEN_BYTES]; /*!< MAC value of
+                                                          *   each chunk
+                                                          */
+};
+#endif
+
 /*!
  * \struct ps_obj_header_t
  *
@@ -36,6 +58,9 @@ struct ps_object_info_t {
 struct ps_obj_header_t {
 #ifdef PS_ENCRYPTION
     union ps_crypto_t crypto;     /*!< Crypto metadata */
+#if PS_CHUNKED_OBJECTS
+    struct ps_obj_chunks_t chunks; /*!< Crypto metadata of the data chunks */
+#endif
 #else
     uint32_t version;              /*!< Object version */
     uint32_t fid;                  /*!< File ID */
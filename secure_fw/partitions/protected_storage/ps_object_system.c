@@ -191,7 +191,7 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     /* Read object header */
     err = ps_read_object(READ_ALL_OBJECT);
@@ -209,6 +209,15 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
     size = PS_UTILS_MIN(size,
                         g_ps_object.header.info.current_size - offset);
 
+#ifdef PS_ENCRYPTION
+    /* Read only the requested part of the object data */
+    err = ps_encrypted_object_read_data(g_obj_tbl_info.fid, offset, size,
+                                        &g_ps_object);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+#endif
+
     /* Copy the decrypted object data to the output buffer */
     ps_req_mngr_write_asset_data(g_ps_object.data + offset, size);
 
@@ -245,11 +254,12 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
     err = ps_object_table_get_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
     if (err == PSA_SUCCESS) {
 #ifdef PS_ENCRYPTION
-        /* Read the object */
+        /* Read the object header */
         g_ps_object.header.crypto.ref.uid = uid;
         g_ps_object.header.crypto.ref.client_id = client_id;
 
-        err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+        err = ps_encrypted_object_read_header(g_obj_tbl_info.fid,
+                                              &g_ps_object);
 #else
         /* Read the object header */
         err = ps_read_object(READ_HEADER_ONLY);
@@ -365,7 +375,7 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_ALL_OBJECT);
 #endif
@@ -394,6 +404,15 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
+#ifdef PS_ENCRYPTION
+    /* Read the object data which is kept by the update */
+    err = ps_encrypted_object_read_for_update(g_obj_tbl_info.fid, offset, size,
+                                              &g_ps_object);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+#endif
+
     /* Update the object data */
     err = ps_req_mngr_read_asset_data(g_ps_object.data + offset, size);
     if (err != PSA_SUCCESS) {
@@ -418,7 +437,8 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_write_update(g_obj_tbl_info.fid, offset, size,
+                                           &g_ps_object);
 #else
     wrt_size = PS_OBJECT_SIZE(g_ps_object.header.info.current_size);
 
@@ -470,7 +490,7 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_HEADER_ONLY);
 #endif
@@ -506,7 +526,7 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_HEADER_ONLY);
 #endif
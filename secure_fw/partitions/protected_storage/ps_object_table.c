@@ -7,6 +7,7 @@
 
 #include "ps_object_table.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -26,7 +27,12 @@
  *
  * \brief Current object system version.
  */
+#if PS_OBJ_TABLE_HASH_TREE
+/* The object table is authenticated through a hash tree of its entries */
+#define PS_OBJECT_SYSTEM_VERSION  0x02
+#else
 #define PS_OBJECT_SYSTEM_VERSION  0x01
+#endif
 
 /*!
  * \struct ps_obj_table_info_t
@@ -154,7 +160,27 @@ static struct ps_obj_table_ctx_t ps_obj_table_ctx;
 #define PS_CRYPTO_ASSOCIATED_DATA(crypto) ((uint8_t *)crypto + \
                                             PS_NON_AUTH_OBJ_TABLE_SIZE)
 
+#if PS_OBJ_TABLE_HASH_TREE
+/* Size of the table header to authenticate, which precedes the table's
+ * entries.
+ */
+#define PS_OBJ_TABLE_AUTH_HDR_SIZE (offsetof(struct ps_obj_table_t, obj_db) - \
+                                    PS_NON_AUTH_OBJ_TABLE_SIZE)
+
+/* The associated data is the header, minus the crypto data, followed by the
+ * root of the hash tree computed over the table's entries.
+ */
+struct ps_crypto_assoc_data_t {
+    uint8_t  obj_table_hdr[PS_OBJ_TABLE_AUTH_HDR_SIZE];
+    uint8_t  obj_db_root[PS_HASH_LEN_BYTES];
 #if PS_ROLLBACK_PROTECTION
+    uint32_t nv_counter;
+#endif
+};
+
+#define PS_CRYPTO_ASSOCIATED_DATA_LEN  sizeof(struct ps_crypto_assoc_data_t)
+
+#elif PS_ROLLBACK_PROTECTION
 #define PS_OBJ_TABLE_AUTH_DATA_SIZE (PS_OBJ_TABLE_SIZE - \
                                      PS_NON_AUTH_OBJ_TABLE_SIZE)
 
@@ -170,7 +196,7 @@ struct ps_crypto_assoc_data_t {
 /* The associated data is the header, minus the the tag data */
 #define PS_CRYPTO_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_SIZE - \
                                        PS_NON_AUTH_OBJ_TABLE_SIZE)
-#endif /* PS_ROLLBACK_PROTECTION */
+#endif /* PS_OBJ_TABLE_HASH_TREE */
 
 /* The ps_object_table_init function uses the static memory allocated for
  * the object data manipulation, in ps_object_table.c (g_ps_object), to load a
@@ -215,6 +241,162 @@ struct ps_obj_table_init_ctx_t {
 #endif /* PS_ROLLBACK_PROTECTION */
 };
 
+#if PS_OBJ_TABLE_HASH_TREE
+/* Number of object table entries hashed together in a leaf of the hash tree */
+#define PS_OBJ_TREE_LEAF_ENTRIES  8
+
+/* Number of leaves of the hash tree */
+#define PS_OBJ_TREE_NUM_LEAVES  ((PS_OBJ_TABLE_ENTRIES + \
+                                  PS_OBJ_TREE_LEAF_ENTRIES - 1) / \
+                                 PS_OBJ_TREE_LEAF_ENTRIES)
+
+/* Number of nodes of the hash tree. Node 1 is the root, the children of node n
+ * are nodes 2n and 2n + 1, and the leaves are the last PS_OBJ_TREE_NUM_LEAVES
+ * nodes. Node 0 is not used.
+ */
+#define PS_OBJ_TREE_NUM_NODES  (2 * PS_OBJ_TREE_NUM_LEAVES)
+
+/* Index of the root node of the hash tree */
+#define PS_OBJ_TREE_ROOT  1
+
+/*!
+ * \struct ps_obj_table_tree_t
+ *
+ * \brief Hash tree of the object table entries, used to authenticate the
+ *        object table without hashing the entries which have not changed.
+ */
+struct ps_obj_table_tree_t {
+    uint8_t node[PS_OBJ_TREE_NUM_NODES][PS_HASH_LEN_BYTES]; /*!< Digests of
+                                                             *   the nodes
+                                                             */
+    uint32_t dirty[(PS_OBJ_TREE_NUM_NODES + 31) / 32]; /*!< Bitmap of the
+                                                        *   nodes to hash
+                                                        *   again
+                                                        */
+};
+
+/* Hash tree of the object table in the context */
+static struct ps_obj_table_tree_t ps_obj_table_tree;
+
+/**
+ * \brief Marks all the nodes of the hash tree to be hashed again, so that the
+ *        next update rebuilds the whole tree.
+ */
+static void ps_obj_tree_invalidate(void)
+{
+    (void)memset(ps_obj_table_tree.dirty, 0xFF,
+                 sizeof(ps_obj_table_tree.dirty));
+}
+
+/**
+ * \brief Marks the leaf of the hash tree which covers a table entry to be
+ *        hashed again.
+ *
+ * \param[in] idx  Table entry index
+ */
+static void ps_obj_tree_mark_entry(uint32_t idx)
+{
+    uint32_t n = PS_OBJ_TREE_NUM_LEAVES + (idx / PS_OBJ_TREE_LEAF_ENTRIES);
+
+    ps_obj_table_tree.dirty[n / 32] |= (1U << (n % 32));
+}
+
+/**
+ * \brief Brings the hash tree up to date with the given object table, hashing
+ *        only the nodes that have been marked since the last update.
+ *
+ * \details Nodes are hashed from the last to the first one, so that the
+ *          children of a node are always hashed before the node itself. A
+ *          node is only unmarked once its digest has been computed, so the
+ *          update can be retried after an error.
+ *
+ * \param[in] obj_table  Pointer to the object table
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_obj_tree_update(const struct ps_obj_table_t *obj_table)
+{
+    psa_status_t err;
+    uint32_t n;
+    uint32_t first;
+    uint32_t num_entries;
+
+    for (n = PS_OBJ_TREE_NUM_NODES - 1; n >= PS_OBJ_TREE_ROOT; n--) {
+        if ((ps_obj_table_tree.dirty[n / 32] & (1U << (n % 32))) == 0) {
+            continue;
+        }
+
+        if (n >= PS_OBJ_TREE_NUM_LEAVES) {
+            /* Leaf: digest of the table entries it covers */
+            first = (n - PS_OBJ_TREE_NUM_LEAVES) * PS_OBJ_TREE_LEAF_ENTRIES;
+            num_entries = PS_UTILS_MIN(PS_OBJ_TREE_LEAF_ENTRIES,
+                                       PS_OBJ_TABLE_ENTRIES - first);
+
+            err = ps_crypto_hash((const uint8_t *)&obj_table->obj_db[first],
+                                 num_entries * PS_OBJECTS_TABLE_ENTRY_SIZE,
+                                 ps_obj_table_tree.node[n]);
+        } else {
+            /* Inner node: digest of its two children, which are adjacent */
+            err = ps_crypto_hash(ps_obj_table_tree.node[2 * n],
+                                 2 * PS_HASH_LEN_BYTES,
+                                 ps_obj_table_tree.node[n]);
+        }
+
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (n > PS_OBJ_TREE_ROOT) {
+            ps_obj_table_tree.dirty[(n / 2) / 32] |= (1U << ((n / 2) % 32));
+        }
+        ps_obj_table_tree.dirty[n / 32] &= ~(1U << (n % 32));
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the associated data to authenticate an object table.
+ *
+ * \param[in]  obj_table   Pointer to the object table
+ * \param[in]  rebuild     If true, the hash tree is built from scratch for
+ *                         the given table. Otherwise, the hash tree is
+ *                         expected to track the given table and only the
+ *                         entries changed since the last update are hashed.
+ * \param[out] assoc_data  Pointer to the associated data to fill in
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_get_assoc_data(
+                                      const struct ps_obj_table_t *obj_table,
+                                      bool rebuild,
+                                      struct ps_crypto_assoc_data_t *assoc_data)
+{
+    psa_status_t err;
+
+    if (rebuild) {
+        ps_obj_tree_invalidate();
+    }
+
+    err = ps_obj_tree_update(obj_table);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Clear the padding, as the whole structure is authenticated */
+    (void)memset(assoc_data, 0, sizeof(struct ps_crypto_assoc_data_t));
+
+    (void)memcpy(assoc_data->obj_table_hdr,
+                 PS_CRYPTO_ASSOCIATED_DATA(&obj_table->crypto),
+                 PS_OBJ_TABLE_AUTH_HDR_SIZE);
+    (void)memcpy(assoc_data->obj_db_root,
+                 ps_obj_table_tree.node[PS_OBJ_TREE_ROOT],
+                 PS_HASH_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_OBJ_TABLE_HASH_TREE */
+
 /**
  * \brief Reads object table from persistent memory.
  *
@@ -350,10 +532,17 @@ __STATIC_INLINE psa_status_t ps_object_table_nvc_generate_auth_tag(
         return err;
     }
 
-    assoc_data.nv_counter = nvc_1;
+#if PS_OBJ_TABLE_HASH_TREE
+    err = ps_object_table_get_assoc_data(obj_table, false, &assoc_data);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#else
     (void)memcpy(assoc_data.obj_table_data,
                  PS_CRYPTO_ASSOCIATED_DATA(crypto),
                  PS_OBJ_TABLE_AUTH_DATA_SIZE);
+#endif
+    assoc_data.nv_counter = nvc_1;
 
     return ps_crypto_generate_auth_tag(crypto, (const uint8_t *)&assoc_data,
                                        PS_CRYPTO_ASSOCIATED_DATA_LEN);
@@ -373,11 +562,21 @@ static void ps_object_table_authenticate(uint8_t table_idx,
     union ps_crypto_t *crypto = &init_ctx->p_table[table_idx]->crypto;
     psa_status_t err;
 
-    /* Init associated data with NVC 1 */
-    assoc_data.nv_counter = init_ctx->nvc_1;
+#if PS_OBJ_TABLE_HASH_TREE
+    err = ps_object_table_get_assoc_data(init_ctx->p_table[table_idx], true,
+                                         &assoc_data);
+    if (err != PSA_SUCCESS) {
+        init_ctx->table_state[table_idx] = PS_OBJ_TABLE_INVALID;
+        return;
+    }
+#else
     (void)memcpy(assoc_data.obj_table_data,
                  PS_CRYPTO_ASSOCIATED_DATA(crypto),
                  PS_OBJ_TABLE_AUTH_DATA_SIZE);
+#endif
+
+    /* Init associated data with NVC 1 */
+    assoc_data.nv_counter = init_ctx->nvc_1;
 
     err = ps_crypto_authenticate(crypto, (const uint8_t *)&assoc_data,
                                  PS_CRYPTO_ASSOCIATED_DATA_LEN);
@@ -471,6 +670,9 @@ __STATIC_INLINE psa_status_t ps_object_table_generate_auth_tag(
 {
     union ps_crypto_t *crypto = &obj_table->crypto;
     psa_status_t err;
+#if PS_OBJ_TABLE_HASH_TREE
+    struct ps_crypto_assoc_data_t assoc_data;
+#endif
 
     /* Get new IV */
     err = ps_crypto_get_iv(crypto);
@@ -478,9 +680,19 @@ __STATIC_INLINE psa_status_t ps_object_table_generate_auth_tag(
         return err;
     }
 
+#if PS_OBJ_TABLE_HASH_TREE
+    err = ps_object_table_get_assoc_data(obj_table, false, &assoc_data);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_crypto_generate_auth_tag(crypto, (const uint8_t *)&assoc_data,
+                                       PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#else
     return ps_crypto_generate_auth_tag(crypto,
                                        PS_CRYPTO_ASSOCIATED_DATA(crypto),
                                        PS_CRYPTO_ASSOCIATED_DATA_LEN);
+#endif
 }
 
 /**
@@ -494,6 +706,29 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
                                       struct ps_obj_table_init_ctx_t *init_ctx)
 {
     psa_status_t err;
+#if PS_OBJ_TABLE_HASH_TREE
+    struct ps_crypto_assoc_data_t assoc_data;
+    uint8_t idx;
+
+    for (idx = PS_OBJ_TABLE_IDX_0; idx < PS_NUM_OBJ_TABLES; idx++) {
+        /* Authenticate table if data is valid */
+        if (init_ctx->table_state[idx] == PS_OBJ_TABLE_INVALID) {
+            continue;
+        }
+
+        err = ps_object_table_get_assoc_data(init_ctx->p_table[idx], true,
+                                             &assoc_data);
+        if (err == PSA_SUCCESS) {
+            err = ps_crypto_authenticate(&init_ctx->p_table[idx]->crypto,
+                                         (const uint8_t *)&assoc_data,
+                                         PS_CRYPTO_ASSOCIATED_DATA_LEN);
+        }
+
+        if (err != PSA_SUCCESS) {
+            init_ctx->table_state[idx] = PS_OBJ_TABLE_INVALID;
+        }
+    }
+#else
     union ps_crypto_t *crypto =
                                 &init_ctx->p_table[PS_OBJ_TABLE_IDX_0]->crypto;
 
@@ -518,6 +753,7 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
             init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
         }
     }
+#endif /* PS_OBJ_TABLE_HASH_TREE */
 }
 #endif /* PS_ROLLBACK_PROTECTION */
 #endif /* PS_ENCRYPTION */
@@ -533,6 +769,9 @@ static psa_status_t ps_object_table_save_table(
                                               struct ps_obj_table_t *obj_table)
 {
     psa_status_t err;
+#if (!PS_ROLLBACK_PROTECTION)
+    uint8_t swap_count = obj_table->swap_count;
+#endif
 
 #if PS_ROLLBACK_PROTECTION
     uint32_t nvc_1 = 0;
@@ -564,7 +803,7 @@ static psa_status_t ps_object_table_save_table(
     /* Set object table key */
     err = ps_crypto_setkey(ps_table_key_label, sizeof(ps_table_key_label));
     if (err != PSA_SUCCESS) {
-        return err;
+        goto restore_swap_count;
     }
 
 #if PS_ROLLBACK_PROTECTION
@@ -579,12 +818,12 @@ static psa_status_t ps_object_table_save_table(
 
     if (err != PSA_SUCCESS) {
         (void)ps_crypto_destroykey();
-        return err;
+        goto restore_swap_count;
     }
 
     err = ps_crypto_destroykey();
     if (err != PSA_SUCCESS) {
-        return err;
+        goto restore_swap_count;
     }
 #endif /* PS_ENCRYPTION */
 
@@ -599,6 +838,18 @@ static psa_status_t ps_object_table_save_table(
     err = ps_object_table_align_nv_counters(nvc_1);
 #endif /* PS_ROLLBACK_PROTECTION */
 
+#ifdef PS_ENCRYPTION
+restore_swap_count:
+#endif
+#if (!PS_ROLLBACK_PROTECTION)
+    if (err != PSA_SUCCESS) {
+        /* The stored tables must have consecutive swap counts, for the
+         * rollover logic of ps_set_active_object_table() to find the latest.
+         */
+        obj_table->swap_count = swap_count;
+    }
+#endif
+
     return err;
 }
 
@@ -739,6 +990,193 @@ static psa_status_t ps_set_active_object_table(
     return PSA_SUCCESS;
 }
 
+#if PS_OBJ_TABLE_INDEX
+/* Marks an empty slot of the object table index */
+#define PS_OBJ_INDEX_EMPTY_SLOT  0xFFFFU
+
+/* Number of slots of the object table index. There are twice as many slots as
+ * table entries, so that probe sequences stay short and there is always an
+ * empty slot to be found.
+ */
+#define PS_OBJ_INDEX_NUM_SLOTS  (2 * PS_OBJ_TABLE_ENTRIES)
+
+/* Check at compilation time that table entry indexes fit in the slots */
+PS_UTILS_BOUND_CHECK(OBJ_TABLE_TOO_BIG_FOR_INDEX,
+                     PS_OBJ_TABLE_ENTRIES, PS_OBJ_INDEX_EMPTY_SLOT);
+
+/*!
+ * \struct ps_obj_table_index_t
+ *
+ * \brief Index of the object table entries, kept in RAM beside the object
+ *        table to look up an entry by UID and client ID in constant time.
+ */
+struct ps_obj_table_index_t {
+    uint32_t used[(PS_OBJ_TABLE_ENTRIES + 31) / 32]; /*!< Bitmap of the
+                                                      *   entries in use
+                                                      */
+    uint16_t key_hash[PS_OBJ_TABLE_ENTRIES];  /*!< Hash of the UID and client
+                                               *   ID of each entry in use
+                                               */
+    uint16_t slot[PS_OBJ_INDEX_NUM_SLOTS];    /*!< Open-addressed hash table
+                                               *   of entry indexes
+                                               */
+};
+
+/* Index of the object table in the context */
+static struct ps_obj_table_index_t ps_obj_table_index;
+
+/**
+ * \brief Calculates the hash of an object UID and client ID pair.
+ *
+ * \param[in] uid        Object UID
+ * \param[in] client_id  Client UID
+ *
+ * \return 16-bit hash of the pair (32-bit FNV-1a, xor-folded)
+ */
+static uint16_t ps_obj_index_hash(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t hash = 2166136261U;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(uid); i++) {
+        hash ^= (uint8_t)(uid >> (8 * i));
+        hash *= 16777619U;
+    }
+
+    for (i = 0; i < sizeof(client_id); i++) {
+        hash ^= (uint8_t)((uint32_t)client_id >> (8 * i));
+        hash *= 16777619U;
+    }
+
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/**
+ * \brief Checks if a table entry is in use in the object table index.
+ *
+ * \param[in] idx  Table entry index
+ *
+ * \return true if the entry is in use, false otherwise
+ */
+__attribute__ ((always_inline))
+__STATIC_INLINE bool ps_obj_index_is_used(uint32_t idx)
+{
+    return (ps_obj_table_index.used[idx / 32] & (1U << (idx % 32))) != 0;
+}
+
+/**
+ * \brief Adds a table entry to the object table index.
+ *
+ * \param[in] idx   Table entry index
+ * \param[in] hash  Hash of the entry's UID and client ID
+ */
+static void ps_obj_index_insert(uint32_t idx, uint16_t hash)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_index;
+    uint32_t pos = hash % PS_OBJ_INDEX_NUM_SLOTS;
+
+    while (index->slot[pos] != PS_OBJ_INDEX_EMPTY_SLOT) {
+        pos = (pos + 1) % PS_OBJ_INDEX_NUM_SLOTS;
+    }
+
+    index->slot[pos] = (uint16_t)idx;
+    index->key_hash[idx] = hash;
+    index->used[idx / 32] |= (1U << (idx % 32));
+}
+
+/**
+ * \brief Removes a table entry from the object table index.
+ *
+ * \param[in] idx  Table entry index, which must be in use
+ */
+static void ps_obj_index_remove(uint32_t idx)
+{
+    struct ps_obj_table_index_t *index = &ps_obj_table_index;
+    uint32_t pos = index->key_hash[idx] % PS_OBJ_INDEX_NUM_SLOTS;
+    uint32_t next;
+    uint32_t home;
+
+    while (index->slot[pos] != idx) {
+        pos = (pos + 1) % PS_OBJ_INDEX_NUM_SLOTS;
+    }
+
+    index->slot[pos] = PS_OBJ_INDEX_EMPTY_SLOT;
+    index->used[idx / 32] &= ~(1U << (idx % 32));
+
+    /* Shift back the following entries of the probe sequence which can no
+     * longer be reached from their home slot, so that no tombstones are needed.
+     */
+    next = (pos + 1) % PS_OBJ_INDEX_NUM_SLOTS;
+    while (index->slot[next] != PS_OBJ_INDEX_EMPTY_SLOT) {
+        home = index->key_hash[index->slot[next]] % PS_OBJ_INDEX_NUM_SLOTS;
+
+        /* The entry can stay unless its home slot is cyclically in
+         * (pos, next].
+         */
+        if ((pos <= next) ? ((home <= pos) || (home > next))
+                          : ((home <= pos) && (home > next))) {
+            index->slot[pos] = index->slot[next];
+            index->slot[next] = PS_OBJ_INDEX_EMPTY_SLOT;
+            pos = next;
+        }
+
+        next = (next + 1) % PS_OBJ_INDEX_NUM_SLOTS;
+    }
+}
+
+/**
+ * \brief Updates the object table index after a table entry has changed.
+ *
+ * \param[in] idx  Table entry index
+ */
+static void ps_obj_index_update(uint32_t idx)
+{
+    const struct ps_obj_table_entry_t *entry =
+                                      &ps_obj_table_ctx.obj_table.obj_db[idx];
+
+    if (ps_obj_index_is_used(idx)) {
+        ps_obj_index_remove(idx);
+    }
+
+    if (entry->uid != TFM_PS_INVALID_UID) {
+        ps_obj_index_insert(idx, ps_obj_index_hash(entry->uid,
+                                                   entry->client_id));
+    }
+}
+
+/**
+ * \brief Builds the object table index from the object table in the context.
+ */
+static void ps_obj_index_build(void)
+{
+    uint32_t idx;
+
+    (void)memset(ps_obj_table_index.used, 0, sizeof(ps_obj_table_index.used));
+    (void)memset(ps_obj_table_index.slot, 0xFF, sizeof(ps_obj_table_index.slot));
+
+    for (idx = 0; idx < PS_OBJ_TABLE_ENTRIES; idx++) {
+        ps_obj_index_update(idx);
+    }
+}
+#endif /* PS_OBJ_TABLE_INDEX */
+
+/**
+ * \brief Updates the data kept beside the object table after a table entry
+ *        has changed.
+ *
+ * \param[in] idx  Table entry index
+ */
+static void ps_table_entry_changed(uint32_t idx)
+{
+#if PS_OBJ_TABLE_INDEX
+    ps_obj_index_update(idx);
+#endif
+#if PS_OBJ_TABLE_HASH_TREE
+    ps_obj_tree_mark_entry(idx);
+#endif
+    (void)idx;
+}
+
 /**
  * \brief Gets table's entry index based on the given object UID and client ID.
  *
@@ -755,7 +1193,23 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
 {
     uint32_t i;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+#if PS_OBJ_TABLE_INDEX
+    uint16_t hash = ps_obj_index_hash(uid, client_id);
+    uint32_t pos = hash % PS_OBJ_INDEX_NUM_SLOTS;
+
+    while (ps_obj_table_index.slot[pos] != PS_OBJ_INDEX_EMPTY_SLOT) {
+        i = ps_obj_table_index.slot[pos];
 
+        if (ps_obj_table_index.key_hash[i] == hash
+            && p_table->obj_db[i].uid == uid
+            && p_table->obj_db[i].client_id == client_id) {
+            *idx = i;
+            return PSA_SUCCESS;
+        }
+
+        pos = (pos + 1) % PS_OBJ_INDEX_NUM_SLOTS;
+    }
+#else
     for (i = 0; i < PS_OBJ_TABLE_ENTRIES; i++) {
         if (p_table->obj_db[i].uid == uid
             && p_table->obj_db[i].client_id == client_id) {
@@ -763,6 +1217,7 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
             return PSA_SUCCESS;
         }
     }
+#endif /* PS_OBJ_TABLE_INDEX */
 
     return PSA_ERROR_DOES_NOT_EXIST;
 }
@@ -794,6 +1249,13 @@ __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
     }
 
     for (i = 0; i < PS_OBJ_TABLE_ENTRIES && idx_num > 0; i++) {
+#if PS_OBJ_TABLE_INDEX
+        /* Skip the index bitmap words where all the entries are in use */
+        if ((i % 32) == 0 && ps_obj_table_index.used[i / 32] == UINT32_MAX) {
+            i += 31;
+            continue;
+        }
+#endif
         if (p_table->obj_db[i].uid == TFM_PS_INVALID_UID) {
             last_free = i;
             idx_num--;
@@ -819,6 +1281,8 @@ static void ps_table_delete_entry(uint32_t idx)
     /* Initialise object table entry structure */
     (void)memset(&ps_obj_table_ctx.obj_table.obj_db[idx],
                  PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJECTS_TABLE_ENTRY_SIZE);
+
+    ps_table_entry_changed(idx);
 }
 
 psa_status_t ps_object_table_create(void)
@@ -837,6 +1301,13 @@ psa_status_t ps_object_table_create(void)
 
     p_table->version = PS_OBJECT_SYSTEM_VERSION;
 
+#if PS_OBJ_TABLE_INDEX
+    ps_obj_index_build();
+#endif
+#if PS_OBJ_TABLE_HASH_TREE
+    ps_obj_tree_invalidate();
+#endif
+
     /* Save object table contents */
     return ps_object_table_save_table(p_table);
 }
@@ -914,6 +1385,16 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
     ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.crypto);
 #endif
 
+#if PS_OBJ_TABLE_INDEX
+    ps_obj_index_build();
+#endif
+#if PS_OBJ_TABLE_HASH_TREE
+    /* The hash tree has been used to authenticate the tables read from the
+     * file system, so it is rebuilt from the active table on the next save.
+     */
+    ps_obj_tree_invalidate();
+#endif
+
     return PSA_SUCCESS;
 }
 
@@ -997,6 +1478,7 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
 #else
     p_table->obj_db[idx].version = obj_tbl_info->version;
 #endif
+    ps_table_entry_changed(idx);
 
     err = ps_object_table_save_table(p_table);
     if (err != PSA_SUCCESS) {
@@ -1004,6 +1486,7 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
             /* Rollback the change in the table */
             (void)memcpy(&p_table->obj_db[backup_idx], &backup_entry,
                          PS_OBJECTS_TABLE_ENTRY_SIZE);
+            ps_table_entry_changed(backup_idx);
         }
 
         ps_table_delete_entry(idx);
@@ -1068,6 +1551,7 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
        /* Rollback the change in the table */
        (void)memcpy(&p_table->obj_db[backup_idx], &backup_entry,
                     PS_OBJECTS_TABLE_ENTRY_SIZE);
+       ps_table_entry_changed(backup_idx);
     }
 
     return err;
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the PS object table, which uses the RAM index of the entries when
+ * PS_OBJ_TABLE_INDEX is enabled and authenticates the table through a hash
+ * tree when PS_OBJ_TABLE_HASH_TREE is enabled: the data authenticated by each
+ * table update, random creates, deletes and re-inits, some of them with a
+ * failed table write, and the rejection of a tampered table. The same tests
+ * run with both options disabled, as the reference.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_tfm.h"
+#include "crypto/ps_crypto_interface.h"
+#include "ps_object_table.h"
+#include "ps_test_its.h"
+
+/* UIDs of the objects used by the tests, half of which are never created */
+#define NUM_UIDS        (PS_NUM_ASSETS + (PS_NUM_ASSETS / 2U))
+/* Client IDs of the objects, from -1 to 1 */
+#define NUM_CLIENTS     3U
+#define NUM_SEEDS       8U
+#define NUM_RAND_OPS    1000U
+#define NUM_TAMPERS     200U
+#define NUM_UPDATES     100U
+
+/* Files of the two object tables */
+#define TABLE_FID_0     1U
+#define TABLE_FID_1     2U
+
+struct test_object_t {
+    psa_storage_uid_t uid;
+    int32_t client_id;
+    uint32_t fid;
+    uint8_t tag[PS_TAG_LEN_BYTES];
+};
+
+/* Buffer lent to the object table to read the second table at init */
+static uint8_t obj_data[PS_TEST_ITS_FILE_SIZE];
+static struct test_object_t objects[PS_NUM_ASSETS];
+static uint32_t num_objects;
+
+static int32_t rand_client_id(void)
+{
+    return (int32_t)ps_test_rand(NUM_CLIENTS) - 1;
+}
+
+/**
+ * \brief Finds an object of the model.
+ *
+ * \return Index of the object, or -1 if it does not exist
+ */
+static int32_t find_object(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < num_objects; i++) {
+        if ((objects[i].uid == uid) && (objects[i].client_id == client_id)) {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * \brief Checks whether the object table holds an object as in the model.
+ *
+ * \return true if it does
+ */
+static bool object_matches(psa_storage_uid_t uid, int32_t client_id)
+{
+    struct ps_obj_table_info_t info;
+    uint8_t tag[PS_TAG_LEN_BYTES];
+    int32_t i = find_object(uid, client_id);
+    psa_status_t err;
+
+    info.tag = tag;
+    err = ps_object_table_get_obj_tbl_info(uid, client_id, &info);
+    if (i < 0) {
+        return (err == PSA_ERROR_DOES_NOT_EXIST) &&
+               (ps_object_table_obj_exist(uid, client_id) ==
+                PSA_ERROR_DOES_NOT_EXIST);
+    }
+
+    return (err == PSA_SUCCESS) && (info.fid == objects[i].fid) &&
+           (memcmp(tag, objects[i].tag, sizeof(tag)) == 0) &&
+           (ps_object_table_obj_exist(uid, client_id) == PSA_SUCCESS);
+}
+
+/**
+ * \brief Checks whether the object table holds the objects of the model, and
+ *        some objects which are not in the model, or all of them.
+ *
+ * \param[in] all  Whether to check all the objects which are not in the model
+ *
+ * \return true if it does
+ */
+static bool table_matches(bool all)
+{
+    psa_storage_uid_t uid;
+    int32_t client_id;
+    uint32_t i;
+
+    for (i = 0; i < num_objects; i++) {
+        if (!object_matches(objects[i].uid, objects[i].client_id)) {
+            return false;
+        }
+    }
+
+    if (all) {
+        for (uid = 1; uid <= NUM_UIDS; uid++) {
+            for (client_id = -1; client_id <= 1; client_id++) {
+                if (!object_matches(uid, client_id)) {
+                    return false;
+                }
+            }
+        }
+    } else {
+        for (i = 0; i < 8U; i++) {
+            if (!object_matches(1 + ps_test_rand(NUM_UIDS),
+                                rand_client_id())) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Creates or replaces an object in the object table, as PS does.
+ *
+ * \param[in] uid        UID of the object
+ * \param[in] client_id  Client ID of the object
+ * \param[in] fail       Whether the table write fails
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t set_object(psa_storage_uid_t uid, int32_t client_id,
+                               bool fail)
+{
+    struct ps_obj_table_info_t info;
+    uint8_t tag[PS_TAG_LEN_BYTES];
+    int32_t i = find_object(uid, client_id);
+    psa_status_t err;
+    uint32_t k;
+
+    /* As PS, request a spare file ID to create an object, for its updates */
+    err = ps_object_table_get_free_fid((i < 0) ? 2 : 1, &info.fid);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    for (k = 0; k < sizeof(tag); k++) {
+        tag[k] = (uint8_t)ps_test_rand(256);
+    }
+    info.tag = tag;
+
+    if (fail) {
+        ps_test_its_fail_next_set();
+    }
+
+    err = ps_object_table_set_obj_tbl_info(uid, client_id, &info);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (i < 0) {
+        i = (int32_t)num_objects++;
+    }
+    objects[i].uid = uid;
+    objects[i].client_id = client_id;
+    objects[i].fid = info.fid;
+    (void)memcpy(objects[i].tag, tag, sizeof(tag));
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Deletes an object from the object table.
+ *
+ * \param[in] uid        UID of the object
+ * \param[in] client_id  Client ID of the object
+ * \param[in] fail       Whether the table write fails
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t delete_object(psa_storage_uid_t uid, int32_t client_id,
+                                  bool fail)
+{
+    int32_t i = find_object(uid, client_id);
+    psa_status_t err;
+
+    if (fail) {
+        ps_test_its_fail_next_set();
+    }
+
+    err = ps_object_table_delete_object(uid, client_id);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (i >= 0) {
+        objects[i] = objects[--num_objects];
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Creates an empty object table on a new device.
+ */
+static int create_table(void)
+{
+    ps_test_its_wipe();
+    num_objects = 0;
+
+    TEST_CHECK(ps_object_table_init(obj_data) != PSA_SUCCESS);
+    TEST_CHECK(ps_object_table_create() == PSA_SUCCESS);
+
+    return 0;
+}
+
+/**
+ * \brief Re-initializes the object table from the stored tables, as after a
+ *        reset, with the buffer lent to it filled with garbage.
+ */
+static psa_status_t reinit_table(void)
+{
+    (void)memset(obj_data, 0xAA, sizeof(obj_data));
+
+    return ps_object_table_init(obj_data);
+}
+
+/**
+ * \brief Measures the data authenticated and hashed by the updates of a half
+ *        full object table.
+ */
+static int test_update_work(void)
+{
+    uint32_t auth_bytes;
+    uint32_t hash_bytes;
+    uint32_t i;
+
+    TEST_CHECK(create_table() == 0);
+    ps_test_srand(1);
+
+    for (i = 0; i < PS_NUM_ASSETS / 2U; i++) {
+        TEST_CHECK(set_object(1 + i, 0, false) == PSA_SUCCESS);
+    }
+
+    ps_test_crypto_reset_stats();
+    for (i = 0; i < NUM_UPDATES; i++) {
+        TEST_CHECK(set_object(1 + ps_test_rand(PS_NUM_ASSETS / 2U), 0,
+                              false) == PSA_SUCCESS);
+    }
+    auth_bytes = ps_test_crypto_auth_bytes() / NUM_UPDATES;
+    hash_bytes = ps_test_crypto_hash_bytes() / NUM_UPDATES;
+
+    printf("%u assets: %u bytes authenticated and %u bytes hashed per "
+           "table update\n", PS_NUM_ASSETS, auth_bytes, hash_bytes);
+
+#if PS_OBJ_TABLE_HASH_TREE
+    /* The header, the tree root and the NV counter are authenticated, and
+     * the leaves of the changed entries are hashed.
+     */
+    TEST_CHECK(auth_bytes < 64U);
+    TEST_CHECK(hash_bytes < (PS_NUM_ASSETS * sizeof(struct test_object_t)));
+#else
+    /* The whole table is authenticated */
+    TEST_CHECK(auth_bytes > PS_NUM_ASSETS * PS_TAG_LEN_BYTES);
+    TEST_CHECK(hash_bytes == 0);
+#endif
+
+    TEST_CHECK(reinit_table() == PSA_SUCCESS);
+    TEST_CHECK(table_matches(true));
+
+    return 0;
+}
+
+/**
+ * \brief Makes random creates, updates, deletes and re-inits, some of them
+ *        with a failed table write, and checks the object table after each of
+ *        them.
+ */
+static int test_random(uint32_t seed)
+{
+    psa_storage_uid_t uid;
+    int32_t client_id;
+    bool exists;
+    bool failed = false;
+    bool fail;
+    uint32_t op;
+    uint32_t r;
+    psa_status_t err;
+
+    TEST_CHECK(create_table() == 0);
+    ps_test_srand(seed);
+
+    for (op = 0; op < NUM_RAND_OPS; op++) {
+        r = ps_test_rand(100);
+        uid = 1 + ps_test_rand(NUM_UIDS);
+        client_id = rand_client_id();
+        exists = (find_object(uid, client_id) >= 0);
+
+        /* With rollback protection, the NV counter is incremented before the
+         * table is written, and a re-init only accepts a table one increment
+         * behind. A failed write is then followed by a successful one before
+         * the next failure or re-init.
+         */
+        fail = !failed && (ps_test_rand(16) == 0);
+
+        if (r < 60) {
+            if (!exists && (num_objects == PS_NUM_ASSETS)) {
+                TEST_CHECK(set_object(uid, client_id, false) ==
+                           PSA_ERROR_INSUFFICIENT_STORAGE);
+            } else {
+                err = set_object(uid, client_id, fail);
+                TEST_CHECK((err == PSA_SUCCESS) != fail);
+                failed = fail;
+            }
+        } else if (r < 90) {
+            if (!exists) {
+                TEST_CHECK(delete_object(uid, client_id, false) ==
+                           PSA_ERROR_DOES_NOT_EXIST);
+            } else {
+                err = delete_object(uid, client_id, fail);
+                TEST_CHECK((err == PSA_SUCCESS) != fail);
+                failed = fail;
+            }
+        } else if (!failed) {
+            TEST_CHECK(reinit_table() == PSA_SUCCESS);
+        }
+
+        /* A failed change leaves the table unchanged */
+        if (!table_matches(r >= 90)) {
+            printf("seed %u, op %u: object table does not match\n", seed, op);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Inverts random bits of the active table, and checks that a re-init
+ *        either rejects it, or loads the same objects.
+ */
+static int test_tamper(void)
+{
+    psa_storage_uid_t table_fid;
+    size_t table_size;
+    size_t offset;
+    uint8_t mask;
+    uint32_t num_detected = 0;
+    uint32_t i;
+
+    TEST_CHECK(create_table() == 0);
+    ps_test_srand(1);
+
+    for (i = 0; i < PS_NUM_ASSETS / 2U; i++) {
+        TEST_CHECK(set_object(1 + ps_test_rand(NUM_UIDS), rand_client_id(),
+                              false) == PSA_SUCCESS);
+    }
+
+    /* Leave only the active table, so that the older table cannot be loaded
+     * instead.
+     */
+    table_fid = ps_test_its_last_set_uid();
+    TEST_CHECK((table_fid == TABLE_FID_0) || (table_fid == TABLE_FID_1));
+    TEST_CHECK(ps_object_table_delete_old_table() == PSA_SUCCESS);
+    table_size = ps_test_its_file_size(table_fid);
+
+    for (i = 0; i < NUM_TAMPERS; i++) {
+        offset = ps_test_rand(table_size);
+        mask = (uint8_t)(1U << ps_test_rand(8));
+
+        TEST_CHECK(ps_test_its_corrupt(table_fid, offset, mask));
+        if (reinit_table() == PSA_SUCCESS) {
+            if (!table_matches(true)) {
+                printf("tampered table accepted, offset %zu\n", offset);
+                return 1;
+            }
+        } else {
+            num_detected++;
+        }
+
+        TEST_CHECK(ps_test_its_corrupt(table_fid, offset, mask));
+        TEST_CHECK(reinit_table() == PSA_SUCCESS);
+        TEST_CHECK(table_matches(false));
+    }
+
+    printf("%u of %u tampered tables rejected, the others unchanged\n",
+           num_detected, NUM_TAMPERS);
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    if (test_update_work() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    for (seed = 1; seed <= NUM_SEEDS; seed++) {
+        if (test_random(seed) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (test_tamper() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: %u seeds\n", NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
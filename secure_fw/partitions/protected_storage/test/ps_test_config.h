@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PS_TEST_CONFIG_H__
+#define __PS_TEST_CONFIG_H__
+
+/* Project configuration of the host tests of the PS object table. Options
+ * which are not set here, or by the test build, take their config_base.h
+ * default.
+ */
+#define PS_NUM_ASSETS                          300
+
+/* The object table is read into the object buffer at init */
+#define PS_MAX_ASSET_SIZE                      10240
+
+#endif /* __PS_TEST_CONFIG_H__ */
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Stand-ins for the services used by the PS object table in the host tests:
+ * the ITS APIs on files kept in RAM, the PS NV counters and the PS crypto
+ * interface. The crypto only has to detect changes of the authenticated data,
+ * so it uses a non-cryptographic hash.
+ */
+
+#include "ps_test_its.h"
+
+#include <string.h>
+
+#include "crypto/ps_crypto_interface.h"
+#include "nv_counters/ps_nv_counters.h"
+
+struct ps_test_file_t {
+    bool used;
+    psa_storage_uid_t uid;
+    size_t size;
+    uint8_t data[PS_TEST_ITS_FILE_SIZE];
+};
+
+static struct ps_test_file_t its_files[PS_TEST_ITS_NUM_FILES];
+static psa_storage_uid_t its_last_set_uid;
+static bool its_fail_next_set;
+static uint32_t nv_counters[3];
+static uint8_t crypto_key[32];
+static size_t crypto_key_len;
+static uint64_t crypto_next_iv = 1;
+static uint32_t crypto_auth_bytes;
+static uint32_t crypto_hash_bytes;
+static uint32_t rand_state = 1;
+
+static struct ps_test_file_t *find_file(psa_storage_uid_t uid)
+{
+    uint32_t i;
+
+    for (i = 0; i < PS_TEST_ITS_NUM_FILES; i++) {
+        if (its_files[i].used && (its_files[i].uid == uid)) {
+            return &its_files[i];
+        }
+    }
+
+    return NULL;
+}
+
+psa_status_t psa_its_set(psa_storage_uid_t uid, size_t data_length,
+                         const void *p_data,
+                         psa_storage_create_flags_t create_flags)
+{
+    struct ps_test_file_t *file = find_file(uid);
+    uint32_t i;
+
+    (void)create_flags;
+
+    if (its_fail_next_set) {
+        its_fail_next_set = false;
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    if (data_length > PS_TEST_ITS_FILE_SIZE) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    for (i = 0; (file == NULL) && (i < PS_TEST_ITS_NUM_FILES); i++) {
+        if (!its_files[i].used) {
+            file = &its_files[i];
+        }
+    }
+
+    if (file == NULL) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    file->used = true;
+    file->uid = uid;
+    file->size = data_length;
+    (void)memcpy(file->data, p_data, data_length);
+    its_last_set_uid = uid;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid, size_t data_offset,
+                         size_t data_size, void *p_data,
+                         size_t *p_data_length)
+{
+    struct ps_test_file_t *file = find_file(uid);
+
+    if (file == NULL) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    if (data_offset > file->size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (data_size > file->size - data_offset) {
+        data_size = file->size - data_offset;
+    }
+
+    (void)memcpy(p_data, file->data + data_offset, data_size);
+    *p_data_length = data_size;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid)
+{
+    struct ps_test_file_t *file = find_file(uid);
+
+    if (file == NULL) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    file->used = false;
+
+    return PSA_SUCCESS;
+}
+
+void ps_test_its_wipe(void)
+{
+    (void)memset(its_files, 0, sizeof(its_files));
+    (void)memset(nv_counters, 0, sizeof(nv_counters));
+    its_fail_next_set = false;
+}
+
+void ps_test_its_fail_next_set(void)
+{
+    its_fail_next_set = true;
+}
+
+psa_storage_uid_t ps_test_its_last_set_uid(void)
+{
+    return its_last_set_uid;
+}
+
+bool ps_test_its_corrupt(psa_storage_uid_t uid, size_t offset, uint8_t mask)
+{
+    struct ps_test_file_t *file = find_file(uid);
+
+    if ((file == NULL) || (offset >= file->size)) {
+        return false;
+    }
+
+    file->data[offset] ^= mask;
+
+    return true;
+}
+
+size_t ps_test_its_file_size(psa_storage_uid_t uid)
+{
+    struct ps_test_file_t *file = find_file(uid);
+
+    return (file != NULL) ? file->size : 0;
+}
+
+psa_status_t ps_read_nv_counter(enum tfm_nv_counter_t counter_id,
+                                uint32_t *val)
+{
+    *val = nv_counters[counter_id - TFM_PS_NV_COUNTER_1];
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_increment_nv_counter(enum tfm_nv_counter_t counter_id)
+{
+    nv_counters[counter_id - TFM_PS_NV_COUNTER_1]++;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Updates a 64-bit FNV-1a hash with data.
+ */
+static uint64_t fnv_update(uint64_t hash, const uint8_t *data, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * \brief Computes a digest of the key, the IV and the data, of the given size.
+ */
+static void compute_digest(const uint8_t *key, size_t key_len,
+                           const uint8_t *iv, const uint8_t *data,
+                           size_t size, uint8_t *digest, size_t digest_len)
+{
+    uint64_t hash;
+    size_t i;
+
+    for (i = 0; i < digest_len; i += sizeof(hash)) {
+        hash = 0xCBF29CE484222325ULL + i;
+        hash = fnv_update(hash, key, key_len);
+        hash = fnv_update(hash, iv, PS_IV_LEN_BYTES);
+        hash = fnv_update(hash, data, size);
+        (void)memcpy(digest + i, &hash, sizeof(hash));
+    }
+}
+
+psa_status_t ps_crypto_init(void)
+{
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
+{
+    crypto_key_len = (key_label_len < sizeof(crypto_key)) ?
+                     key_label_len : sizeof(crypto_key);
+    (void)memcpy(crypto_key, key_label, crypto_key_len);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_destroykey(void)
+{
+    crypto_key_len = 0;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
+                                         const uint8_t *add,
+                                         uint32_t add_len)
+{
+    crypto_auth_bytes += add_len;
+    compute_digest(crypto_key, crypto_key_len, crypto->ref.iv, add, add_len,
+                   crypto->ref.tag, PS_TAG_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
+                                    const uint8_t *add,
+                                    uint32_t add_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    crypto_auth_bytes += add_len;
+    compute_digest(crypto_key, crypto_key_len, crypto->ref.iv, add, add_len,
+                   tag, sizeof(tag));
+
+    return (memcmp(tag, crypto->ref.tag, sizeof(tag)) == 0) ?
+           PSA_SUCCESS : PSA_ERROR_INVALID_SIGNATURE;
+}
+
+psa_status_t ps_crypto_hash(const uint8_t *in, size_t in_len, uint8_t *hash)
+{
+    static const uint8_t no_iv[PS_IV_LEN_BYTES] = {0};
+
+    crypto_hash_bytes += in_len;
+    /* Unkeyed */
+    compute_digest(NULL, 0, no_iv, in, in_len, hash, PS_HASH_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+void ps_crypto_set_iv(const union ps_crypto_t *crypto)
+{
+    uint64_t iv;
+
+    (void)memcpy(&iv, crypto->ref.iv, sizeof(iv));
+    if (iv >= crypto_next_iv) {
+        crypto_next_iv = iv + 1;
+    }
+}
+
+psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto)
+{
+    (void)memset(crypto->ref.iv, 0, PS_IV_LEN_BYTES);
+    (void)memcpy(crypto->ref.iv, &crypto_next_iv, sizeof(crypto_next_iv));
+    crypto_next_iv++;
+
+    return PSA_SUCCESS;
+}
+
+uint32_t ps_test_crypto_auth_bytes(void)
+{
+    return crypto_auth_bytes;
+}
+
+uint32_t ps_test_crypto_hash_bytes(void)
+{
+    return crypto_hash_bytes;
+}
+
+void ps_test_crypto_reset_stats(void)
+{
+    crypto_auth_bytes = 0;
+    crypto_hash_bytes = 0;
+}
+
+void ps_test_srand(uint32_t seed)
+{
+    rand_state = (seed != 0) ? seed : 1;
+}
+
+uint32_t ps_test_rand(uint32_t bound)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+
+    return rand_state % bound;
+}
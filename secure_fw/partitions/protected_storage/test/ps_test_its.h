@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PS_TEST_ITS_H__
+#define __PS_TEST_ITS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "psa/internal_trusted_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of files and largest file size of the ITS emulated in RAM */
+#define PS_TEST_ITS_NUM_FILES   4U
+#define PS_TEST_ITS_FILE_SIZE   16384U
+
+/**
+ * \brief Checks a condition in a test function returning int, and fails the
+ *        test if it does not hold.
+ */
+#define TEST_CHECK(cond)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                     \
+        }                                                                 \
+    } while (0)
+
+/**
+ * \brief Removes all the files of the test ITS and resets the NV counters, as
+ *        on a new device.
+ */
+void ps_test_its_wipe(void);
+
+/**
+ * \brief Makes the next psa_its_set() call fail with
+ *        PSA_ERROR_STORAGE_FAILURE, without changing the file.
+ */
+void ps_test_its_fail_next_set(void);
+
+/**
+ * \brief Gets the UID of the file written by the last successful
+ *        psa_its_set() call.
+ *
+ * \return UID of the file
+ */
+psa_storage_uid_t ps_test_its_last_set_uid(void);
+
+/**
+ * \brief Inverts a bit of a file of the test ITS.
+ *
+ * \param[in] uid     UID of the file
+ * \param[in] offset  Offset of the byte to change
+ * \param[in] mask    Bits of the byte to invert
+ *
+ * \return true if the file exists and is larger than offset
+ */
+bool ps_test_its_corrupt(psa_storage_uid_t uid, size_t offset, uint8_t mask);
+
+/**
+ * \brief Gets the size of a file of the test ITS.
+ *
+ * \param[in] uid  UID of the file
+ *
+ * \return Size of the file, or 0 if it does not exist
+ */
+size_t ps_test_its_file_size(psa_storage_uid_t uid);
+
+/**
+ * \brief Gets the number of bytes authenticated by the test crypto since the
+ *        last call to \ref ps_test_crypto_reset_stats, with
+ *        ps_crypto_generate_auth_tag() and ps_crypto_authenticate().
+ *
+ * \return Number of bytes
+ */
+uint32_t ps_test_crypto_auth_bytes(void);
+
+/**
+ * \brief Gets the number of bytes hashed by the test crypto since the last
+ *        call to \ref ps_test_crypto_reset_stats, with ps_crypto_hash().
+ *
+ * \return Number of bytes
+ */
+uint32_t ps_test_crypto_hash_bytes(void);
+
+/**
+ * \brief Resets the statistics of the test crypto.
+ */
+void ps_test_crypto_reset_stats(void);
+
+/**
+ * \brief Seeds the pseudo-random generator of the tests.
+ *
+ * \param[in] seed  Seed
+ */
+void ps_test_srand(uint32_t seed);
+
+/**
+ * \brief Gets a pseudo-random number.
+ *
+ * \param[in] bound  Exclusive upper bound of the number, greater than 0
+ *
+ * \return Number between 0 and bound - 1
+ */
+uint32_t ps_test_rand(uint32_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PS_TEST_ITS_H__ */
@@ -54,7 +54,8 @@ struct context_ctrl_t *p_spm_thread_context = &spm_thread_context;
 uintptr_t *partition_meta_indicator_pos;
 
 /*
- * Query the state of current thread.
+ * Query the state of a thread woken up by an asserted signal, and get its
+ * return value.
  */
 static uint32_t query_state(struct thread_t *p_thrd, uint32_t *p_retval)
 {
@@ -183,7 +184,7 @@ psa_status_t backend_messaging(struct service_t *service,
     p_owner = service->partition;
     signal = service->p_ldinf->signal;
 
-    UNI_LIST_INSERT_AFTER(p_owner, handle, p_handles);
+    spm_queue_handle_to_service(service, handle);
 
     /* Messages put. Update signals */
     ret = backend_assert_signal(p_owner, signal);
@@ -353,6 +354,7 @@ psa_status_t backend_wait_signals(struct partition_t *p_pt, psa_signal_t signals
     ret = p_pt->signals_asserted & signals;
     if (ret == 0) {
         p_pt->signals_waiting = signals;
+        thrd_set_state(&p_pt->thrd, THRD_STATE_BLOCK);
         ret = STATUS_NEED_SCHEDULE;
     }
 
@@ -374,6 +376,8 @@ psa_status_t backend_assert_signal(struct partition_t *p_pt, psa_signal_t signal
     p_pt->signals_asserted |= signal;
 
     if (p_pt->signals_asserted & p_pt->signals_waiting) {
+        /* Wake up the thread, its return value is got when it is scheduled */
+        thrd_set_state(&p_pt->thrd, THRD_STATE_RET_VAL_AVAIL);
         ret = STATUS_NEED_SCHEDULE;
     }
     CRITICAL_SECTION_LEAVE(cs_signal);
@@ -16,8 +16,139 @@
 #include "tfm_psa_call_pack.h"
 #include "utilities.h"
 
+#ifdef CONFIG_TFM_ENALBE_PROFILING
+#include "prof_intf_s.h"
+
+/* Profiling checkpoints around the validation of the client memory */
+#define PROF_TOPIC_SPM_PSA_CALL          0x10
+#define PROF_CP_PSA_CALL_MEM_CHECK_START 0x01
+#define PROF_CP_PSA_CALL_MEM_CHECK_END   0x02
+#else
+#define PROF_TIMING_LOG(cp_id, topic_id)
+#endif
+
 extern struct service_t *stateless_services_ref_tbl[];
 
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+/*
+ * Client memory ranges recently validated by tfm_hal_memory_check(). The tag
+ * redundantly encodes the other fields, so that a cache hit is checked twice.
+ */
+static struct mem_check_cache_entry_t {
+    uintptr_t boundary;
+    uintptr_t base;
+    uintptr_t limit;                /* Exclusive end of the range */
+    uint32_t access_type;
+    fih_int tag;
+} mem_check_cache[CONFIG_TFM_MEM_CHECK_CACHE_NUM];
+
+/* Index of the entry to be replaced next */
+static uint32_t mem_check_cache_next;
+
+static fih_int mem_check_cache_tag(uintptr_t boundary, uintptr_t base,
+                                   uintptr_t limit, uint32_t access_type)
+{
+    return fih_int_encode((int32_t)(boundary ^ base ^ limit ^ access_type));
+}
+
+void spm_flush_mem_check_cache(void)
+{
+    struct critical_section_t cs_cache = CRITICAL_SECTION_STATIC_INIT;
+
+    CRITICAL_SECTION_ENTER(cs_cache);
+    spm_memset(mem_check_cache, 0, sizeof(mem_check_cache));
+    mem_check_cache_next = 0;
+    CRITICAL_SECTION_LEAVE(cs_cache);
+}
+
+static bool mem_check_cache_covers(const struct mem_check_cache_entry_t *entry,
+                                   uintptr_t boundary, uintptr_t base,
+                                   uintptr_t limit, uint32_t access_type)
+{
+    return (entry->boundary == boundary) &&
+           (entry->base <= base) && (limit <= entry->limit) &&
+           ((entry->access_type & access_type) == access_type);
+}
+
+/*
+ * Same as tfm_hal_memory_check(), but skips the platform check for a range
+ * contained in a range already validated for the same boundary with at least
+ * the same access permissions.
+ * The access of Non-secure callers also depends on the Non-secure MPU
+ * configuration and on the privilege of the Non-secure thread. Their ranges
+ * are only cached when the NS client extension flushes the cache on each
+ * Non-secure context switch.
+ */
+static FIH_RET_TYPE(enum tfm_hal_status_t) spm_memory_check(uintptr_t boundary,
+                                                            uintptr_t base,
+                                                            size_t size,
+                                                            uint32_t access_type)
+{
+    struct critical_section_t cs_cache = CRITICAL_SECTION_STATIC_INIT;
+    struct mem_check_cache_entry_t *entry;
+    uintptr_t limit = base + size;
+    fih_int fih_rc = FIH_FAILURE;
+    bool hit = false;
+    uint32_t i;
+
+    /* Empty or wrapping ranges are left to the platform check */
+#ifdef TFM_NS_MANAGE_NSID
+    if ((size == 0) || (limit <= base)) {
+#else
+    if ((size == 0) || (limit <= base) || tfm_spm_is_ns_caller()) {
+#endif
+        FIH_CALL(tfm_hal_memory_check, fih_rc,
+                 boundary, base, size, access_type);
+        FIH_RET(fih_rc);
+    }
+
+    CRITICAL_SECTION_ENTER(cs_cache);
+    for (i = 0; i < CONFIG_TFM_MEM_CHECK_CACHE_NUM; i++) {
+        entry = &mem_check_cache[i];
+        if (mem_check_cache_covers(entry, boundary, base, limit,
+                                   access_type)) {
+            /* Check the hit again, against the redundant tag */
+            fih_delay();
+            if (fih_not_eq(entry->tag,
+                           mem_check_cache_tag(entry->boundary, entry->base,
+                                               entry->limit,
+                                               entry->access_type)) ||
+                !mem_check_cache_covers(entry, boundary, base, limit,
+                                        access_type)) {
+                tfm_core_panic();
+            }
+            hit = true;
+            break;
+        }
+    }
+    CRITICAL_SECTION_LEAVE(cs_cache);
+
+    if (hit) {
+        FIH_RET(fih_int_encode(TFM_HAL_SUCCESS));
+    }
+
+    FIH_CALL(tfm_hal_memory_check, fih_rc, boundary, base, size, access_type);
+    if (fih_not_eq(fih_rc, fih_int_encode(TFM_HAL_SUCCESS))) {
+        FIH_RET(fih_rc);
+    }
+
+    CRITICAL_SECTION_ENTER(cs_cache);
+    entry = &mem_check_cache[mem_check_cache_next];
+    entry->boundary = boundary;
+    entry->base = base;
+    entry->limit = limit;
+    entry->access_type = access_type;
+    entry->tag = mem_check_cache_tag(boundary, base, limit, access_type);
+    mem_check_cache_next = (mem_check_cache_next + 1) %
+                           CONFIG_TFM_MEM_CHECK_CACHE_NUM;
+    CRITICAL_SECTION_LEAVE(cs_cache);
+
+    FIH_RET(fih_rc);
+}
+#else /* CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0 */
+#define spm_memory_check tfm_hal_memory_check
+#endif /* CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0 */
+
 psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
                                      uint32_t ctrl_param,
                                      const psa_invec *inptr,
@@ -30,7 +161,6 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
     int i, j;
     int32_t client_id;
     uint32_t sid, version, index;
-    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
     bool ns_caller = tfm_spm_is_ns_caller();
     struct partition_t *curr_partition = GET_CURRENT_COMPONENT();
     int32_t type = PARAM_UNPACK_TYPE(ctrl_param);
@@ -82,9 +212,7 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
             return PSA_ERROR_PROGRAMMER_ERROR;
         }
 
-        CRITICAL_SECTION_ENTER(cs_assert);
-        p_connection = spm_allocate_connection();
-        CRITICAL_SECTION_LEAVE(cs_assert);
+        p_connection = spm_allocate_stateless_connection(curr_partition);
 
         if (!p_connection) {
             return PSA_ERROR_CONNECTION_BUSY;
@@ -123,10 +251,13 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
      * if the memory reference for the wrap input vector is invalid or not
      * readable.
      */
-    FIH_CALL(tfm_hal_memory_check, fih_rc,
+    PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_START, PROF_TOPIC_SPM_PSA_CALL);
+    FIH_CALL(spm_memory_check, fih_rc,
              curr_partition->boundary, (uintptr_t)inptr,
              in_num * sizeof(psa_invec), TFM_HAL_ACCESS_READABLE);
     if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END,
+                        PROF_TOPIC_SPM_PSA_CALL);
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
@@ -135,10 +266,12 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
      * actual length later. It is a PROGRAMMER ERROR if the memory reference for
      * the wrap output vector is invalid or not read-write.
      */
-    FIH_CALL(tfm_hal_memory_check, fih_rc,
+    FIH_CALL(spm_memory_check, fih_rc,
              curr_partition->boundary, (uintptr_t)outptr,
              out_num * sizeof(psa_outvec), TFM_HAL_ACCESS_READWRITE);
     if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END,
+                        PROF_TOPIC_SPM_PSA_CALL);
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
@@ -160,6 +293,8 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
                   (char *) invecs[i].base ||
                   (char *) invecs[j].base >=
                   (char *) invecs[i].base + invecs[i].len)) {
+                PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END,
+                                PROF_TOPIC_SPM_PSA_CALL);
                 return PSA_ERROR_PROGRAMMER_ERROR;
             }
         }
@@ -176,10 +311,12 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
          * memory reference was invalid or not readable.
          */
         for (i = 0; i < in_num; i++) {
-            FIH_CALL(tfm_hal_memory_check, fih_rc,
+            FIH_CALL(spm_memory_check, fih_rc,
                      curr_partition->boundary, (uintptr_t)invecs[i].base,
                      invecs[i].len, TFM_HAL_ACCESS_READABLE);
             if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+                PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END,
+                                PROF_TOPIC_SPM_PSA_CALL);
                 return PSA_ERROR_PROGRAMMER_ERROR;
             }
         }
@@ -189,14 +326,17 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
          * payload memory reference was invalid or not read-write.
          */
         for (i = 0; i < out_num; i++) {
-            FIH_CALL(tfm_hal_memory_check, fih_rc,
+            FIH_CALL(spm_memory_check, fih_rc,
                      curr_partition->boundary, (uintptr_t)outvecs[i].base,
                      outvecs[i].len, TFM_HAL_ACCESS_READWRITE);
             if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+                PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END,
+                                PROF_TOPIC_SPM_PSA_CALL);
                 return PSA_ERROR_PROGRAMMER_ERROR;
             }
         }
     }
+    PROF_TIMING_LOG(PROF_CP_PSA_CALL_MEM_CHECK_END, PROF_TOPIC_SPM_PSA_CALL);
 
     p_connection->msg.type = type;
     for (i = 0; i < in_num; i++) {
@@ -108,16 +108,19 @@ struct partition_t *load_a_partition_assuredly(struct partition_head_t *head)
 }
 
 uint32_t load_services_assuredly(struct partition_t *p_partition,
-                                 struct service_head_t *services_listhead,
+                                 struct service_t **sorted_services_tbl,
+                                 size_t sorted_tbl_size,
                                  struct service_t **stateless_services_ref_tbl,
                                  size_t ref_tbl_size)
 {
-    uint32_t i, serv_ldflags, hidx, service_setting = 0;
+    uint32_t i, serv_ldflags, hidx, sidx, service_setting = 0;
     struct service_t *services;
     const struct partition_load_info_t *p_ptldinf;
     const struct service_load_info_t *p_servldinf;
 
-    if (!p_partition || !services_listhead) {
+    if (!p_partition || !sorted_services_tbl ||
+        (sorted_tbl_size !=
+         CONFIG_TFM_SERVICE_NUM * sizeof(struct service_t *))) {
         tfm_core_panic();
     }
 
@@ -129,10 +132,17 @@ uint32_t load_services_assuredly(struct partition_t *p_partition,
      * The loop won't go in the NULL case.
      */
     services = tfm_allocate_service_assuredly(p_ptldinf->nservices);
+#if CONFIG_TFM_SPM_BACKEND_IPC == 1
+    p_partition->p_services = services;
+#endif
     for (i = 0; i < p_ptldinf->nservices && services; i++) {
         services[i].p_ldinf = &p_servldinf[i];
         services[i].partition = p_partition;
         services[i].next = NULL;
+#if CONFIG_TFM_SPM_BACKEND_IPC == 1
+        services[i].p_msg_head = NULL;
+        services[i].p_msg_tail = NULL;
+#endif
 
         BACKEND_SERVICE_SET(service_setting, &p_servldinf[i]);
 
@@ -155,7 +165,12 @@ uint32_t load_services_assuredly(struct partition_t *p_partition,
             stateless_services_ref_tbl[hidx] = &services[i];
         }
 
-        UNI_LIST_INSERT_AFTER(services_listhead, &services[i], next);
+        /* Populate the SID-sorted service table */
+        sidx = p_servldinf[i].index;
+        if ((sidx >= CONFIG_TFM_SERVICE_NUM) || sorted_services_tbl[sidx]) {
+            tfm_core_panic();
+        }
+        sorted_services_tbl[sidx] = &services[i];
     }
 
     return service_setting;
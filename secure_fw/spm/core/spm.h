@@ -95,7 +95,9 @@ struct connection_t {
     uint32_t iovec_status;                   /* MM-IOVEC status                */
 #endif
 #if CONFIG_TFM_SPM_BACKEND_IPC == 1
-    struct connection_t *p_handles;          /* Handle(s) link                 */
+    struct connection_t *p_handles;          /* Handle(s) link, or link in the
+                                              * message queue of the service
+                                              */
     uintptr_t reply_value;                   /* Result of this operation, if aynchronous */
 #endif
 };
@@ -110,11 +112,17 @@ struct partition_t {
     volatile uint32_t                  signals_asserted;
 #if CONFIG_TFM_SPM_BACKEND_IPC == 1
     void                               *p_metadata;
+    struct service_t                   *p_services;     /* Service array */
     struct context_ctrl_t              ctx_ctrl;
     struct thread_t                    thrd;            /* IPC model */
     uintptr_t                          reply_value;
 #else
     uint32_t                           state;           /* SFN model */
+#endif
+#if (CONFIG_TFM_SPM_BACKEND_IPC == 1) || \
+    (CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1)
+    struct connection_t                *p_conn_slot;    /* Stateless calls */
+    bool                               conn_slot_busy;
 #endif
     struct connection_t                *p_handles;
     struct partition_t                 *next;
@@ -125,6 +133,10 @@ struct service_t {
     const struct service_load_info_t *p_ldinf;     /* Service load info      */
     struct partition_t *partition;                 /* Owner of the service   */
     struct service_t *next;                        /* For list operation     */
+#if CONFIG_TFM_SPM_BACKEND_IPC == 1
+    struct connection_t *p_msg_head;               /* Oldest queued message  */
+    struct connection_t *p_msg_tail;               /* Newest queued message  */
+#endif
 };
 
 /**
@@ -139,6 +151,19 @@ void spm_init_connection_space(void);
 
 struct connection_t *spm_allocate_connection(void);
 
+/*
+ * Reserve a connection slot for the stateless calls of the given partition,
+ * if the partition has one.
+ */
+void spm_reserve_connection_slot(struct partition_t *p_partition);
+
+/*
+ * Allocate a connection for a stateless call of the given client partition,
+ * from its reserved connection slot if it is free, or from the shared space.
+ */
+struct connection_t *spm_allocate_stateless_connection(
+                                            struct partition_t *p_client);
+
 psa_status_t spm_validate_connection(const struct connection_t *p_connection);
 
 /* Panic if invalid connection is given. */
@@ -148,15 +173,21 @@ void spm_free_connection(struct connection_t *p_connection);
 
 #if CONFIG_TFM_SPM_BACKEND_IPC == 1
 /*
- * Lookup and grab the last spotted handles containing the message
- * by the given signal. Only ONE signal bit can be accepted in 'signal',
- * multiple bits lead to 'no matched handles found to that signal'.
+ * Append the message to the message queue of the given service. The caller
+ * is responsible for asserting the signal of the service.
+ */
+void spm_queue_handle_to_service(struct service_t *service,
+                                 struct connection_t *p_handle);
+
+/*
+ * Grab the oldest message queued for the service of the given signal. Only
+ * ONE signal bit can be accepted in 'signal', multiple bits lead to 'no
+ * matched handles found to that signal'.
  *
  * Returns NULL if no handles matched with the given signal.
  * Returns an internal handle instance if spotted, the instance
- * is moved out of partition handles. Partition available signals
- * also get updated based on the count of handles with given signal
- * still in the partition handles.
+ * is moved out of the service message queue. The signal is cleared from the
+ * partition asserted signals when the queue becomes empty.
  */
 struct connection_t *spm_get_handle_by_signal(struct partition_t *p_ptn,
                                               psa_signal_t signal);
@@ -277,6 +308,16 @@ bool tfm_spm_is_ns_caller(void);
  */
 int32_t tfm_spm_get_client_id(bool ns_caller);
 
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+/**
+ * \brief   Invalidate the client memory ranges cached by psa_call() after
+ *          they were validated. This needs to be called whenever the
+ *          isolation settings of a boundary may have changed, including the
+ *          Non-secure MPU configuration and Non-secure thread privilege.
+ */
+void spm_flush_mem_check_cache(void);
+#endif
+
 /*
  * PendSV specified function.
  *
@@ -15,9 +15,16 @@
 #error "CONFIG_TFM_CONN_HANDLE_MAX_NUM must be defined and not zero."
 #endif
 
+/* Slots reserved for the stateless calls of Partitions and the TZ NS Agent */
+#ifdef CONFIG_TFM_USE_TRUSTZONE
+#define CONN_SLOT_NUM               (CONFIG_TFM_CONN_SLOT_NUM + 1)
+#else
+#define CONN_SLOT_NUM               CONFIG_TFM_CONN_SLOT_NUM
+#endif
+
 /* Pools */
 TFM_POOL_DECLARE(connection_pool, sizeof(struct connection_t),
-                 CONFIG_TFM_CONN_HANDLE_MAX_NUM);
+                 CONFIG_TFM_CONN_HANDLE_MAX_NUM + CONN_SLOT_NUM);
 
 /*********************** Connection handle conversion APIs *******************/
 
@@ -106,7 +113,8 @@ void spm_init_connection_space(void)
     if (tfm_pool_init(connection_pool,
                       POOL_BUFFER_SIZE(connection_pool),
                       sizeof(struct connection_t),
-                      CONFIG_TFM_CONN_HANDLE_MAX_NUM) != PSA_SUCCESS) {
+                      CONFIG_TFM_CONN_HANDLE_MAX_NUM + CONN_SLOT_NUM)
+                      != PSA_SUCCESS) {
         tfm_core_panic();
     }
 }
@@ -117,6 +125,40 @@ struct connection_t *spm_allocate_connection(void)
     return (struct connection_t *)tfm_pool_alloc(connection_pool);
 }
 
+void spm_reserve_connection_slot(struct partition_t *p_partition)
+{
+    p_partition->p_conn_slot = NULL;
+    p_partition->conn_slot_busy = false;
+
+    if (!HAS_CONN_SLOT(p_partition->p_ldinf)) {
+        return;
+    }
+
+    /* The pool has a chunk for each partition with a slot */
+    p_partition->p_conn_slot = spm_allocate_connection();
+    if (!p_partition->p_conn_slot) {
+        tfm_core_panic();
+    }
+}
+
+struct connection_t *spm_allocate_stateless_connection(
+                                            struct partition_t *p_client)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    struct connection_t *p_connection;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+    if (p_client->p_conn_slot && !p_client->conn_slot_busy) {
+        p_client->conn_slot_busy = true;
+        p_connection = p_client->p_conn_slot;
+    } else {
+        p_connection = spm_allocate_connection();
+    }
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    return p_connection;
+}
+
 psa_status_t spm_validate_connection(const struct connection_t *p_connection)
 {
     /* Check the handle address is valid */
@@ -135,7 +177,12 @@ void spm_free_connection(struct connection_t *p_connection)
     SPM_ASSERT(p_connection != NULL);
 
     CRITICAL_SECTION_ENTER(cs_assert);
-    /* Back handle buffer to pool */
-    tfm_pool_free(connection_pool, p_connection);
+    if (p_connection == p_connection->p_client->p_conn_slot) {
+        /* Release the reserved slot of the client */
+        p_connection->p_client->conn_slot_busy = false;
+    } else {
+        /* Back handle buffer to pool */
+        tfm_pool_free(connection_pool, p_connection);
+    }
     CRITICAL_SECTION_LEAVE(cs_assert);
 }
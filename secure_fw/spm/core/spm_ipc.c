@@ -42,55 +42,99 @@
 #include "tfm_nspm.h"
 
 /* Partition and service runtime data list head/runtime data table */
-static struct service_head_t services_listhead;
+static struct service_t *sorted_services_tbl[CONFIG_TFM_SERVICE_NUM];
 struct service_t *stateless_services_ref_tbl[STATIC_HANDLE_NUM_LIMIT];
 
 /* Partition management functions */
 
-/* This API is only used in IPC backend. */
+/* These APIs are only used in IPC backend. */
 #if CONFIG_TFM_SPM_BACKEND_IPC == 1
+void spm_queue_handle_to_service(struct service_t *service,
+                                 struct connection_t *p_handle)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+
+    p_handle->p_handles = NULL;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    if (service->p_msg_tail) {
+        service->p_msg_tail->p_handles = p_handle;
+    } else {
+        service->p_msg_head = p_handle;
+    }
+    service->p_msg_tail = p_handle;
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+}
+
 struct connection_t *spm_get_handle_by_signal(struct partition_t *p_ptn,
                                               psa_signal_t signal)
 {
-    struct connection_t *p_handle_iter;
-    struct connection_t **pr_handle_iter, **last_found_handle_holder = NULL;
+    struct connection_t *p_handle = NULL;
+    struct service_t *service;
     struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
-    uint32_t nr_found_msgs = 0;
+    uint32_t idx, first_idx;
 
-    CRITICAL_SECTION_ENTER(cs_assert);
+    if (!p_ptn->p_services || !IS_ONLY_ONE_BIT_IN_UINT32(signal)) {
+        return NULL;
+    }
 
-    /* Return the last found message which applies a FIFO mechanism. */
-    UNI_LIST_FOREACH_NODE_PNODE(pr_handle_iter, p_handle_iter,
-                                p_ptn, p_handles) {
-        if (p_handle_iter->service->p_ldinf->signal == signal) {
-            last_found_handle_holder = pr_handle_iter;
-            nr_found_msgs++;
-        }
+    /*
+     * The signals of the services of a partition are consecutive bits, in the
+     * order of the services, starting from the signal of the first service.
+     */
+    first_idx = bit_position_of_only_bit_in_uint32(
+                                        p_ptn->p_services[0].p_ldinf->signal);
+    idx = bit_position_of_only_bit_in_uint32(signal);
+    if ((idx < first_idx) || (idx - first_idx >= p_ptn->p_ldinf->nservices)) {
+        return NULL;
     }
 
-    if (last_found_handle_holder) {
-        p_handle_iter = *last_found_handle_holder;
-        UNI_LIST_REMOVE_NODE_BY_PNODE(last_found_handle_holder, p_handles);
+    service = &p_ptn->p_services[idx - first_idx];
+    if (service->p_ldinf->signal != signal) {
+        return NULL;
+    }
+
+    CRITICAL_SECTION_ENTER(cs_assert);
 
-        if (nr_found_msgs == 1) {
+    /* Return the oldest message of the service, which is the queue head. */
+    p_handle = service->p_msg_head;
+    if (p_handle) {
+        service->p_msg_head = p_handle->p_handles;
+        p_handle->p_handles = NULL;
+
+        if (!service->p_msg_head) {
+            service->p_msg_tail = NULL;
             p_ptn->signals_asserted &= ~signal;
         }
     }
 
     CRITICAL_SECTION_LEAVE(cs_assert);
 
-    return p_handle_iter;
+    return p_handle;
 }
 #endif /* CONFIG_TFM_SPM_BACKEND_IPC == 1 */
 
 struct service_t *tfm_spm_get_service_by_sid(uint32_t sid)
 {
-    struct service_t *p_prev, *p_curr;
+    struct service_t *p_curr;
+    uint32_t low = 0, high = CONFIG_TFM_SERVICE_NUM, mid;
+
+    /* Binary search of the services, which are sorted by SID. */
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        p_curr = sorted_services_tbl[mid];
+        if (!p_curr) {
+            return NULL;
+        }
 
-    UNI_LIST_FOREACH_NODE_PREV(p_prev, p_curr, &services_listhead, next) {
         if (p_curr->p_ldinf->sid == sid) {
-            UNI_LIST_MOVE_AFTER(&services_listhead, p_prev, p_curr, next);
             return p_curr;
+        } else if (p_curr->p_ldinf->sid < sid) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
 
@@ -148,8 +192,6 @@ int32_t tfm_spm_check_authorization(uint32_t sid,
                                     bool ns_caller)
 {
     struct partition_t *partition = NULL;
-    const uint32_t *dep;
-    int32_t i;
 
     SPM_ASSERT(service);
 
@@ -163,14 +205,9 @@ int32_t tfm_spm_check_authorization(uint32_t sid,
             tfm_core_panic();
         }
 
-        dep = LOAD_INFO_DEPS(partition->p_ldinf);
-        for (i = 0; i < partition->p_ldinf->ndeps; i++) {
-            if (dep[i] == sid) {
-                break;
-            }
-        }
-
-        if (i == partition->p_ldinf->ndeps) {
+        /* The service must be in the dependencies of the partition. */
+        if (!PARTITION_HAS_DEP(partition->p_ldinf,
+                               service->p_ldinf->index)) {
             return SPM_ERROR_GENERIC;
         }
     }
@@ -306,7 +343,6 @@ uint32_t tfm_spm_init(void)
     spm_init_connection_space();
 
     UNI_LISI_INIT_NODE(PARTITION_LIST_ADDR, next);
-    UNI_LISI_INIT_NODE(&services_listhead, next);
 
     /* Init the nonsecure context. */
     tfm_nspm_ctx_init();
@@ -319,12 +355,15 @@ uint32_t tfm_spm_init(void)
 
         service_setting = load_services_assuredly(
                                 partition,
-                                &services_listhead,
+                                sorted_services_tbl,
+                                sizeof(sorted_services_tbl),
                                 stateless_services_ref_tbl,
                                 sizeof(stateless_services_ref_tbl));
 
         load_irqs_assuredly(partition);
 
+        spm_reserve_connection_slot(partition);
+
         /* Bind the partition with platform. */
         FIH_CALL(tfm_hal_bind_boundary, fih_rc, partition->p_ldinf,
                  &partition->boundary);
@@ -332,6 +371,11 @@ uint32_t tfm_spm_init(void)
             tfm_core_panic();
         }
 
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+        /* No range may stay validated against an earlier binding */
+        spm_flush_mem_check_cache();
+#endif
+
         backend_init_comp_assuredly(partition, service_setting);
     }
 
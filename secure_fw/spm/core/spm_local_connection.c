@@ -6,6 +6,7 @@
  */
 
 #include "compiler_ext_defs.h"
+#include "critical_section.h"
 #include "internal_status_code.h"
 #include "spm.h"
 #include "tfm_arch.h"
@@ -84,6 +85,27 @@ struct connection_t *spm_allocate_connection(void)
     return alloc_conn_from_stack_top();
 }
 
+void spm_reserve_connection_slot(struct partition_t *p_partition)
+{
+    /* Connections are always allocated from the stack of the caller. */
+    (void)p_partition;
+}
+
+struct connection_t *spm_allocate_stateless_connection(
+                                            struct partition_t *p_client)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    struct connection_t *p_connection;
+
+    (void)p_client;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+    p_connection = alloc_conn_from_stack_top();
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    return p_connection;
+}
+
 psa_status_t spm_validate_connection(const struct connection_t *p_connection)
 {
     /* Connection address is always calculated from PSPLIM. No need to validate here. */
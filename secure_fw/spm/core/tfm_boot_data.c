@@ -5,6 +5,7 @@
  *
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include "array.h"
@@ -43,6 +44,42 @@
  */
 static uint32_t is_boot_data_valid = BOOT_DATA_INVALID;
 
+#ifdef BOOT_DATA_AVAILABLE
+/*!
+ * \def BOOT_DATA_INDEX_MAX_RUNS
+ *
+ * \brief Maximum number of indexed runs of consecutive TLV entries with the
+ *        same major type. The bootloader adds the entries of a major type
+ *        together, so one run per major type is expected.
+ */
+#define BOOT_DATA_INDEX_MAX_RUNS (8u)
+
+/*!
+ * \struct boot_data_run
+ *
+ * \brief Location of consecutive TLV entries with the same major type in the
+ *        shared data area.
+ */
+struct boot_data_run {
+    uint8_t  major_type;
+    uint16_t offset;    /* From the beginning of the shared data area */
+    uint16_t len;       /* Including the TLV entry headers */
+};
+
+/*!
+ * \var boot_data_index
+ *
+ * \brief Index of the shared data area built once by
+ *        \ref tfm_core_validate_boot_data, so that the TLV entries of a major
+ *        type can be copied without walking the whole area on each request.
+ */
+static struct {
+    uint32_t run_cnt;
+    bool is_valid;  /* False if the area has more runs than can be indexed */
+    struct boot_data_run runs[BOOT_DATA_INDEX_MAX_RUNS];
+} boot_data_index;
+#endif /* BOOT_DATA_AVAILABLE */
+
 /*!
  * \struct boot_data_access_policy
  *
@@ -122,6 +159,62 @@ static int32_t tfm_core_check_boot_data_access_policy(uint8_t major_type)
 #error "Shared data area and non-secure data area is overlapping"
 #endif
 
+#ifdef BOOT_DATA_AVAILABLE
+/*!
+ * \brief Walk the shared data area once, check that every TLV entry is within
+ *        its boundaries and record the runs of entries with the same major
+ *        type.
+ *
+ * \param[in]  boot_data  The shared data area.
+ *
+ * \return  Returns 0 in case of success, otherwise -1 if the area is
+ *          malformed.
+ */
+static int32_t tfm_core_index_boot_data(const struct tfm_boot_data *boot_data)
+{
+    struct shared_data_tlv_entry tlv_entry;
+    struct boot_data_run *run = NULL;
+    uint32_t offset = SHARED_DATA_HEADER_SIZE;
+    uint32_t tlv_end = boot_data->header.tlv_tot_len;
+    uint32_t next_tlv_offset;
+    uint8_t major_type;
+
+    boot_data_index.run_cnt = 0;
+    boot_data_index.is_valid = true;
+
+    for (; offset < tlv_end; offset += next_tlv_offset) {
+        if ((tlv_end - offset) < SHARED_DATA_ENTRY_HEADER_SIZE) {
+            return -1;
+        }
+
+        /* Create local copy to avoid unaligned access */
+        (void)spm_memcpy(&tlv_entry, (const uint8_t *)boot_data + offset,
+                         SHARED_DATA_ENTRY_HEADER_SIZE);
+
+        next_tlv_offset = SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+        if (next_tlv_offset > (tlv_end - offset)) {
+            return -1;
+        }
+
+        major_type = (uint8_t)GET_MAJOR(tlv_entry.tlv_type);
+        if ((run != NULL) && (run->major_type == major_type)) {
+            run->len += (uint16_t)next_tlv_offset;
+        } else if (boot_data_index.run_cnt < BOOT_DATA_INDEX_MAX_RUNS) {
+            run = &boot_data_index.runs[boot_data_index.run_cnt++];
+            run->major_type = major_type;
+            run->offset = (uint16_t)offset;
+            run->len = (uint16_t)next_tlv_offset;
+        } else {
+            /* Keep checking the entries, lookups walk the area instead */
+            boot_data_index.is_valid = false;
+            run = NULL;
+        }
+    }
+
+    return 0;
+}
+#endif /* BOOT_DATA_AVAILABLE */
+
 void tfm_core_validate_boot_data(void)
 {
 #ifdef BOOT_DATA_AVAILABLE
@@ -129,7 +222,11 @@ void tfm_core_validate_boot_data(void)
 
     boot_data = (struct tfm_boot_data *)BOOT_TFM_SHARED_DATA_BASE;
 
-    if (boot_data->header.tlv_magic == SHARED_DATA_TLV_INFO_MAGIC) {
+    if (boot_data->header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
+        return;
+    }
+
+    if (tfm_core_index_boot_data(boot_data) == 0) {
         is_boot_data_valid = BOOT_DATA_VALID;
     }
 #else
@@ -146,8 +243,10 @@ void tfm_core_get_boot_data_handler(uint32_t args[])
 #ifdef BOOT_DATA_AVAILABLE
     uint8_t *ptr;
     struct shared_data_tlv_entry tlv_entry;
+    const struct boot_data_run *run;
     uintptr_t tlv_end, offset;
     size_t next_tlv_offset;
+    uint32_t i;
 #endif /* BOOT_DATA_AVAILABLE */
     struct partition_t *curr_partition = GET_CURRENT_COMPONENT();
     fih_int fih_rc = FIH_FAILURE;
@@ -190,6 +289,35 @@ void tfm_core_get_boot_data_handler(uint32_t args[])
 
 #ifdef BOOT_DATA_AVAILABLE
     ptr = boot_data->data;
+
+    if (boot_data_index.is_valid) {
+        /* Copy the indexed runs of TLVs with requested major type to the
+         * provided buffer.
+         */
+        for (i = 0; i < boot_data_index.run_cnt; i++) {
+            run = &boot_data_index.runs[i];
+            if (run->major_type != tlv_major) {
+                continue;
+            }
+
+            /* Check buffer overflow */
+            if (((ptr - buf_start) + run->len) > buf_size) {
+                args[0] = (uint32_t)PSA_ERROR_INVALID_ARGUMENT;
+                return;
+            }
+
+            (void)spm_memcpy(ptr,
+                             (const void *)(BOOT_TFM_SHARED_DATA_BASE +
+                                            run->offset),
+                             run->len);
+            ptr += run->len;
+            boot_data->header.tlv_tot_len += run->len;
+        }
+
+        args[0] = (uint32_t)PSA_SUCCESS;
+        return;
+    }
+
     /* Iterates over the TLV section and copy TLVs with requested major
      * type to the provided buffer.
      */
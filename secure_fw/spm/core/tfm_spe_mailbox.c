@@ -14,6 +14,7 @@
 
 #include "async.h"
 #include "config_impl.h"
+#include "critical_section.h"
 #include "psa/error.h"
 #include "utilities.h"
 #include "tfm_arch.h"
@@ -22,6 +23,35 @@
 #include "tfm_rpc.h"
 #include "tfm_multi_core.h"
 
+#if CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM < 1
+#error "CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM must be at least 1"
+#endif
+
+#if CONFIG_TFM_MAILBOX_REPLY_TIMEOUT < 0
+#error "CONFIG_TFM_MAILBOX_REPLY_TIMEOUT must not be negative"
+#endif
+
+#if !TFM_MAILBOX_RING
+/* All the SPE mailbox queue slots are empty */
+#define SPE_QUEUE_ALL_EMPTY                                               \
+            ((mailbox_queue_status_t)((1UL << (NUM_MAILBOX_QUEUE_SLOT - 1)) \
+                                      - 1 +                              \
+                                      (1UL << (NUM_MAILBOX_QUEUE_SLOT - 1))))
+#endif
+
+#if TFM_MAILBOX_RING
+/*
+ * NSPE and SPE exchange the slot indices via lock-free rings. The remaining
+ * SPE mailbox states are only accessed locally.
+ */
+static struct critical_section_t mailbox_cs = CRITICAL_SECTION_STATIC_INIT;
+
+#define mailbox_enter_critical()        CRITICAL_SECTION_ENTER(mailbox_cs)
+#define mailbox_exit_critical()         CRITICAL_SECTION_LEAVE(mailbox_cs)
+#else
+#define mailbox_enter_critical()        tfm_mailbox_hal_enter_critical()
+#define mailbox_exit_critical()         tfm_mailbox_hal_exit_critical()
+#endif
 
 static struct secure_mailbox_queue_t spe_mailbox_queue;
 
@@ -35,10 +65,37 @@ struct vectors {
     psa_outvec *original_out_vec;
     size_t out_len;
     bool in_use;
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    bool is_inline;
+    uint8_t payload[TFM_MAILBOX_INLINE_PAYLOAD_SIZE];
+#endif
 };
 static struct vectors vectors[NUM_MAILBOX_QUEUE_SLOT] = {0};
 
+#if TFM_MAILBOX_RING
+__STATIC_INLINE void set_spe_queue_empty_status(uint8_t idx)
+{
+    if (idx < NUM_MAILBOX_QUEUE_SLOT) {
+        spe_mailbox_queue.busy_slots[idx] = false;
+    }
+}
+
+__STATIC_INLINE void clear_spe_queue_empty_status(uint8_t idx)
+{
+    if (idx < NUM_MAILBOX_QUEUE_SLOT) {
+        spe_mailbox_queue.busy_slots[idx] = true;
+    }
+}
 
+__STATIC_INLINE bool get_spe_queue_empty_status(uint8_t idx)
+{
+    if ((idx < NUM_MAILBOX_QUEUE_SLOT) && !spe_mailbox_queue.busy_slots[idx]) {
+        return true;
+    }
+
+    return false;
+}
+#else /* TFM_MAILBOX_RING */
 __STATIC_INLINE void set_spe_queue_empty_status(uint8_t idx)
 {
     if (idx < NUM_MAILBOX_QUEUE_SLOT) {
@@ -82,6 +139,7 @@ __STATIC_INLINE void clear_nspe_queue_pend_status(
 {
     ns_queue->pend_slots &= ~mask;
 }
+#endif /* TFM_MAILBOX_RING */
 
 __STATIC_INLINE int32_t get_spe_mailbox_msg_handle(uint8_t idx,
                                                    mailbox_msg_handle_t *handle)
@@ -131,10 +189,89 @@ __STATIC_INLINE struct mailbox_reply_t *get_nspe_reply_addr(uint8_t idx)
     return &spe_mailbox_queue.ns_queue->queue[ns_slot_idx].reply;
 }
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * Copies the inline input data of the mailbox message in slot idx into SPE and
+ * sets up the local vectors over the local payload copy.
+ */
+static int32_t mailbox_get_inline_vectors(uint8_t idx)
+{
+    const struct mailbox_msg_t *msg_ptr = &spe_mailbox_queue.queue[idx].msg;
+    const struct ns_mailbox_slot_t *ns_slot;
+    size_t in_len = msg_ptr->params.psa_call_inline_params.in_len;
+    size_t out_len = msg_ptr->params.psa_call_inline_params.out_len;
+    size_t in_size = 0, payload_size = 0, len;
+    size_t i;
+
+    if (in_len + out_len > PSA_MAX_IOVEC) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    spm_memset(vectors[idx].in_vec, 0, sizeof(vectors[idx].in_vec));
+    spm_memset(vectors[idx].out_vec, 0, sizeof(vectors[idx].out_vec));
+
+    for (i = 0; i < in_len + out_len; i++) {
+        len = msg_ptr->params.psa_call_inline_params.io_size[i];
+        if (len > TFM_MAILBOX_INLINE_PAYLOAD_SIZE - payload_size) {
+            return MAILBOX_INVAL_PARAMS;
+        }
+
+        if (i < in_len) {
+            vectors[idx].in_vec[i].base = vectors[idx].payload + payload_size;
+            vectors[idx].in_vec[i].len = len;
+            in_size += len;
+        } else {
+            vectors[idx].out_vec[i - in_len].base =
+                                        vectors[idx].payload + payload_size;
+            vectors[idx].out_vec[i - in_len].len = len;
+        }
+
+        payload_size += len;
+    }
+
+    /* Only the input data is fetched from NSPE */
+    ns_slot = &spe_mailbox_queue.ns_queue->queue[
+                                        spe_mailbox_queue.queue[idx].ns_slot_idx];
+    spm_memcpy(vectors[idx].payload, ns_slot->payload, in_size);
+
+    vectors[idx].out_len = out_len;
+    vectors[idx].is_inline = true;
+
+    return MAILBOX_SUCCESS;
+}
+
+/*
+ * Copies the output data and lengths of the inline mailbox message in slot idx
+ * back into NSPE mailbox queue slot.
+ */
+static void mailbox_put_inline_outvecs(uint8_t idx)
+{
+    const struct mailbox_msg_t *msg_ptr = &spe_mailbox_queue.queue[idx].msg;
+    struct ns_mailbox_slot_t *ns_slot;
+    size_t in_len = msg_ptr->params.psa_call_inline_params.in_len;
+    size_t offset;
+    size_t i;
+
+    ns_slot = &spe_mailbox_queue.ns_queue->queue[
+                                        spe_mailbox_queue.queue[idx].ns_slot_idx];
+
+    for (i = 0; i < vectors[idx].out_len; i++) {
+        offset = (uint8_t *)vectors[idx].out_vec[i].base - vectors[idx].payload;
+        spm_memcpy(ns_slot->payload + offset, vectors[idx].out_vec[i].base,
+                   vectors[idx].out_vec[i].len);
+        ns_slot->msg.params.psa_call_inline_params.io_size[in_len + i] =
+                                    (uint16_t)vectors[idx].out_vec[i].len;
+    }
+}
+#endif /* TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0 */
+
 static void mailbox_direct_reply(uint8_t idx, uint32_t result)
 {
     struct mailbox_reply_t *reply_ptr;
     uint32_t ret_result = result;
+#if TFM_MAILBOX_RING
+    uint8_t ns_slot_idx;
+#endif
 
     /* Copy outvec lengths back if necessary */
     if (vectors[idx].in_use) {
@@ -144,13 +281,38 @@ static void mailbox_direct_reply(uint8_t idx, uint32_t result)
         vectors[idx].in_use = false;
     }
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* Copy inline output data and lengths back if necessary */
+    if (vectors[idx].is_inline) {
+        mailbox_put_inline_outvecs(idx);
+        vectors[idx].is_inline = false;
+    }
+#endif
+
     /* Get reply address */
     reply_ptr = get_nspe_reply_addr(idx);
     spm_memcpy(&reply_ptr->return_val, &ret_result,
                sizeof(reply_ptr->return_val));
 
+#if TFM_MAILBOX_RING
+    ns_slot_idx = spe_mailbox_queue.queue[idx].ns_slot_idx;
+#endif
+
     mailbox_clean_queue_slot(idx);
 
+#if TFM_MAILBOX_RING
+    /*
+     * Publish the reply to NSPE right away. SPE is the only producer of the
+     * reply ring. Only the local accesses are serialized.
+     * The SPE slot is released first, so that it is free again by the time
+     * NSPE sees the reply and submits a new request for the same NS slot.
+     */
+    mailbox_enter_critical();
+    (void)mailbox_ring_push(&spe_mailbox_queue.ns_queue->reply_ring,
+                            ns_slot_idx);
+    mailbox_exit_critical();
+#endif
+
     /*
      * Skip NSPE queue status update after single reply.
      * Update NSPE queue status after all the mailbox messages are completed
@@ -169,11 +331,11 @@ __STATIC_INLINE int32_t check_mailbox_msg(const struct mailbox_msg_t *msg)
 
 /* Passes the request from the mailbox message into SPM.
  * idx indicates the slot used to use for any immediate reply.
- * If it queues the reply immediately, updates reply_slots accordingly.
+ * If it queues the reply immediately, sets is_replied accordingly.
  */
 static int32_t tfm_mailbox_dispatch(const struct mailbox_msg_t *msg_ptr,
                                     uint8_t idx,
-                                    mailbox_queue_status_t *reply_slots)
+                                    bool *is_replied)
 {
     const struct psa_client_params_t *params = &msg_ptr->params;
     struct client_call_params_t spm_params = {0};
@@ -232,6 +394,29 @@ static int32_t tfm_mailbox_dispatch(const struct mailbox_msg_t *msg_ptr,
         }
         break;
 
+#if TFM_MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    case MAILBOX_PSA_CALL_INLINE:
+        /* The vectors are local copies and need no further validation */
+        if (mailbox_get_inline_vectors(idx) != MAILBOX_SUCCESS) {
+            psa_ret = PSA_ERROR_PROGRAMMER_ERROR;
+            sync = true;
+            break;
+        }
+        spm_params.handle = params->psa_call_inline_params.handle;
+        spm_params.type = params->psa_call_inline_params.type;
+        spm_params.in_vec = vectors[idx].in_vec;
+        spm_params.in_len = params->psa_call_inline_params.in_len;
+        spm_params.out_vec = vectors[idx].out_vec;
+        spm_params.out_len = params->psa_call_inline_params.out_len;
+        spm_params.ns_client_id = msg_ptr->client_id;
+        spm_params.client_data = NULL;
+        psa_ret = tfm_rpc_psa_call(&spm_params);
+        if (psa_ret != PSA_SUCCESS) {
+            sync = true;
+        }
+        break;
+#endif
+
 /* Following cases are only needed by connection-based services */
 #if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
     case MAILBOX_PSA_CONNECT:
@@ -257,19 +442,109 @@ static int32_t tfm_mailbox_dispatch(const struct mailbox_msg_t *msg_ptr,
 
     /* Any synchronous result should be returned immediately */
     if (sync) {
-        *reply_slots |= (1 << idx);
+        *is_replied = true;
         mailbox_direct_reply(idx, (uint32_t)psa_ret);
     }
 
     return MAILBOX_SUCCESS;
 }
 
+/*
+ * Fetches the mailbox message in NSPE queue slot idx and passes it into SPM.
+ * Returns true if the message is replied immediately.
+ */
+static bool mailbox_handle_slot(const struct ns_mailbox_queue_t *ns_queue,
+                                uint8_t idx)
+{
+    struct mailbox_msg_t *msg_ptr;
+    bool is_replied = false;
+
+    /*
+     * TODO
+     * The operations are simplified here. Use the SPE mailbox queue
+     * slot with the same idx as that of the NSPE mailbox queue slot.
+     * A more general implementation should dynamically search and
+     * select an empty SPE mailbox queue slot.
+     */
+    clear_spe_queue_empty_status(idx);
+    spe_mailbox_queue.queue[idx].ns_slot_idx = idx;
+
+    msg_ptr = &spe_mailbox_queue.queue[idx].msg;
+    spm_memcpy(msg_ptr, &ns_queue->queue[idx].msg, sizeof(*msg_ptr));
+
+    if (check_mailbox_msg(msg_ptr) != MAILBOX_SUCCESS) {
+        mailbox_clean_queue_slot(idx);
+        return false;
+    }
+
+    get_spe_mailbox_msg_handle(idx,
+                               &spe_mailbox_queue.queue[idx].msg_handle);
+
+    /*
+     * Set the current slot index under processing.
+     * The value is used in mailbox_get_caller_data() to identify the
+     * mailbox queue slot.
+     */
+    spe_mailbox_queue.cur_proc_slot_idx = idx;
+
+    if (tfm_mailbox_dispatch(msg_ptr, idx, &is_replied) != MAILBOX_SUCCESS) {
+        mailbox_clean_queue_slot(idx);
+        return false;
+    }
+
+    /* Clean up the current slot index under processing */
+    spe_mailbox_queue.cur_proc_slot_idx = NUM_MAILBOX_QUEUE_SLOT;
+
+    return is_replied;
+}
+
+#if TFM_MAILBOX_RING
+int32_t tfm_mailbox_handle_msg(void)
+{
+    uint8_t idx;
+    bool is_pended = false, is_replied = false;
+    struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
+
+    SPM_ASSERT(ns_queue != NULL);
+
+    /* SPE is the only consumer of the request ring */
+    while (mailbox_ring_pop(&ns_queue->req_ring, &idx)) {
+        is_pended = true;
+
+        /* Drop an invalid index or a slot already under processing */
+        if (!get_spe_queue_empty_status(idx)) {
+            continue;
+        }
+
+        if (mailbox_handle_slot(ns_queue, idx)) {
+            is_replied = true;
+        }
+    }
+
+    /* Check if NSPE mailbox did assert a PSA client call request */
+    if (!is_pended) {
+        return MAILBOX_NO_PEND_EVENT;
+    }
+
+    if (!is_replied) {
+        return MAILBOX_SUCCESS;
+    }
+
+    /* The notification also covers the deferred replies */
+    mailbox_enter_critical();
+    spe_mailbox_queue.nr_unnotified_replies = 0;
+    mailbox_exit_critical();
+
+    tfm_mailbox_hal_notify_peer();
+
+    return MAILBOX_SUCCESS;
+}
+#else /* TFM_MAILBOX_RING */
 int32_t tfm_mailbox_handle_msg(void)
 {
     uint8_t idx;
     mailbox_queue_status_t mask_bits, pend_slots, reply_slots = 0;
     struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
-    struct mailbox_msg_t *msg_ptr;
 
     SPM_ASSERT(ns_queue != NULL);
 
@@ -291,41 +566,9 @@ int32_t tfm_mailbox_handle_msg(void)
             continue;
         }
 
-        /*
-         * TODO
-         * The operations are simplified here. Use the SPE mailbox queue
-         * slot with the same idx as that of the NSPE mailbox queue slot.
-         * A more general implementation should dynamically search and
-         * select an empty SPE mailbox queue slot.
-         */
-        clear_spe_queue_empty_status(idx);
-        spe_mailbox_queue.queue[idx].ns_slot_idx = idx;
-
-        msg_ptr = &spe_mailbox_queue.queue[idx].msg;
-        spm_memcpy(msg_ptr, &ns_queue->queue[idx].msg, sizeof(*msg_ptr));
-
-        if (check_mailbox_msg(msg_ptr) != MAILBOX_SUCCESS) {
-            mailbox_clean_queue_slot(idx);
-            continue;
-        }
-
-        get_spe_mailbox_msg_handle(idx,
-                                   &spe_mailbox_queue.queue[idx].msg_handle);
-
-        /*
-         * Set the current slot index under processing.
-         * The value is used in mailbox_get_caller_data() to identify the
-         * mailbox queue slot.
-         */
-        spe_mailbox_queue.cur_proc_slot_idx = idx;
-
-        if (tfm_mailbox_dispatch(msg_ptr, idx, &reply_slots) != MAILBOX_SUCCESS) {
-            mailbox_clean_queue_slot(idx);
-            continue;
+        if (mailbox_handle_slot(ns_queue, idx)) {
+            reply_slots |= mask_bits;
         }
-
-        /* Clean up the current slot index under processing */
-        spe_mailbox_queue.cur_proc_slot_idx = NUM_MAILBOX_QUEUE_SLOT;
     }
 
     tfm_mailbox_hal_enter_critical();
@@ -336,6 +579,11 @@ int32_t tfm_mailbox_handle_msg(void)
     /* Set the NSPE mailbox replied status */
     set_nspe_queue_replied_status(ns_queue, reply_slots);
 
+    /* The notification also covers the deferred replies */
+    if (reply_slots) {
+        spe_mailbox_queue.nr_unnotified_replies = 0;
+    }
+
     tfm_mailbox_hal_exit_critical();
 
     if (reply_slots) {
@@ -344,11 +592,16 @@ int32_t tfm_mailbox_handle_msg(void)
 
     return MAILBOX_SUCCESS;
 }
+#endif /* TFM_MAILBOX_RING */
 
 int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply)
 {
     uint8_t idx;
     int32_t ret;
+    bool is_reply_waiting = false;
+#if CONFIG_TFM_MAILBOX_REPLY_TIMEOUT > 0
+    uint32_t now;
+#endif
     struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
 
     SPM_ASSERT(ns_queue != NULL);
@@ -374,12 +627,56 @@ int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply)
 
     mailbox_direct_reply(idx, (uint32_t)reply);
 
-    tfm_mailbox_hal_enter_critical();
+    /*
+     * Check whether the reply of another message is already waiting to be
+     * handled by this agent. psa_wait() is an SVC, so it must not be called
+     * inside the mailbox critical section.
+     */
+#if CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM > 1
+    is_reply_waiting = (psa_wait(ASYNC_MSG_REPLY, PSA_POLL) &
+                        ASYNC_MSG_REPLY) != 0;
+#endif
+
+#if CONFIG_TFM_MAILBOX_REPLY_TIMEOUT > 0
+    now = tfm_mailbox_hal_get_timestamp();
+#endif
 
+    mailbox_enter_critical();
+
+#if TFM_MAILBOX_RING
+    /* The reply is already published in the reply ring */
+    (void)ns_queue;
+#else
     /* Set the NSPE mailbox replied status */
     set_nspe_queue_replied_status(ns_queue, (1 << idx));
+#endif
+
+#if CONFIG_TFM_MAILBOX_REPLY_TIMEOUT > 0
+    /* Stop deferring once the oldest deferred reply has timed out */
+    if (spe_mailbox_queue.nr_unnotified_replies == 0) {
+        spe_mailbox_queue.first_unnotified_time = now;
+    } else if ((uint32_t)(now - spe_mailbox_queue.first_unnotified_time) >=
+               CONFIG_TFM_MAILBOX_REPLY_TIMEOUT) {
+        is_reply_waiting = false;
+    }
+#endif
 
-    tfm_mailbox_hal_exit_critical();
+    /*
+     * Defer the notification until enough replies are batched, but only
+     * while the reply of another message is already waiting to be handled
+     * by this agent. The last reply of a burst is always notified, so a
+     * reply is never held back waiting for a message still in progress.
+     */
+    spe_mailbox_queue.nr_unnotified_replies++;
+    if ((spe_mailbox_queue.nr_unnotified_replies <
+         CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM) && is_reply_waiting) {
+        mailbox_exit_critical();
+        return MAILBOX_SUCCESS;
+    }
+
+    spe_mailbox_queue.nr_unnotified_replies = 0;
+
+    mailbox_exit_critical();
 
     tfm_mailbox_hal_notify_peer();
 
@@ -433,10 +730,9 @@ int32_t tfm_mailbox_init(void)
 
     spm_memset(&spe_mailbox_queue, 0, sizeof(spe_mailbox_queue));
 
-    spe_mailbox_queue.empty_slots =
-            (mailbox_queue_status_t)((1UL << (NUM_MAILBOX_QUEUE_SLOT - 1)) - 1);
-    spe_mailbox_queue.empty_slots +=
-            (mailbox_queue_status_t)(1UL << (NUM_MAILBOX_QUEUE_SLOT - 1));
+#if !TFM_MAILBOX_RING
+    spe_mailbox_queue.empty_slots = SPE_QUEUE_ALL_EMPTY;
+#endif
 
     /* Register RPC callbacks */
     ret = tfm_rpc_register_ops(&mailbox_rpc_ops);
@@ -24,7 +24,12 @@ struct secure_mailbox_slot_t {
 };
 
 struct secure_mailbox_queue_t {
+#if TFM_MAILBOX_RING
+    bool                         busy_slots[NUM_MAILBOX_QUEUE_SLOT];
+                                                   /* slots in use */
+#else
     mailbox_queue_status_t       empty_slots;      /* bitmask of empty slots */
+#endif
 
     struct secure_mailbox_slot_t queue[NUM_MAILBOX_QUEUE_SLOT];
     struct ns_mailbox_queue_t    *ns_queue;
@@ -33,6 +38,16 @@ struct secure_mailbox_queue_t {
                                                      * queue slot currently
                                                      * under processing.
                                                      */
+    uint8_t                      nr_unnotified_replies; /*
+                                                         * The number of
+                                                         * replies not yet
+                                                         * notified to NSPE.
+                                                         */
+    uint32_t                     first_unnotified_time; /*
+                                                         * The time of the
+                                                         * oldest reply not
+                                                         * yet notified.
+                                                         */
 };
 
 /**
@@ -82,6 +97,15 @@ int32_t tfm_mailbox_hal_init(struct secure_mailbox_queue_t *s_queue);
  */
 int32_t tfm_mailbox_hal_notify_peer(void);
 
+/**
+ * \brief Get the time of a free-running platform timer, in the unit of
+ *        CONFIG_TFM_MAILBOX_REPLY_TIMEOUT. It is only required when
+ *        CONFIG_TFM_MAILBOX_REPLY_TIMEOUT is not 0.
+ *
+ * \return The current time, which wraps around after UINT32_MAX.
+ */
+uint32_t tfm_mailbox_hal_get_timestamp(void);
+
 /**
  * \brief Enter critical section of NSPE mailbox
  */
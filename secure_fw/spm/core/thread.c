@@ -8,6 +8,7 @@
  *
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "thread.h"
 #include "tfm_arch.h"
@@ -17,13 +18,27 @@
 /* Declaration of current thread pointer. */
 struct thread_t *p_curr_thrd;
 
+/*
+ * Runnable threads are kept in one list per group of 8 consecutive priority
+ * values, sorted by priority in each list. Bit (31 - group) of the bitmap is
+ * set when the list of the group is not empty, so that the highest priority
+ * group with runnable threads is given by the count of leading zeros.
+ */
+#define RNBL_GROUP_NUM              32
+#define RNBL_GROUP(prior)           ((uint32_t)(prior) >> 3)
+#define RNBL_GROUP_BIT(group)       (1UL << (RNBL_GROUP_NUM - 1 - (group)))
+
 /* Force ZERO in case ZI(bss) clear is missing. */
-static struct thread_t *p_thrd_head = NULL; /* Point to the first thread. */
-static struct thread_t *p_rnbl_head = NULL; /* Point to the first runnable. */
+static struct thread_t *rnbl_heads[RNBL_GROUP_NUM] = {NULL};
+static uint32_t rnbl_bitmap = 0;
 
 /* Define Macro to fetch global to support future expansion (PERCPU e.g.) */
-#define LIST_HEAD   p_thrd_head
-#define RNBL_HEAD   p_rnbl_head
+#define RNBL_HEADS  rnbl_heads
+#define RNBL_BITMAP rnbl_bitmap
+
+/* Threads in these states are in the runnable lists. */
+#define THRD_IS_RUNNABLE(state)     (((state) == THRD_STATE_RUNNABLE) || \
+                                     ((state) == THRD_STATE_RET_VAL_AVAIL))
 
 /* Callback function pointer for thread to query current state. */
 static thrd_query_state_t query_state_cb = (thrd_query_state_t)NULL;
@@ -33,84 +48,116 @@ void thrd_set_query_callback(thrd_query_state_t fn)
     query_state_cb = fn;
 }
 
+/*
+ * Add a thread to the runnable list of its priority group, after the threads
+ * of higher or equal priority.
+ */
+static void rnbl_insert(struct thread_t *p_thrd)
+{
+    uint32_t group = RNBL_GROUP(p_thrd->priority);
+    struct thread_t **pp_iter = &RNBL_HEADS[group];
+
+    while (*pp_iter && ((*pp_iter)->priority <= p_thrd->priority)) {
+        pp_iter = &(*pp_iter)->next;
+    }
+
+    p_thrd->next = *pp_iter;
+    *pp_iter = p_thrd;
+
+    RNBL_BITMAP |= RNBL_GROUP_BIT(group);
+}
+
+/* Remove a thread from the runnable list of its priority group. */
+static void rnbl_remove(struct thread_t *p_thrd)
+{
+    uint32_t group = RNBL_GROUP(p_thrd->priority);
+    struct thread_t **pp_iter = &RNBL_HEADS[group];
+
+    while (*pp_iter && (*pp_iter != p_thrd)) {
+        pp_iter = &(*pp_iter)->next;
+    }
+
+    SPM_ASSERT(*pp_iter == p_thrd);
+
+    *pp_iter = p_thrd->next;
+    p_thrd->next = NULL;
+
+    if (RNBL_HEADS[group] == NULL) {
+        RNBL_BITMAP &= ~RNBL_GROUP_BIT(group);
+    }
+}
+
+/* Update thread state, and move it in or out of the runnable lists. */
+static void update_state(struct thread_t *p_thrd, uint32_t new_state)
+{
+    bool was_runnable = THRD_IS_RUNNABLE(p_thrd->state);
+    bool is_runnable = THRD_IS_RUNNABLE(new_state);
+
+    p_thrd->state = (uint8_t)new_state;
+
+    if (was_runnable && !is_runnable) {
+        rnbl_remove(p_thrd);
+    } else if (!was_runnable && is_runnable) {
+        rnbl_insert(p_thrd);
+    }
+}
+
 struct thread_t *thrd_next(void)
 {
-    struct thread_t *p_thrd = RNBL_HEAD;
+    struct thread_t *p_thrd = NULL;
     uint32_t retval = 0;
+    uint32_t state;
     struct critical_section_t cs_signal = CRITICAL_SECTION_STATIC_INIT;
 
     CRITICAL_SECTION_ENTER(cs_signal);
     /*
-     * First runnable thread has highest priority since threads are
-     * sorted by priority.
+     * The first thread of the highest priority group with runnable threads
+     * has the highest priority since the runnable lists are sorted by
+     * priority.
      */
-    while (p_thrd) {
-        /* Change thread state if any signal changed */
-        p_thrd->state = query_state_cb(p_thrd, &retval);
+    while (RNBL_BITMAP) {
+        p_thrd = RNBL_HEADS[__CLZ(RNBL_BITMAP)];
 
-        if (p_thrd->state == THRD_STATE_RET_VAL_AVAIL) {
-            tfm_arch_set_context_ret_code(p_thrd->p_context_ctrl, retval);
-            p_thrd->state = THRD_STATE_RUNNABLE;
+        if (p_thrd->state != THRD_STATE_RET_VAL_AVAIL) {
+            break;
         }
 
-        if (p_thrd->state == THRD_STATE_RUNNABLE) {
+        /* Fetch the return value of the thread which has been woken up */
+        state = query_state_cb(p_thrd, &retval);
+        if (state == THRD_STATE_RET_VAL_AVAIL) {
+            tfm_arch_set_context_ret_code(p_thrd->p_context_ctrl, retval);
+            p_thrd->state = THRD_STATE_RUNNABLE;
             break;
         }
 
-        p_thrd = p_thrd->next;
+        update_state(p_thrd, state);
+        p_thrd = NULL;
     }
     CRITICAL_SECTION_LEAVE(cs_signal);
 
     return p_thrd;
 }
 
-static void insert_by_prior(struct thread_t **head, struct thread_t *node)
-{
-    if (*head == NULL || (node->priority <= (*head)->priority)) {
-        node->next = *head;
-        *head = node;
-    } else {
-        struct thread_t *iter = *head;
-
-        while (iter->next && (node->priority > iter->next->priority)) {
-            iter = iter->next;
-        }
-
-        node->next = iter->next;
-        iter->next = node;
-    }
-}
-
 void thrd_start(struct thread_t *p_thrd, thrd_fn_t fn, thrd_fn_t exit_fn, void *param)
 {
     SPM_ASSERT(p_thrd != NULL);
 
-    /* Insert a new thread with priority */
-    insert_by_prior(&LIST_HEAD, p_thrd);
-
     tfm_arch_init_context(p_thrd->p_context_ctrl, (uintptr_t)fn, param,
                           (uintptr_t)exit_fn);
 
-    /* Mark it as RUNNABLE after insertion */
+    /* Mark it as RUNNABLE, which inserts it with priority */
     thrd_set_state(p_thrd, THRD_STATE_RUNNABLE);
 }
 
 void thrd_set_state(struct thread_t *p_thrd, uint32_t new_state)
 {
-    SPM_ASSERT(p_thrd != NULL);
+    struct critical_section_t cs_signal = CRITICAL_SECTION_STATIC_INIT;
 
-    p_thrd->state = new_state;
+    SPM_ASSERT(p_thrd != NULL);
 
-    /*
-     * Set first runnable thread as head to reduce enumerate
-     * depth while searching for a first runnable thread.
-     */
-    if ((p_thrd->state == THRD_STATE_RUNNABLE) &&
-        ((RNBL_HEAD == NULL) || (p_thrd->priority < RNBL_HEAD->priority))) {
-        RNBL_HEAD = p_thrd;
-    } else {
-        RNBL_HEAD = LIST_HEAD;
-    }
+    CRITICAL_SECTION_ENTER(cs_signal);
+    update_state(p_thrd, new_state);
+    CRITICAL_SECTION_LEAVE(cs_signal);
 }
 
 uint32_t thrd_start_scheduler(struct thread_t **ppth)
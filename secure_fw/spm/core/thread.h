@@ -45,10 +45,14 @@ struct thread_t {
     uint8_t         state;              /* State                             */
     uint16_t        flags;              /* Flags and align, DO NOT REMOVE!   */
     void            *p_context_ctrl;    /* Context control (sp, splimit, lr) */
-    struct thread_t *next;              /* Next thread in list               */
+    struct thread_t *next;              /* Next thread in runnable list      */
 };
 
-/* Query thread state function type */
+/*
+ * Query thread state function type. It is called for a runnable thread in
+ * THRD_STATE_RET_VAL_AVAIL state before it is scheduled, to get its return
+ * value.
+ */
 typedef uint32_t (*thrd_query_state_t)(struct thread_t *p_thrd,
                                        uint32_t *p_retval);
 /*
@@ -81,7 +85,8 @@ extern struct thread_t *p_curr_thrd;
  *  priority       -     Priority value (0~255)
  *
  * Note :
- *  The new priority may not take effect immediately.
+ *  The thread must not be runnable, as the runnable lists are sorted by
+ *  priority.
  */
 #define THRD_SET_PRIORITY(p_thrd, priority) \
                                         p_thrd->priority = (uint8_t)(priority)
@@ -104,7 +109,9 @@ extern struct thread_t *p_curr_thrd;
 void thrd_set_query_callback(thrd_query_state_t fn);
 
 /*
- * Set thread state, and updates the runnable head.
+ * Set thread state, and adds it to or removes it from the runnable lists.
+ * Threads in THRD_STATE_RUNNABLE and THRD_STATE_RET_VAL_AVAIL states are
+ * runnable.
  *
  * Parameters :
  *  p_thrd         -     Pointer of thread_t struct
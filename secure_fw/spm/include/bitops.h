@@ -8,8 +8,19 @@
 #define __BITOPS_H__
 
 #include <stdint.h>
+#include "cmsis_compiler.h"
 
 /* Check if there is only one bit availiable in a 32bit number */
 #define IS_ONLY_ONE_BIT_IN_UINT32(n)                          \
                   ((uint32_t)(n) && !((uint32_t)(n) & ((uint32_t)(n)-1)))
+
+/*
+ * Get the position of the only bit set in a 32bit number. The result is
+ * undefined if more than one bit is set.
+ */
+static inline uint32_t bit_position_of_only_bit_in_uint32(uint32_t n)
+{
+    return 31U - __CLZ(n);
+}
+
 #endif /* __BITOPS_H__ */
@@ -13,6 +13,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "config_impl.h"
 
 /* TF-M internal partition ID */
 #define TFM_SP_IDLE_ID                          (1)
@@ -26,10 +27,10 @@
 /*
  * Partition flag start
  *
- * 31      12 11 10  9   8  7         0
- * +---------+--+--+---+---+----------+
- * | RES[20] |TZ|MB|I/S|A/P| Priority |
- * +---------+--+--+---+---+----------+
+ * 31      13 12 11 10  9   8  7         0
+ * +---------+--+--+--+---+---+----------+
+ * | RES[19] |CS|TZ|MB|I/S|A/P| Priority |
+ * +---------+--+--+--+---+---+----------+
  *
  * Field                Desc                        Value
  * Priority, bits[7:0]:  Partition Priority          Lowest, low, normal, high, hightest
@@ -37,7 +38,8 @@
  * I/S, bit[9]:          IPC or SFN typed partition  1: IPC               0: SFN
  * MB,  bit[10]:         NS Agent Mailbox or not     1: NS Agent mailbox  0: Not
  * TZ,  bit[11]:         NS Agent TZ or not          1: NS Agent TZ       0: Not
- * RES, bits[31:12]:     20 bits reserved            0
+ * CS,  bit[12]:         Reserved connection slot    1: Has a slot        0: Not
+ * RES, bits[31:13]:     19 bits reserved            0
  */
 #define PARTITION_PRI_HIGHEST                   (0x0)
 #define PARTITION_PRI_HIGH                      (0xF)
@@ -52,6 +54,8 @@
 #define PARTITION_NS_AGENT_MB                   (1U << 10)
 #define PARTITION_NS_AGENT_TZ                   (1U << 11)
 
+#define PARTITION_CONN_SLOT                     (1U << 12)
+
 #define PARTITION_PRIORITY(flag)                ((flag) & PARTITION_PRI_MASK)
 #define TO_THREAD_PRIORITY(x)                   (x)
 
@@ -78,10 +82,22 @@
 #define IS_NS_AGENT_MAILBOX(pldi)               false
 #endif
 
+#define HAS_CONN_SLOT(pldi)                     (!!((pldi)->flags \
+                                                     & PARTITION_CONN_SLOT))
+
 #define PARTITION_TYPE_TO_INDEX(type)           (!!((type) & PARTITION_NS_AGENT_TZ))
 
 /* Partition flag end */
 
+/*
+ * Dependency bitset, with one bit for each RoT Service at the index of the
+ * service in the SID-sorted services.
+ */
+#define PARTITION_DEP_BITSET_WORDS              ((CONFIG_TFM_SERVICE_NUM / 32) + 1)
+#define PARTITION_HAS_DEP(pldi, idx)                                         \
+    (((idx) < CONFIG_TFM_SERVICE_NUM) &&                                     \
+     ((pldi)->dep_bitset[(idx) / 32] & (1UL << ((idx) % 32))))
+
 /*
  * Common partition structure type, the extendable data is right after it.
  * Extendable data has different size for each partition, and must be 4-byte
@@ -99,6 +115,7 @@ struct partition_load_info_t {
     uint32_t        nservices;          /* Service number                   */
     uint32_t        nassets;            /* Asset numbers                    */
     uint32_t        nirqs;              /* Number of IRQ owned by Partition */
+    uint32_t        dep_bitset[PARTITION_DEP_BITSET_WORDS]; /* Dependencies */
 } __attribute__((aligned(4)));
 
 #endif /* __PARTITION_DEFS_H__ */
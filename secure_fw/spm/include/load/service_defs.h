@@ -47,6 +47,7 @@
 struct service_load_info_t {
     uintptr_t       name_strid;         /* String ID for name               */
     uint32_t        sid;                /* Service ID                       */
+    uint32_t        index;              /* Index in the SID-sorted services */
     uint32_t        flags;              /* Flags                            */
     uint32_t        version;            /* Service version                  */
     uintptr_t       sfn;                /* Secure Function                  */
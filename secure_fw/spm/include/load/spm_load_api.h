@@ -52,12 +52,6 @@ struct partition_head_t {
     struct partition_t *next;           /* Next partition node  */
 };
 
-/* Runtime service struct list head node type */
-struct service_head_t {
-    uint32_t reserved;                  /* Reserved             */
-    struct service_t *next;             /* Next partition node  */
-};
-
 /*
  * Load a partition object to linked list and return if a load is successful.
  * An 'assuredly' function, return NO_MORE_PARTITION for no more partitions and
@@ -67,7 +61,8 @@ struct service_head_t {
 struct partition_t *load_a_partition_assuredly(struct partition_head_t *head);
 
 /*
- * Load numbers of service objects to linked list based on given partition.
+ * Load numbers of service objects based on given partition, and place them
+ * in the SID-sorted service table at the index of each service.
  * It loads connection based services and stateless services that partition
  * contains.
  * As an 'assuredly' function, errors simply panic the system and never
@@ -76,7 +71,8 @@ struct partition_t *load_a_partition_assuredly(struct partition_head_t *head);
  * ZERO if services are not represented by signals.
  */
 uint32_t load_services_assuredly(struct partition_t *p_partition,
-                                 struct service_head_t *services_listhead,
+                                 struct service_t **sorted_services_tbl,
+                                 size_t sorted_tbl_size,
                                  struct service_t **stateless_services_ref_tbl,
                                  size_t ref_tbl_size);
 
@@ -9,6 +9,7 @@
 #include "cmsis.h"
 #include "tfm_ns_ctx.h"
 #include "tfm_nspm.h"
+#include "spm.h"
 
 /*
  * NS context. Initialized to 0.
@@ -154,6 +155,12 @@ bool load_ns_ctx(uint8_t gid, uint8_t tid, int32_t nsid, uint8_t idx)
     ns_ctx_data[idx].nsid = nsid;
     active_ns_ctx_index = idx;
     __enable_irq();
+
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+    /* The new NS thread may run with another NS MPU configuration */
+    spm_flush_mem_check_cache();
+#endif
+
     return true;
 }
 
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PSA_MANIFEST_PID_H__
+#define __PSA_MANIFEST_PID_H__
+
+/* The host tests of the SPM create their partitions without manifests */
+
+#endif /* __PSA_MANIFEST_PID_H__ */
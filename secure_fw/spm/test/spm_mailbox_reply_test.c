@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests and benchmark of the notification of the SPE mailbox replies, with
+ * the NSPE and the mailbox agent of SPE on two host threads. The services
+ * complete the calls asynchronously, in the order of the requests.
+ *
+ * The test checks the number of replies covered by each notification for a
+ * burst of calls, and that psa_wait() is never called in the mailbox critical
+ * section. The benchmark keeps all the mailbox queue slots in flight and
+ * reports the throughput, the latency of the calls and the notifications per
+ * call.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "async.h"
+#include "spm_test.h"
+#include "tfm_rpc.h"
+#include "tfm_spe_mailbox.h"
+
+#define NUM_CALLS           20000U
+/* Time the NSPE waits for a reply before it fails the test, in seconds */
+#define REPLY_WAIT_TIMEOUT  5
+
+#define NS_CLIENT_ID        (-1)
+#define SLOT_FREE_RETURN    ((int32_t)0x7FFFFFFF)
+
+#if CONFIG_TFM_MAILBOX_REPLY_TIMEOUT > 0 && \
+    CONFIG_TFM_MAILBOX_REPLY_TIMEOUT < CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM
+#define MAX_REPLIES_PER_NOTIFY (CONFIG_TFM_MAILBOX_REPLY_TIMEOUT + 1)
+#else
+#define MAX_REPLIES_PER_NOTIFY CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM
+#endif
+
+static struct ns_mailbox_queue_t ns_queue;
+static const struct tfm_rpc_ops_t *rpc_ops;
+
+/* The NSPE mailbox lock, shared by the two cores */
+static pthread_mutex_t hal_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool spe_holds_hal_lock;
+
+/* The interrupts between the cores */
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t irq_cond = PTHREAD_COND_INITIALIZER;
+static bool spe_mailbox_irq;
+static bool ns_mailbox_irq;
+static bool spe_stop;
+
+/* Owners of the calls completed by the services, in completion order */
+static const void *completed[NUM_MAILBOX_QUEUE_SLOT];
+static uint32_t completed_head;
+static uint32_t nr_completed;
+
+/* SPE tick, advanced by each reply as the service time */
+static uint32_t spe_ticks;
+static uint32_t nr_notifies;
+static uint32_t nr_unnotified;
+static uint32_t max_replies_per_notify;
+static bool psa_wait_in_critical;
+
+static struct timespec submit_time[NUM_MAILBOX_QUEUE_SLOT];
+
+uint32_t tfm_rpc_psa_framework_version(void)
+{
+    return PSA_FRAMEWORK_VERSION;
+}
+
+uint32_t tfm_rpc_psa_version(const struct client_call_params_t *params)
+{
+    (void)params;
+
+    return PSA_VERSION_NONE;
+}
+
+psa_status_t tfm_rpc_psa_call(const struct client_call_params_t *params)
+{
+    completed[(completed_head + nr_completed) % NUM_MAILBOX_QUEUE_SLOT] =
+                        rpc_ops->get_caller_data(params->ns_client_id);
+    nr_completed++;
+
+    return PSA_SUCCESS;
+}
+
+int32_t tfm_rpc_register_ops(const struct tfm_rpc_ops_t *ops_ptr)
+{
+    rpc_ops = ops_ptr;
+
+    return TFM_RPC_SUCCESS;
+}
+
+void tfm_rpc_unregister_ops(void)
+{
+    rpc_ops = NULL;
+}
+
+psa_signal_t psa_wait(psa_signal_t signal_mask, uint32_t timeout)
+{
+    (void)timeout;
+
+    /* An SVC faults with PRIMASK set, and must not hold the NSPE lock */
+    if ((spm_test_primask != 0) || spe_holds_hal_lock) {
+        psa_wait_in_critical = true;
+    }
+
+    return (nr_completed != 0) ? (signal_mask & ASYNC_MSG_REPLY) : 0;
+}
+
+int32_t tfm_mailbox_hal_init(struct secure_mailbox_queue_t *s_queue)
+{
+    s_queue->ns_queue = &ns_queue;
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_mailbox_hal_notify_peer(void)
+{
+    if (nr_unnotified > max_replies_per_notify) {
+        max_replies_per_notify = nr_unnotified;
+    }
+    nr_unnotified = 0;
+    nr_notifies++;
+
+    pthread_mutex_lock(&irq_lock);
+    ns_mailbox_irq = true;
+    pthread_cond_broadcast(&irq_cond);
+    pthread_mutex_unlock(&irq_lock);
+
+    return MAILBOX_SUCCESS;
+}
+
+void tfm_mailbox_hal_enter_critical(void)
+{
+    pthread_mutex_lock(&hal_lock);
+    spe_holds_hal_lock = true;
+}
+
+void tfm_mailbox_hal_exit_critical(void)
+{
+    spe_holds_hal_lock = false;
+    pthread_mutex_unlock(&hal_lock);
+}
+
+uint32_t tfm_mailbox_hal_get_timestamp(void)
+{
+    return spe_ticks;
+}
+
+/**
+ * \brief Replies to the oldest call completed by the services, as the
+ *        mailbox agent does on ASYNC_MSG_REPLY.
+ */
+static void spe_reply_one(void)
+{
+    const void *owner = completed[completed_head];
+
+    completed_head = (completed_head + 1) % NUM_MAILBOX_QUEUE_SLOT;
+    nr_completed--;
+    nr_unnotified++;
+
+    rpc_ops->reply(owner, PSA_SUCCESS);
+    spe_ticks++;
+}
+
+/**
+ * \brief The loop of the mailbox agent, which handles the requests before the
+ *        replies, until the NSPE stops it.
+ */
+static void *spe_agent_thread(void *arg)
+{
+    bool mailbox_signal;
+
+    (void)arg;
+
+    while (1) {
+        pthread_mutex_lock(&irq_lock);
+        while (!spe_mailbox_irq && (nr_completed == 0) && !spe_stop) {
+            pthread_cond_wait(&irq_cond, &irq_lock);
+        }
+        mailbox_signal = spe_mailbox_irq;
+        spe_mailbox_irq = false;
+        if (!mailbox_signal && (nr_completed == 0)) {
+            pthread_mutex_unlock(&irq_lock);
+            break;
+        }
+        pthread_mutex_unlock(&irq_lock);
+
+        if (mailbox_signal) {
+            rpc_ops->handle_req();
+        } else {
+            spe_reply_one();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Submits a PSA call in an NSPE mailbox queue slot, and interrupts SPE.
+ */
+static void ns_submit(uint8_t idx)
+{
+    struct ns_mailbox_slot_t *slot = &ns_queue.queue[idx];
+
+    (void)memset(&slot->msg, 0, sizeof(slot->msg));
+    slot->msg.call_type = MAILBOX_PSA_CALL;
+    slot->msg.params.psa_call_params.handle = 1;
+    slot->msg.client_id = NS_CLIENT_ID;
+    slot->reply.return_val = SLOT_FREE_RETURN;
+    clock_gettime(CLOCK_MONOTONIC, &submit_time[idx]);
+
+#if TFM_MAILBOX_RING
+    (void)mailbox_ring_push(&ns_queue.req_ring, idx);
+#else
+    pthread_mutex_lock(&hal_lock);
+    ns_queue.empty_slots &= ~(1UL << idx);
+    ns_queue.pend_slots |= (1UL << idx);
+    pthread_mutex_unlock(&hal_lock);
+#endif
+
+    pthread_mutex_lock(&irq_lock);
+    spe_mailbox_irq = true;
+    pthread_cond_broadcast(&irq_cond);
+    pthread_mutex_unlock(&irq_lock);
+}
+
+/**
+ * \brief Waits for the SPE notification, as the NSPE mailbox interrupt.
+ *
+ * \return true if notified, false if no notification arrived in time
+ */
+static bool ns_wait_notification(void)
+{
+    struct timespec deadline;
+    bool notified;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += REPLY_WAIT_TIMEOUT;
+
+    pthread_mutex_lock(&irq_lock);
+    while (!ns_mailbox_irq &&
+           (pthread_cond_timedwait(&irq_cond, &irq_lock, &deadline) == 0)) {
+    }
+    notified = ns_mailbox_irq;
+    ns_mailbox_irq = false;
+    pthread_mutex_unlock(&irq_lock);
+
+    return notified;
+}
+
+/**
+ * \brief Collects the replied NSPE mailbox queue slots.
+ *
+ * \return Bitmask of the replied slots
+ */
+static uint32_t ns_collect_replies(void)
+{
+    uint32_t replied = 0;
+#if TFM_MAILBOX_RING
+    uint8_t idx;
+
+    while (mailbox_ring_pop(&ns_queue.reply_ring, &idx)) {
+        replied |= 1UL << idx;
+    }
+#else
+    pthread_mutex_lock(&hal_lock);
+    replied = ns_queue.replied_slots;
+    ns_queue.replied_slots = 0;
+    ns_queue.empty_slots |= replied;
+    pthread_mutex_unlock(&hal_lock);
+#endif
+
+    return replied;
+}
+
+static void reset_mailbox(void)
+{
+    (void)memset(&ns_queue, 0, sizeof(ns_queue));
+#if !TFM_MAILBOX_RING
+    ns_queue.empty_slots = (uint32_t)((1ULL << NUM_MAILBOX_QUEUE_SLOT) - 1);
+#endif
+    completed_head = 0;
+    nr_completed = 0;
+    nr_notifies = 0;
+    nr_unnotified = 0;
+    max_replies_per_notify = 0;
+    spe_mailbox_irq = false;
+    ns_mailbox_irq = false;
+    spe_stop = false;
+
+    (void)tfm_mailbox_init();
+}
+
+/**
+ * \brief Handles a burst of calls in all the slots on a single thread, and
+ *        checks the notifications of their replies.
+ */
+static int test_burst(void)
+{
+    uint32_t expected;
+    uint8_t idx;
+
+    reset_mailbox();
+
+    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+        ns_submit(idx);
+    }
+
+    TEST_CHECK(tfm_mailbox_handle_msg() == MAILBOX_SUCCESS);
+    TEST_CHECK(nr_completed == NUM_MAILBOX_QUEUE_SLOT);
+    TEST_CHECK(nr_notifies == 0);
+
+    while (nr_completed != 0) {
+        spe_reply_one();
+    }
+
+    /* Every reply is notified, in full notifications but the last one */
+    expected = (NUM_MAILBOX_QUEUE_SLOT + MAX_REPLIES_PER_NOTIFY - 1) /
+               MAX_REPLIES_PER_NOTIFY;
+    TEST_CHECK(nr_unnotified == 0);
+    TEST_CHECK(nr_notifies == expected);
+    TEST_CHECK(ns_collect_replies() ==
+               (uint32_t)((1ULL << NUM_MAILBOX_QUEUE_SLOT) - 1));
+    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+        TEST_CHECK(ns_queue.queue[idx].reply.return_val == PSA_SUCCESS);
+    }
+    TEST_CHECK(!psa_wait_in_critical);
+
+    printf("Burst of %u calls: %u notifications\n", NUM_MAILBOX_QUEUE_SLOT,
+           nr_notifies);
+
+    return 0;
+}
+
+static double elapsed_us(const struct timespec *start,
+                         const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e6 +
+           (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/**
+ * \brief Runs NUM_CALLS calls with all the slots in flight, the mailbox agent
+ *        on its own thread, and reports the throughput and the latency.
+ */
+static int bench_two_threads(void)
+{
+    pthread_t spe_thread;
+    struct timespec start, now;
+    double latency_sum = 0, latency_max = 0, latency;
+    uint32_t nr_submitted = 0, nr_replied = 0;
+    uint32_t replied;
+    uint8_t idx;
+
+    reset_mailbox();
+    TEST_CHECK(pthread_create(&spe_thread, NULL, spe_agent_thread, NULL) ==
+               0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+        ns_submit(idx);
+        nr_submitted++;
+    }
+
+    while (nr_replied < NUM_CALLS) {
+        replied = ns_collect_replies();
+        if (replied == 0) {
+            if (!ns_wait_notification()) {
+                printf("No notification of %u calls in flight\n",
+                       nr_submitted - nr_replied);
+                return 1;
+            }
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+            if (!(replied & (1UL << idx))) {
+                continue;
+            }
+
+            TEST_CHECK(ns_queue.queue[idx].reply.return_val == PSA_SUCCESS);
+            latency = elapsed_us(&submit_time[idx], &now);
+            latency_sum += latency;
+            if (latency > latency_max) {
+                latency_max = latency;
+            }
+            nr_replied++;
+
+            if (nr_submitted < NUM_CALLS) {
+                ns_submit(idx);
+                nr_submitted++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&irq_lock);
+    spe_stop = true;
+    pthread_cond_broadcast(&irq_cond);
+    pthread_mutex_unlock(&irq_lock);
+    TEST_CHECK(pthread_join(spe_thread, NULL) == 0);
+
+    TEST_CHECK(!psa_wait_in_critical);
+    TEST_CHECK(max_replies_per_notify <= MAX_REPLIES_PER_NOTIFY);
+
+    printf("%u calls, %u slots in flight: %.0f calls/s, latency %.1f us "
+           "mean, %.1f us max, %.3f notifications per call\n", NUM_CALLS,
+           NUM_MAILBOX_QUEUE_SLOT, NUM_CALLS / (elapsed_us(&start, &now) / 1e6),
+           latency_sum / NUM_CALLS, latency_max,
+           (double)nr_notifies / NUM_CALLS);
+
+    return 0;
+}
+
+int main(void)
+{
+    printf("%s transport, batch of %u replies, timeout of %u ticks\n",
+           TFM_MAILBOX_RING ? "Ring" : "Bitmap",
+           CONFIG_TFM_MAILBOX_REPLY_BATCH_NUM,
+           CONFIG_TFM_MAILBOX_REPLY_TIMEOUT);
+
+    if ((test_burst() != 0) || (bench_two_threads() != 0)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the single-producer single-consumer rings of the mailbox queue:
+ * push and pop on an empty and a full ring, the wraparound of the entries and
+ * of the free-running counters, random pushes and pops against a model, and a
+ * producer and a consumer on two host threads, standing in for the cores.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spm_test.h"
+#include "tfm_mailbox.h"
+
+#define NUM_SEEDS           16U
+#define NUM_RAND_OPS        4000U
+#define NUM_THREAD_ENTRIES  1000000U
+
+/* Initial counters of the wraparound test, just below the counter overflow */
+#define WRAP_START          (UINT32_MAX - NUM_MAILBOX_QUEUE_SLOT - 1U)
+
+static struct mailbox_ring_t ring;
+
+/**
+ * \brief Pushes entries until the ring is full, checks that it refuses one
+ *        more, then pops them in order until it is empty.
+ */
+static int fill_and_drain(uint8_t first)
+{
+    struct mailbox_ring_t full;
+    uint8_t idx;
+    uint32_t i;
+
+    for (i = 0; i < NUM_MAILBOX_QUEUE_SLOT; i++) {
+        TEST_CHECK(mailbox_ring_push(&ring, (uint8_t)(first + i)) ==
+                   MAILBOX_SUCCESS);
+    }
+
+    /* A full ring refuses an entry and is left unchanged */
+    (void)memcpy(&full, &ring, sizeof(full));
+    TEST_CHECK(mailbox_ring_push(&ring, 0xFF) == MAILBOX_QUEUE_FULL);
+    TEST_CHECK(memcmp(&full, &ring, sizeof(full)) == 0);
+    TEST_CHECK(ring.head - ring.tail == NUM_MAILBOX_QUEUE_SLOT);
+
+    for (i = 0; i < NUM_MAILBOX_QUEUE_SLOT; i++) {
+        TEST_CHECK(mailbox_ring_pop(&ring, &idx));
+        TEST_CHECK(idx == (uint8_t)(first + i));
+    }
+
+    /* An empty ring returns no entry and leaves the output unchanged */
+    idx = 0xA5;
+    TEST_CHECK(!mailbox_ring_pop(&ring, &idx));
+    TEST_CHECK(idx == 0xA5);
+    TEST_CHECK(ring.head == ring.tail);
+
+    return 0;
+}
+
+/**
+ * \brief Fills and drains the ring from an empty ring, at every entry
+ *        position, and across the overflow of the counters.
+ */
+static int test_full_empty(void)
+{
+    uint8_t idx;
+    uint32_t i;
+
+    (void)memset(&ring, 0, sizeof(ring));
+    TEST_CHECK(!mailbox_ring_pop(&ring, &idx));
+    TEST_CHECK(fill_and_drain(0) == 0);
+
+    /* Start the next fill at each entry of the ring */
+    for (i = 0; i < NUM_MAILBOX_QUEUE_SLOT; i++) {
+        TEST_CHECK(mailbox_ring_push(&ring, (uint8_t)i) == MAILBOX_SUCCESS);
+        TEST_CHECK(mailbox_ring_pop(&ring, &idx));
+        TEST_CHECK(idx == (uint8_t)i);
+        TEST_CHECK(fill_and_drain((uint8_t)(i * 7)) == 0);
+    }
+
+    /* The counters overflow while the ring is full */
+    ring.head = WRAP_START;
+    ring.tail = WRAP_START;
+    for (i = 0; i < 3; i++) {
+        TEST_CHECK(fill_and_drain((uint8_t)(i * 3)) == 0);
+    }
+    TEST_CHECK(ring.head < WRAP_START);
+
+    return 0;
+}
+
+/**
+ * \brief Makes random pushes and pops, and checks each of them against a
+ *        model of the ring.
+ */
+static int test_random(uint32_t seed)
+{
+    uint8_t model[NUM_MAILBOX_QUEUE_SLOT];
+    uint32_t model_head = 0;
+    uint32_t model_num = 0;
+    uint8_t next = 0;
+    uint8_t idx;
+    uint32_t op;
+
+    (void)memset(&ring, 0, sizeof(ring));
+    /* Some seeds run across the overflow of the counters */
+    if (seed & 1U) {
+        ring.head = WRAP_START - NUM_RAND_OPS / 4;
+        ring.tail = ring.head;
+    }
+    spm_test_srand(seed);
+
+    for (op = 0; op < NUM_RAND_OPS; op++) {
+        if (spm_test_rand(2) == 0) {
+            if (model_num == NUM_MAILBOX_QUEUE_SLOT) {
+                TEST_CHECK(mailbox_ring_push(&ring, next) ==
+                           MAILBOX_QUEUE_FULL);
+                continue;
+            }
+
+            TEST_CHECK(mailbox_ring_push(&ring, next) == MAILBOX_SUCCESS);
+            model[(model_head + model_num) % NUM_MAILBOX_QUEUE_SLOT] = next;
+            model_num++;
+            next++;
+        } else {
+            if (model_num == 0) {
+                TEST_CHECK(!mailbox_ring_pop(&ring, &idx));
+                continue;
+            }
+
+            TEST_CHECK(mailbox_ring_pop(&ring, &idx));
+            TEST_CHECK(idx == model[model_head]);
+            model_head = (model_head + 1) % NUM_MAILBOX_QUEUE_SLOT;
+            model_num--;
+        }
+
+        TEST_CHECK(ring.head - ring.tail == model_num);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Pushes NUM_THREAD_ENTRIES entries, waiting while the ring is full.
+ */
+static void *producer_thread(void *arg)
+{
+    uint32_t i;
+
+    (void)arg;
+
+    for (i = 0; i < NUM_THREAD_ENTRIES; i++) {
+        while (mailbox_ring_push(&ring, (uint8_t)i) != MAILBOX_SUCCESS) {
+            /* Let the consumer run on a host with a single CPU */
+            (void)sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Pops the entries of the producer thread on this thread, and checks
+ *        that they arrive complete and in order.
+ */
+static int test_two_threads(void)
+{
+    pthread_t producer;
+    struct timespec start, end;
+    uint32_t nr_empty = 0;
+    uint32_t i;
+    uint8_t idx;
+    double elapsed;
+
+    (void)memset(&ring, 0, sizeof(ring));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_CHECK(pthread_create(&producer, NULL, producer_thread, NULL) == 0);
+
+    for (i = 0; i < NUM_THREAD_ENTRIES; i++) {
+        while (!mailbox_ring_pop(&ring, &idx)) {
+            nr_empty++;
+            (void)sched_yield();
+        }
+        if (idx != (uint8_t)i) {
+            printf("Entry %u popped as %u\n", i, idx);
+            return 1;
+        }
+    }
+
+    TEST_CHECK(pthread_join(producer, NULL) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    TEST_CHECK(!mailbox_ring_pop(&ring, &idx));
+    TEST_CHECK(ring.head == NUM_THREAD_ENTRIES);
+
+    elapsed = (end.tv_sec - start.tv_sec) +
+              (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%u entries through %u slots on two threads: %.1f M entries/s, "
+           "%u pops on an empty ring\n", NUM_THREAD_ENTRIES,
+           NUM_MAILBOX_QUEUE_SLOT, NUM_THREAD_ENTRIES / elapsed / 1e6,
+           nr_empty);
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    if (test_full_empty() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    for (seed = 1; seed <= NUM_SEEDS; seed++) {
+        if (test_random(seed) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (test_two_threads() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: %u slots, %u seeds\n", NUM_MAILBOX_QUEUE_SLOT, NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the validation of the client memory by psa_call(), which caches
+ * the validated ranges when CONFIG_TFM_MEM_CHECK_CACHE_NUM is not 0: the
+ * number of platform memory checks made by repeated calls with the same
+ * buffers, from a secure partition and from the Non-secure agent, and the
+ * ranges which must still reach the platform check: other access types,
+ * other boundaries, denied ranges and ranges cached before a flush. The same
+ * tests run with the cache disabled, as the reference.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "spm.h"
+#include "spm_test.h"
+#include "ffm/backend.h"
+#include "ffm/psa_api.h"
+#include "load/service_defs.h"
+#include "tfm_hal_isolation.h"
+#include "tfm_psa_call_pack.h"
+
+#define NUM_CALLS       100U
+#define BUF_SIZE        64U
+#define SECURE_BOUNDARY 0x100U
+#define NS_BOUNDARY     0x200U
+
+/* Index of the stateless service in stateless_services_ref_tbl */
+#define SERVICE_INDEX   0U
+#define SERVICE_HANDLE  ((psa_handle_t)((1UL << STATIC_HANDLE_INDICATOR_OFFSET) \
+                         | (1UL << STATIC_HANDLE_VER_OFFSET) | SERVICE_INDEX))
+
+extern struct service_t *stateless_services_ref_tbl[];
+
+static struct partition_load_info_t client_ldinf;
+static struct partition_load_info_t server_ldinf;
+static struct service_load_info_t srv_ldinf;
+static struct partition_t client;
+static struct partition_t server;
+static struct service_t service;
+static struct thread_t client_thrd;
+static struct connection_t connection;
+
+static uint8_t in_buf[2][BUF_SIZE];
+static uint8_t out_buf[BUF_SIZE];
+/* Client memory which the platform check denies */
+static uint8_t denied_buf[BUF_SIZE];
+
+static uint32_t num_platform_checks;
+
+FIH_RET_TYPE(enum tfm_hal_status_t) tfm_hal_memory_check(
+                                           uintptr_t boundary, uintptr_t base,
+                                           size_t size, uint32_t access_type)
+{
+    (void)boundary;
+    (void)access_type;
+
+    num_platform_checks++;
+
+    if ((base < (uintptr_t)denied_buf + sizeof(denied_buf)) &&
+        ((uintptr_t)denied_buf < base + size)) {
+        FIH_RET(fih_int_encode(TFM_HAL_ERROR_MEM_FAULT));
+    }
+
+    FIH_RET(fih_int_encode(TFM_HAL_SUCCESS));
+}
+
+struct connection_t *spm_allocate_stateless_connection(
+                                                  struct partition_t *p_client)
+{
+    (void)p_client;
+
+    return &connection;
+}
+
+psa_status_t backend_messaging(struct service_t *p_serv,
+                               struct connection_t *handle)
+{
+    (void)p_serv;
+    (void)handle;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Creates a stateless service, and a client partition calling it, which
+ *        is either a secure partition or the Non-secure agent.
+ */
+static void create_client(bool ns_agent)
+{
+    (void)memset(&client_ldinf, 0, sizeof(client_ldinf));
+    (void)memset(&client, 0, sizeof(client));
+    (void)memset(&server_ldinf, 0, sizeof(server_ldinf));
+    (void)memset(&server, 0, sizeof(server));
+    (void)memset(&srv_ldinf, 0, sizeof(srv_ldinf));
+    (void)memset(&service, 0, sizeof(service));
+
+    srv_ldinf.sid = 0x1000;
+    srv_ldinf.index = 0;
+    srv_ldinf.version = 1;
+    srv_ldinf.flags = SERVICE_FLAG_STATELESS | SERVICE_FLAG_NS_ACCESSIBLE |
+                      SERVICE_VERSION_POLICY_RELAXED;
+    server_ldinf.pid = 256;
+    server.p_ldinf = &server_ldinf;
+    service.p_ldinf = &srv_ldinf;
+    service.partition = &server;
+    stateless_services_ref_tbl[SERVICE_INDEX] = &service;
+
+    if (ns_agent) {
+        client_ldinf.pid = 0;
+        client_ldinf.flags = PARTITION_NS_AGENT_TZ;
+        client.boundary = NS_BOUNDARY;
+    } else {
+        client_ldinf.pid = 257;
+        client_ldinf.dep_bitset[0] = 1U << srv_ldinf.index;
+        client.boundary = SECURE_BOUNDARY;
+    }
+    client.p_ldinf = &client_ldinf;
+    client_thrd.p_context_ctrl = &client.ctx_ctrl;
+    p_curr_thrd = &client_thrd;
+
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+    spm_flush_mem_check_cache();
+#endif
+}
+
+/**
+ * \brief Makes a call with two input vectors and one output vector.
+ *
+ * \param[out] checks  Number of platform memory checks made by the call
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t call(const void *in0, const void *in1, void *out,
+                         uint32_t *checks)
+{
+    psa_invec in_vec[2] = {
+        {in0, BUF_SIZE},
+        {in1, BUF_SIZE},
+    };
+    psa_outvec out_vec[1] = {
+        {out, BUF_SIZE},
+    };
+    uint32_t start = num_platform_checks;
+    psa_status_t status;
+
+    status = tfm_spm_client_psa_call(SERVICE_HANDLE, PARAM_PACK(0, 2, 1),
+                                     in_vec, out_vec);
+    *checks = num_platform_checks - start;
+
+    return status;
+}
+
+/**
+ * \brief Measures the platform memory checks of repeated calls with the same
+ *        buffers, and checks the ranges which must not hit the cache.
+ */
+static int test_client(bool ns_agent)
+{
+    uint32_t first;
+    uint32_t checks;
+    uint32_t total = 0;
+    uint32_t i;
+    bool cached;
+
+    create_client(ns_agent);
+
+    TEST_CHECK(call(in_buf[0], in_buf[1], out_buf, &first) == PSA_SUCCESS);
+    for (i = 0; i < NUM_CALLS; i++) {
+        TEST_CHECK(call(in_buf[0], in_buf[1], out_buf, &checks) ==
+                   PSA_SUCCESS);
+        total += checks;
+    }
+
+    printf("%s caller: %u platform memory checks on the first call, %u per "
+           "call after it\n", ns_agent ? "Non-secure" : "Secure", first,
+           total / NUM_CALLS);
+
+    /* The two wrap vectors and the three payloads */
+    TEST_CHECK(first == 5);
+
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+#ifdef TFM_NS_MANAGE_NSID
+    cached = true;
+#else
+    cached = !ns_agent;
+#endif
+#else
+    cached = false;
+#endif
+
+    TEST_CHECK(total == (cached ? 0 : NUM_CALLS * first));
+    if (!cached) {
+        return 0;
+    }
+
+    /* An input buffer passed as an output needs the write access checked */
+    TEST_CHECK(call(in_buf[0], in_buf[1], in_buf[0], &checks) == PSA_SUCCESS);
+    TEST_CHECK(checks == 1);
+
+    /* A denied range is never cached */
+    for (i = 0; i < 2; i++) {
+        TEST_CHECK(call(in_buf[0], denied_buf, out_buf, &checks) ==
+                   PSA_ERROR_PROGRAMMER_ERROR);
+        TEST_CHECK(checks == 1);
+    }
+
+    /* The ranges of another boundary are checked again */
+    client.boundary ^= SECURE_BOUNDARY | NS_BOUNDARY;
+    TEST_CHECK(call(in_buf[0], in_buf[1], out_buf, &checks) == PSA_SUCCESS);
+    TEST_CHECK(checks == 5);
+    client.boundary ^= SECURE_BOUNDARY | NS_BOUNDARY;
+
+#if CONFIG_TFM_MEM_CHECK_CACHE_NUM > 0
+    /* As on a Non-secure context switch */
+    spm_flush_mem_check_cache();
+    TEST_CHECK(call(in_buf[0], in_buf[1], out_buf, &checks) == PSA_SUCCESS);
+    TEST_CHECK(checks == 5);
+#endif
+
+    return 0;
+}
+
+int main(void)
+{
+    if ((test_client(false) != 0) || (test_client(true) != 0)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Tests of the message queues of the services of an IPC partition: the
+ * lookup of the service of a signal, with valid and invalid signals, and the
+ * order of the messages returned by random queueing and getting, as done by
+ * backend_messaging() and psa_get(), on partitions with 1 to 28 services.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "spm.h"
+#include "spm_test.h"
+#include "load/service_defs.h"
+
+/* Services of the largest partition, with the signals 4 to 31 */
+#define MAX_SERVICES    28U
+/* Number of services of the tested partitions */
+#define NUM_LAYOUTS     4U
+#define NUM_CONNECTIONS 64U
+#define NUM_SEEDS       16U
+#define NUM_RAND_OPS    2000U
+/* Signal of the first service, after the 4 signals reserved by FF-M */
+#define FIRST_SIGNAL_BIT 4U
+
+struct test_queue_t {
+    uint32_t conn[NUM_CONNECTIONS];
+    uint32_t head;
+    uint32_t num;
+};
+
+static const uint32_t layouts[NUM_LAYOUTS] = {1, 3, 8, MAX_SERVICES};
+
+static struct partition_load_info_t ptn_ldinf;
+static struct service_load_info_t srv_ldinf[MAX_SERVICES];
+static struct partition_t ptn;
+static struct service_t services[MAX_SERVICES];
+static struct connection_t connections[NUM_CONNECTIONS];
+static bool conn_queued[NUM_CONNECTIONS];
+static struct test_queue_t queues[MAX_SERVICES];
+
+/**
+ * \brief Creates an IPC partition with empty queues, and the signals assigned
+ *        to its services by the manifest tool.
+ */
+static void create_partition(uint32_t nservices)
+{
+    uint32_t i;
+
+    (void)memset(&ptn_ldinf, 0, sizeof(ptn_ldinf));
+    (void)memset(srv_ldinf, 0, sizeof(srv_ldinf));
+    (void)memset(&ptn, 0, sizeof(ptn));
+    (void)memset(services, 0, sizeof(services));
+    (void)memset(connections, 0, sizeof(connections));
+    (void)memset(conn_queued, 0, sizeof(conn_queued));
+    (void)memset(queues, 0, sizeof(queues));
+
+    ptn_ldinf.nservices = nservices;
+    ptn.p_ldinf = &ptn_ldinf;
+    ptn.p_services = services;
+
+    for (i = 0; i < nservices; i++) {
+        srv_ldinf[i].sid = 0x1000 + i;
+        srv_ldinf[i].signal = 1UL << (FIRST_SIGNAL_BIT + i);
+        services[i].p_ldinf = &srv_ldinf[i];
+        services[i].partition = &ptn;
+    }
+}
+
+/**
+ * \brief Queues a message to a service and asserts its signal, as
+ *        backend_messaging() does, and records it in the model.
+ */
+static void queue_message(uint32_t srv, uint32_t conn)
+{
+    struct test_queue_t *queue = &queues[srv];
+
+    connections[conn].service = &services[srv];
+    spm_queue_handle_to_service(&services[srv], &connections[conn]);
+    ptn.signals_asserted |= services[srv].p_ldinf->signal;
+
+    queue->conn[(queue->head + queue->num) % NUM_CONNECTIONS] = conn;
+    queue->num++;
+    conn_queued[conn] = true;
+}
+
+/**
+ * \brief Gets the message of a signal, as psa_get() does, and checks it
+ *        against the model: the oldest message of the service of the signal,
+ *        or none if the queue is empty, and the signal asserted only while the
+ *        queue has messages.
+ *
+ * \return true if it matches
+ */
+static bool get_matches(uint32_t srv)
+{
+    struct test_queue_t *queue = &queues[srv];
+    psa_signal_t signal = services[srv].p_ldinf->signal;
+    struct connection_t *p_handle;
+    uint32_t conn;
+
+    p_handle = spm_get_handle_by_signal(&ptn, signal);
+    if (queue->num == 0) {
+        return (p_handle == NULL) && !(ptn.signals_asserted & signal);
+    }
+
+    conn = queue->conn[queue->head];
+    queue->head = (queue->head + 1) % NUM_CONNECTIONS;
+    queue->num--;
+    conn_queued[conn] = false;
+
+    return (p_handle == &connections[conn]) &&
+           (p_handle->service == &services[srv]) &&
+           (p_handle->p_handles == NULL) &&
+           (!(ptn.signals_asserted & signal) == (queue->num == 0));
+}
+
+/**
+ * \brief Checks that a signal matches no message, and changes no queue.
+ *
+ * \return 0 if it does
+ */
+static int check_no_match(psa_signal_t signal)
+{
+    uint32_t asserted = ptn.signals_asserted;
+    uint32_t i;
+
+    TEST_CHECK(spm_get_handle_by_signal(&ptn, signal) == NULL);
+    TEST_CHECK(ptn.signals_asserted == asserted);
+
+    for (i = 0; i < ptn_ldinf.nservices; i++) {
+        TEST_CHECK((services[i].p_msg_head == NULL) == (queues[i].num == 0));
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Looks up the services of valid and invalid signals, with a message
+ *        queued to each service.
+ */
+static int test_signal_lookup(uint32_t nservices)
+{
+    uint32_t last_bit = FIRST_SIGNAL_BIT + nservices - 1;
+    uint32_t i;
+
+    create_partition(nservices);
+
+    for (i = 0; i < nservices; i++) {
+        queue_message(i, i);
+    }
+
+    /* No signal, several signals, and the signals reserved by FF-M */
+    TEST_CHECK(check_no_match(0) == 0);
+    TEST_CHECK(check_no_match(services[0].p_ldinf->signal | PSA_DOORBELL) ==
+               0);
+    TEST_CHECK(check_no_match(PSA_DOORBELL) == 0);
+    for (i = 0; i < FIRST_SIGNAL_BIT; i++) {
+        TEST_CHECK(check_no_match(1UL << i) == 0);
+    }
+
+    /* The IRQ signals, which follow the service signals */
+    for (i = last_bit + 1; i < 32U; i++) {
+        TEST_CHECK(check_no_match(1UL << i) == 0);
+    }
+
+    /* A partition whose services are not loaded */
+    ptn.p_services = NULL;
+    TEST_CHECK(check_no_match(services[0].p_ldinf->signal) == 0);
+    ptn.p_services = services;
+
+    /* Each service gets its own message, then none */
+    for (i = 0; i < nservices; i++) {
+        TEST_CHECK(get_matches(nservices - 1 - i));
+    }
+    for (i = 0; i < nservices; i++) {
+        TEST_CHECK(get_matches(i));
+    }
+
+    TEST_CHECK(ptn.signals_asserted == 0);
+
+    return 0;
+}
+
+/**
+ * \brief Makes random queueings and gets of messages, and checks each message
+ *        returned against the model.
+ */
+static int test_random(uint32_t nservices, uint32_t seed)
+{
+    uint32_t op;
+    uint32_t srv;
+    uint32_t conn;
+
+    create_partition(nservices);
+    spm_test_srand(seed);
+
+    for (op = 0; op < NUM_RAND_OPS; op++) {
+        srv = spm_test_rand(nservices);
+        conn = spm_test_rand(NUM_CONNECTIONS);
+
+        /* Queue a free connection, or get a message of the service */
+        if (!conn_queued[conn] && (spm_test_rand(2) == 0)) {
+            queue_message(srv, conn);
+        } else if (!get_matches(srv)) {
+            printf("%u services, seed %u, op %u: message of service %u "
+                   "does not match\n", nservices, seed, op, srv);
+            return 1;
+        }
+    }
+
+    /* Drain the queues */
+    for (srv = 0; srv < nservices; srv++) {
+        while (queues[srv].num != 0) {
+            TEST_CHECK(get_matches(srv));
+        }
+        TEST_CHECK(get_matches(srv));
+    }
+
+    TEST_CHECK(ptn.signals_asserted == 0);
+
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t layout;
+    uint32_t seed;
+
+    for (layout = 0; layout < NUM_LAYOUTS; layout++) {
+        if (test_signal_lookup(layouts[layout]) != 0) {
+            return EXIT_FAILURE;
+        }
+
+        for (seed = 1; seed <= NUM_SEEDS; seed++) {
+            if (test_random(layouts[layout], seed) != 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    printf("PASS: %u partitions, %u seeds\n", NUM_LAYOUTS, NUM_SEEDS);
+
+    return EXIT_SUCCESS;
+}
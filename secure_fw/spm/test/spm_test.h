@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __SPM_TEST_H__
+#define __SPM_TEST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Checks a condition in a test function returning int, and fails the
+ *        test if it does not hold.
+ */
+#define TEST_CHECK(cond)                                                  \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                     \
+        }                                                                 \
+    } while (0)
+
+/**
+ * \brief Seeds the pseudo-random generator of the tests.
+ *
+ * \param[in] seed  Seed
+ */
+void spm_test_srand(uint32_t seed);
+
+/**
+ * \brief Gets a pseudo-random number.
+ *
+ * \param[in] bound  Exclusive upper bound of the number, greater than 0
+ *
+ * \return Number between 0 and bound - 1
+ */
+uint32_t spm_test_rand(uint32_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPM_TEST_H__ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Stand-ins for the SPM functions which spm_ipc.c calls outside of the code
+ * under test. The tests create their partitions and services themselves, so
+ * the loading and the backend are never used, and panic. The handle of a
+ * connection and the ID of a Non-secure client are fixed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spm.h"
+#include "spm_test.h"
+#include "tfm_hal_isolation.h"
+#include "tfm_nspm.h"
+#include "ffm/backend.h"
+#include "load/spm_load_api.h"
+
+struct partition_head_t partition_listhead;
+struct thread_t *p_curr_thrd;
+uint32_t spm_test_primask;
+
+static uint32_t rand_state = 1;
+
+void tfm_core_panic(void)
+{
+    printf("SPM panic\n");
+    exit(EXIT_FAILURE);
+}
+
+struct partition_t *load_a_partition_assuredly(struct partition_head_t *head)
+{
+    (void)head;
+    tfm_core_panic();
+
+    return NO_MORE_PARTITION;
+}
+
+uint32_t load_services_assuredly(struct partition_t *p_partition,
+                                 struct service_t **sorted_services_tbl,
+                                 size_t sorted_tbl_size,
+                                 struct service_t **stateless_services_ref_tbl,
+                                 size_t ref_tbl_size)
+{
+    (void)p_partition;
+    (void)sorted_services_tbl;
+    (void)sorted_tbl_size;
+    (void)stateless_services_ref_tbl;
+    (void)ref_tbl_size;
+    tfm_core_panic();
+
+    return 0;
+}
+
+void load_irqs_assuredly(struct partition_t *p_partition)
+{
+    (void)p_partition;
+    tfm_core_panic();
+}
+
+void backend_init_comp_assuredly(struct partition_t *p_pt,
+                                 uint32_t service_setting)
+{
+    (void)p_pt;
+    (void)service_setting;
+    tfm_core_panic();
+}
+
+uint32_t backend_system_run(void)
+{
+    tfm_core_panic();
+
+    return 0;
+}
+
+FIH_RET_TYPE(enum tfm_hal_status_t) tfm_hal_bind_boundary(
+                                    const struct partition_load_info_t *p_ldinf,
+                                    uintptr_t *p_boundary)
+{
+    (void)p_ldinf;
+    (void)p_boundary;
+    tfm_core_panic();
+
+    FIH_RET(fih_int_encode(TFM_HAL_ERROR_GENERIC));
+}
+
+void spm_init_connection_space(void)
+{
+    tfm_core_panic();
+}
+
+void spm_reserve_connection_slot(struct partition_t *p_partition)
+{
+    (void)p_partition;
+    tfm_core_panic();
+}
+
+psa_status_t spm_validate_connection(const struct connection_t *p_connection)
+{
+    (void)p_connection;
+    tfm_core_panic();
+
+    return PSA_ERROR_GENERIC_ERROR;
+}
+
+psa_handle_t connection_to_handle(struct connection_t *p_connection)
+{
+    (void)p_connection;
+
+    return (psa_handle_t)1;
+}
+
+struct connection_t *handle_to_connection(psa_handle_t handle)
+{
+    (void)handle;
+    tfm_core_panic();
+
+    return NULL;
+}
+
+void tfm_nspm_ctx_init(void)
+{
+    tfm_core_panic();
+}
+
+int32_t tfm_nspm_get_current_client_id(void)
+{
+    return -1;
+}
+
+void spm_test_srand(uint32_t seed)
+{
+    rand_state = (seed != 0) ? seed : 1;
+}
+
+uint32_t spm_test_rand(uint32_t bound)
+{
+    /* xorshift32 */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+
+    return rand_state % bound;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_ARCH_H__
+#define __TFM_ARCH_H__
+
+/* Architecture operations of the host tests of the SPM. The tests run
+ * without interrupts, so the interrupt masking only records the state of the
+ * mask, for the tests to check what is called with interrupts masked.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "fih.h"
+#include "cmsis_compiler.h"
+#include "utilities.h"
+
+/* State context defined by architecture */
+struct tfm_state_context_t {
+    uint32_t    r0;
+    uint32_t    r1;
+    uint32_t    r2;
+    uint32_t    r3;
+    uint32_t    r12;
+    uint32_t    lr;
+    uint32_t    ra;
+    uint32_t    xpsr;
+};
+
+/* Context control */
+struct context_ctrl_t {
+    uint32_t                sp;
+    uint32_t                exc_ret;
+    uint32_t                sp_limit;
+    uint32_t                sp_base;
+};
+
+/* Interrupt mask of the SPM thread, as PRIMASK */
+extern uint32_t spm_test_primask;
+
+__STATIC_INLINE uint32_t __save_disable_irq(void)
+{
+    uint32_t status = spm_test_primask;
+
+    spm_test_primask = 1;
+
+    return status;
+}
+
+__STATIC_INLINE void __restore_irq(uint32_t status)
+{
+    spm_test_primask = status;
+}
+
+#endif /* __TFM_ARCH_H__ */
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef _TFM_MAILBOX_CONFIG_
+#define _TFM_MAILBOX_CONFIG_
+
+/* Mailbox configuration of the host tests of the SPM, which the TF-M build
+ * generates from tfm_mailbox_config.h.in. NSPE and SPE are host threads, so
+ * the ring barrier is a host memory fence.
+ */
+#ifndef NUM_MAILBOX_QUEUE_SLOT
+#define NUM_MAILBOX_QUEUE_SLOT              8
+#endif
+
+#define TFM_MAILBOX_INLINE_PAYLOAD_SIZE     0
+
+#ifndef TFM_MAILBOX_RING
+#define TFM_MAILBOX_RING                    0
+#endif
+
+#define mailbox_ring_barrier()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif /* _TFM_MAILBOX_CONFIG_ */
@@ -271,7 +271,9 @@ def process_partition_manifests(manifest_lists, configs):
         'CONFIG_TFM_CONNECTION_BASED_SERVICE_API' : '0',
         'CONFIG_TFM_MMIO_REGION_ENABLE'           : '0',
         'CONFIG_TFM_FLIH_API'                     : '0',
-        'CONFIG_TFM_SLIH_API'                     : '0'
+        'CONFIG_TFM_SLIH_API'                     : '0',
+        'CONFIG_TFM_SERVICE_NUM'                  : '0',
+        'CONFIG_TFM_CONN_SLOT_NUM'                : '0'
     }
 
     isolation_level = int(configs['TFM_ISOLATION_LEVEL'], base = 10)
@@ -452,6 +454,9 @@ def process_partition_manifests(manifest_lists, configs):
     if partition_statistics['slih_num'] > 0:
         config_impl['CONFIG_TFM_SLIH_API'] = 1
 
+    config_impl['CONFIG_TFM_SERVICE_NUM'] = process_service_indexes(partition_list)
+    config_impl['CONFIG_TFM_CONN_SLOT_NUM'] = process_connection_slots(partition_list)
+
     context['partitions'] = partition_list
     context['config_impl'] = config_impl
     context['stateless_services'] = process_stateless_services(partition_list)
@@ -543,6 +548,85 @@ def gen_summary_files(context, gen_file_lists):
         outfile.write(template.render(context))
         outfile.close()
 
+def process_service_indexes(partitions):
+    """
+    This function sorts all services by SID, and allocates each service the
+    index of its SID in the sorted list. SPM finds the service of a SID with a
+    binary search of the services placed at their index.
+    Each Partition gets a dependency bitset, where the bit at the index of
+    each service it depends on is set, so that SPM checks the dependencies in
+    constant time. Weak dependencies to services which are not built are
+    skipped.
+
+    Keep the bitset length the same as PARTITION_DEP_BITSET_WORDS in C
+    sources.
+
+    Returns the number of services.
+    """
+
+    collected_services = []
+    service_index_map = {}
+
+    for partition in partitions:
+        collected_services += partition['manifest'].get('services', [])
+
+    collected_services.sort(key = lambda service: int(str(service['sid']), 0))
+
+    for index, service in enumerate(collected_services):
+        service['service_index'] = index
+        service_index_map[service['name']] = index
+
+    PARTITION_DEP_BITSET_WORDS = len(collected_services) // 32 + 1
+
+    for partition in partitions:
+        manifest = partition['manifest']
+        dependencies = manifest.get('dependencies', []) + \
+                       manifest.get('weak_dependencies', [])
+        dependency_bitset = [0] * PARTITION_DEP_BITSET_WORDS
+
+        for dependency in dependencies:
+            if dependency not in service_index_map:
+                continue
+            index = service_index_map[dependency]
+            dependency_bitset[index // 32] |= 1 << (index % 32)
+
+        manifest['dependency_bitset'] = ['0x{0:08x}'.format(word)
+                                         for word in dependency_bitset]
+
+    return str(len(collected_services))
+
+def process_connection_slots(partitions):
+    """
+    This function reserves a connection slot for each Partition which depends
+    on stateless services. A Partition has at most one call in progress, so
+    SPM uses the slot for its stateless calls instead of allocating a
+    connection from the shared pool. The mailbox NS Agent can have several
+    calls in progress, and keeps using the shared pool.
+
+    Returns the number of reserved connection slots.
+    """
+
+    stateless_services = set()
+    slot_num = 0
+
+    for partition in partitions:
+        for service in partition['manifest'].get('services', []):
+            if service['connection_based'] is False:
+                stateless_services.add(service['name'])
+
+    for partition in partitions:
+        manifest = partition['manifest']
+        dependencies = manifest.get('dependencies', []) + \
+                       manifest.get('weak_dependencies', [])
+
+        manifest['conn_slot'] = manifest['ns_agent'] is False and \
+                                any(dependency in stateless_services
+                                    for dependency in dependencies)
+        if manifest['conn_slot']:
+            slot_num += 1
+
+    return str(slot_num)
+
 def process_stateless_services(partitions):
     """
     This function collects all stateless services together, and allocates